@@ -0,0 +1,14 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+/* Engine independent IK math. Only Core is used, for the module boilerplate, so the same sources also build standalone from Source/IKCoreTools. */
+public class IKCore : ModuleRules
+{
+	public IKCore(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Core" });
+	}
+}
@@ -0,0 +1,700 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKCoreBVH.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+#if IKCORE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace IKCore
+{
+	static const uint8_t TriangleSoupMagic[4] = { 'I', 'K', 'T', 'S' };
+
+	/* The most children waiting on the traversal stack. Each level adds at most three, and median splits keep the tree far shallower than this needs. */
+	static const int TraversalStackSize = 128;
+
+	/* Matches SMALL_NUMBER. Triangles with a smaller area, and rays almost parallel to a triangle, are never hit. */
+	static const float SmallNumber = 1.e-8f;
+
+	static float Dot(const Vector3& a, const Vector3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	static float GetAxis(const Vector3& v, int axis)
+	{
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+
+	static Vector3 Min(const Vector3& a, const Vector3& b)
+	{
+		return Vector3(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z));
+	}
+
+	static Vector3 Max(const Vector3& a, const Vector3& b)
+	{
+		return Vector3(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
+	}
+
+	/* Returns the unit normal of a triangle from its edges, or zero if it is degenerate. */
+	static Vector3 GetTriangleNormal(const Vector3& edge1, const Vector3& edge2)
+	{
+		const Vector3 normal = Cross(edge1, edge2);
+		const float lengthSquared = Dot(normal, normal);
+		if (lengthSquared < SmallNumber * SmallNumber) return Vector3();
+		return normal * (1.0f / std::sqrt(lengthSquared));
+	}
+
+	/* Returns one over the value, keeping the sign of values too small to invert so the slab test never multiplies zero by infinity. */
+	static float SafeInverse(float value)
+	{
+		if (std::fabs(value) < 1.e-20f) return value < 0.0f ? -1.e20f : 1.e20f;
+		return 1.0f / value;
+	}
+
+	/* Returns the vertex of a triangle in a soup. */
+	static Vector3 GetVertex(const TriangleSoup& soup, int triangle, int corner)
+	{
+		return soup.vertices[soup.indices[triangle * 3 + corner]];
+	}
+
+	/* Returns the closest point on a triangle to a point. From Real-Time Collision Detection 5.1.5. */
+	static Vector3 ClosestPointOnTriangle(const Vector3& point, const Vector3& a, const Vector3& b, const Vector3& c)
+	{
+		// Check the corner regions, then the edge regions, then it is over the face.
+		const Vector3 ab = b - a;
+		const Vector3 ac = c - a;
+		const Vector3 ap = point - a;
+		const float d1 = Dot(ab, ap);
+		const float d2 = Dot(ac, ap);
+		if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+		const Vector3 bp = point - b;
+		const float d3 = Dot(ab, bp);
+		const float d4 = Dot(ac, bp);
+		if (d3 >= 0.0f && d4 <= d3) return b;
+
+		const float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab * (d1 / (d1 - d3));
+
+		const Vector3 cp = point - c;
+		const float d5 = Dot(ab, cp);
+		const float d6 = Dot(ac, cp);
+		if (d6 >= 0.0f && d5 <= d6) return c;
+
+		const float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac * (d2 / (d2 - d6));
+
+		const float va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+		const float denominator = 1.0f / (va + vb + vc);
+		return a + ab * (vb * denominator) + ac * (vc * denominator);
+	}
+
+	/* Returns true if a point on the plane of a triangle is inside it. */
+	static bool IsPointInTriangle(const Vector3& point, const Vector3& v0, const Vector3& edge1, const Vector3& edge2)
+	{
+		const Vector3 toPoint = point - v0;
+		const float d00 = Dot(edge1, edge1);
+		const float d01 = Dot(edge1, edge2);
+		const float d11 = Dot(edge2, edge2);
+		const float d20 = Dot(toPoint, edge1);
+		const float d21 = Dot(toPoint, edge2);
+		const float denominator = d00 * d11 - d01 * d01;
+		if (denominator == 0.0f) return false;
+		const float v = (d11 * d20 - d01 * d21) / denominator;
+		const float w = (d00 * d21 - d01 * d20) / denominator;
+		return v >= 0.0f && w >= 0.0f && v + w <= 1.0f;
+	}
+
+	/* Finds the first root of a * t^2 + b * t + c = 0 in [0, maxTime), where the moving point enters the shape. */
+	static bool GetEntryRoot(float a, float b, float c, float maxTime, float& outRoot)
+	{
+		const float determinant = b * b - 4.0f * a * c;
+		if (a <= 0.0f || determinant < 0.0f) return false;
+		const float root = (-b - std::sqrt(determinant)) / (2.0f * a);
+		if (root < 0.0f || root >= maxTime) return false;
+		outRoot = root;
+		return true;
+	}
+
+	/* Intersects a ray with both sides of a triangle using Moller-Trumbore. Returns true and the time if it hits in [0, maxTime). */
+	static bool RayTriangle(const Vector3& start, const Vector3& delta, const Vector3& v0, const Vector3& edge1, const Vector3& edge2, float maxTime, float& outTime)
+	{
+		const Vector3 p = Cross(delta, edge2);
+		const float determinant = Dot(edge1, p);
+		if (std::fabs(determinant) < SmallNumber) return false;
+		const float inverseDeterminant = 1.0f / determinant;
+
+		const Vector3 t = start - v0;
+		const float u = Dot(t, p) * inverseDeterminant;
+		if (u < 0.0f || u > 1.0f) return false;
+
+		const Vector3 q = Cross(t, edge1);
+		const float v = Dot(delta, q) * inverseDeterminant;
+		if (v < 0.0f || u + v > 1.0f) return false;
+
+		const float time = Dot(edge2, q) * inverseDeterminant;
+		if (time < 0.0f || time >= maxTime) return false;
+		outTime = time;
+		return true;
+	}
+
+	/* Sweeps a sphere against a triangle. Returns true and the time and point touched if it hits in [0, maxTime).
+	 * From Improved Collision Detection and Response, Fauerby, with the overlap at the start checked first. */
+	static bool SweepSphereTriangle(const Vector3& start, const Vector3& delta, float radius, const Vector3& v0, const Vector3& edge1, const Vector3& edge2, const Vector3& normal, float maxTime, float& outTime, Vector3& outImpact)
+	{
+		// A sphere already touching the triangle hits straight away.
+		const Vector3 v1 = v0 + edge1;
+		const Vector3 v2 = v0 + edge2;
+		const float radiusSquared = radius * radius;
+		const Vector3 closest = ClosestPointOnTriangle(start, v0, v1, v2);
+		const Vector3 toClosest = closest - start;
+		if (Dot(toClosest, toClosest) <= radiusSquared)
+		{
+			outTime = 0.0f;
+			outImpact = closest;
+			return true;
+		}
+
+		// The face is touched where the centre is the radius from its plane, and nothing on the triangle can be touched before that.
+		const float startDistance = Dot(start - v0, normal);
+		const float approach = startDistance >= 0.0f ? -Dot(delta, normal) : Dot(delta, normal);
+		if (approach > 0.0f)
+		{
+			const float time = (std::fabs(startDistance) - radius) / approach;
+			if (time >= 0.0f && time < maxTime)
+			{
+				const Vector3 contact = start + delta * time - normal * (startDistance >= 0.0f ? radius : -radius);
+				if (IsPointInTriangle(contact, v0, edge1, edge2))
+				{
+					outTime = time;
+					outImpact = contact;
+					return true;
+				}
+			}
+		}
+
+		// Otherwise the sphere can only touch a corner or an edge first.
+		bool hit = false;
+		float bestTime = maxTime;
+		const float deltaSquared = Dot(delta, delta);
+		const Vector3 corners[3] = { v0, v1, v2 };
+		for (const Vector3& corner : corners)
+		{
+			const Vector3 fromCorner = start - corner;
+			float time;
+			if (GetEntryRoot(deltaSquared, 2.0f * Dot(delta, fromCorner), Dot(fromCorner, fromCorner) - radiusSquared, bestTime, time))
+			{
+				bestTime = time;
+				outImpact = corner;
+				hit = true;
+			}
+		}
+		for (int i = 0; i < 3; i++)
+		{
+			// Intersect with the infinite cylinder around the edge, keeping the hit if it is between the corners.
+			const Vector3& edgeStart = corners[i];
+			const Vector3 edge = corners[(i + 1) % 3] - edgeStart;
+			const Vector3 fromEdge = start - edgeStart;
+			const float edgeSquared = Dot(edge, edge);
+			const float edgeDotDelta = Dot(edge, delta);
+			const float edgeDotFrom = Dot(edge, fromEdge);
+			const float a = edgeSquared * deltaSquared - edgeDotDelta * edgeDotDelta;
+			if (a <= SmallNumber * edgeSquared * deltaSquared) continue;
+			const float b = 2.0f * (edgeSquared * Dot(delta, fromEdge) - edgeDotDelta * edgeDotFrom);
+			const float c = edgeSquared * (Dot(fromEdge, fromEdge) - radiusSquared) - edgeDotFrom * edgeDotFrom;
+			float time;
+			if (!GetEntryRoot(a, b, c, bestTime, time)) continue;
+			const float along = (edgeDotFrom + edgeDotDelta * time) / edgeSquared;
+			if (along < 0.0f || along > 1.0f) continue;
+			bestTime = time;
+			outImpact = edgeStart + edge * along;
+			hit = true;
+		}
+		if (hit) outTime = bestTime;
+		return hit;
+	}
+
+	/* Fills a hit, turning the triangle normal to face the start of the query. */
+	static void SetHit(FloorHit& outHit, float time, const Vector3& location, const Vector3& impactPoint, const Vector3& normal, const Vector3& start, const Vector3& v0, int triangle)
+	{
+		outHit.time = time;
+		outHit.location = location;
+		outHit.impactPoint = impactPoint;
+		outHit.normal = Dot(start - v0, normal) >= 0.0f ? normal : normal * -1.0f;
+		outHit.triangle = triangle;
+	}
+
+	/* Returns the bounds of a range of triangles in build order. */
+	static void GetRangeBounds(const TriangleSoup& soup, const std::vector<int32_t>& order, int first, int count, Vector3& outMin, Vector3& outMax)
+	{
+		outMin = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+		outMax = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (int i = first; i < first + count; i++)
+		{
+			for (int corner = 0; corner < 3; corner++)
+			{
+				const Vector3 vertex = GetVertex(soup, order[i], corner);
+				outMin = Min(outMin, vertex);
+				outMax = Max(outMax, vertex);
+			}
+		}
+	}
+
+	/* Partially sorts a range of triangles so the first half has the lower centres along the longest axis of the range. */
+	static void SplitRange(const std::vector<Vector3>& centres, std::vector<int32_t>& order, int first, int count)
+	{
+		Vector3 centreMin(FLT_MAX, FLT_MAX, FLT_MAX);
+		Vector3 centreMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (int i = first; i < first + count; i++)
+		{
+			centreMin = Min(centreMin, centres[order[i]]);
+			centreMax = Max(centreMax, centres[order[i]]);
+		}
+		const Vector3 size = centreMax - centreMin;
+		const int axis = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+
+		std::nth_element(order.begin() + first, order.begin() + first + count / 2, order.begin() + first + count,
+			[&centres, axis](int32_t a, int32_t b) { return GetAxis(centres[a], axis) < GetAxis(centres[b], axis); });
+	}
+
+	void TriangleSoup::AddTriangle(const Vector3& a, const Vector3& b, const Vector3& c)
+	{
+		const uint32_t first = (uint32_t)vertices.size();
+		vertices.push_back(a);
+		vertices.push_back(b);
+		vertices.push_back(c);
+		indices.push_back(first);
+		indices.push_back(first + 1);
+		indices.push_back(first + 2);
+	}
+
+	/* Copies bytes to the write position, returning the position after them. */
+	static uint8_t* WriteBytes(uint8_t* write, const void* data, size_t size)
+	{
+		if (size > 0) std::memcpy(write, data, size);
+		return write + size;
+	}
+
+	void WriteTriangleSoup(const TriangleSoup& soup, std::vector<uint8_t>& outData)
+	{
+		const uint32_t numVertices = (uint32_t)soup.vertices.size();
+		const uint32_t numTriangles = (uint32_t)soup.NumTriangles();
+		const size_t vertexBytes = numVertices * sizeof(Vector3);
+		const size_t indexBytes = numTriangles * 3 * sizeof(uint32_t);
+		outData.resize(sizeof(TriangleSoupMagic) + sizeof(uint32_t) * 3 + vertexBytes + indexBytes);
+
+		uint8_t* write = outData.data();
+		write = WriteBytes(write, TriangleSoupMagic, sizeof(TriangleSoupMagic));
+		write = WriteBytes(write, &TriangleSoupVersion, sizeof(TriangleSoupVersion));
+		write = WriteBytes(write, &numVertices, sizeof(numVertices));
+		write = WriteBytes(write, &numTriangles, sizeof(numTriangles));
+		write = WriteBytes(write, soup.vertices.data(), vertexBytes);
+		WriteBytes(write, soup.indices.data(), indexBytes);
+	}
+
+	bool ReadTriangleSoup(const uint8_t* data, size_t size, TriangleSoup& outSoup)
+	{
+		// Check the header.
+		const size_t headerBytes = sizeof(TriangleSoupMagic) + sizeof(uint32_t) * 3;
+		if (size < headerBytes || std::memcmp(data, TriangleSoupMagic, sizeof(TriangleSoupMagic)) != 0) return false;
+		uint32_t header[3];
+		std::memcpy(header, data + sizeof(TriangleSoupMagic), sizeof(header));
+		if (header[0] != TriangleSoupVersion) return false;
+
+		// Check the vertices and indices fit in the data.
+		const uint64_t vertexBytes = (uint64_t)header[1] * sizeof(Vector3);
+		const uint64_t indexBytes = (uint64_t)header[2] * 3 * sizeof(uint32_t);
+		if (headerBytes + vertexBytes + indexBytes != size) return false;
+
+		outSoup.vertices.resize(header[1]);
+		outSoup.indices.resize((size_t)header[2] * 3);
+		if (vertexBytes > 0) std::memcpy(outSoup.vertices.data(), data + headerBytes, (size_t)vertexBytes);
+		if (indexBytes > 0) std::memcpy(outSoup.indices.data(), data + headerBytes + vertexBytes, (size_t)indexBytes);
+
+		// Every index has to point at a vertex.
+		for (uint32_t index : outSoup.indices)
+		{
+			if (index >= header[1]) return false;
+		}
+		return true;
+	}
+
+	bool RayCastTriangles(const TriangleSoup& soup, const Vector3& start, const Vector3& end, FloorHit& outHit)
+	{
+		const Vector3 delta = end - start;
+		bool hit = false;
+		float bestTime = 1.0f;
+		for (int triangle = 0; triangle < soup.NumTriangles(); triangle++)
+		{
+			const Vector3 v0 = GetVertex(soup, triangle, 0);
+			const Vector3 edge1 = GetVertex(soup, triangle, 1) - v0;
+			const Vector3 edge2 = GetVertex(soup, triangle, 2) - v0;
+			float time;
+			if (!RayTriangle(start, delta, v0, edge1, edge2, bestTime, time)) continue;
+
+			const Vector3 location = start + delta * time;
+			SetHit(outHit, time, location, location, GetTriangleNormal(edge1, edge2), start, v0, triangle);
+			bestTime = time;
+			hit = true;
+		}
+		return hit;
+	}
+
+	bool SweepSphereTriangles(const TriangleSoup& soup, const Vector3& start, const Vector3& end, float radius, FloorHit& outHit)
+	{
+		const Vector3 delta = end - start;
+		bool hit = false;
+		float bestTime = 1.0f;
+		for (int triangle = 0; triangle < soup.NumTriangles(); triangle++)
+		{
+			const Vector3 v0 = GetVertex(soup, triangle, 0);
+			const Vector3 edge1 = GetVertex(soup, triangle, 1) - v0;
+			const Vector3 edge2 = GetVertex(soup, triangle, 2) - v0;
+			const Vector3 normal = GetTriangleNormal(edge1, edge2);
+			float time;
+			Vector3 impact;
+			if (!SweepSphereTriangle(start, delta, radius, v0, edge1, edge2, normal, bestTime, time, impact)) continue;
+
+			SetHit(outHit, time, start + delta * time, impact, normal, start, v0, triangle);
+			bestTime = time;
+			hit = true;
+		}
+		return hit;
+	}
+
+	struct FloorBVH::BuildState
+	{
+		const TriangleSoup& soup; /* The soup being built from. */
+		std::vector<Vector3> centres; /* The centre of each triangle. */
+		std::vector<int32_t> order; /* The triangle indices, sorted into leaf order as the ranges are split. */
+	};
+
+	struct FloorBVH::Query
+	{
+		Vector3 start; /* Where the ray or sphere centre starts. */
+		Vector3 delta; /* The end minus the start. */
+		Vector3 inverseDelta; /* One over each axis of the delta for the slab tests. */
+		float radius; /* The sphere radius, zero for a ray. */
+		float maxTime; /* The time of the closest hit so far, or 1 before anything is hit. */
+		FloorHit hit; /* The closest hit so far. */
+		bool hasHit; /* Has anything been hit? */
+	};
+
+	FloorBVH::FloorBVH() : boundsMin(FLT_MAX, FLT_MAX, FLT_MAX), boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX), rootChild(0), numTriangles(0)
+	{
+	}
+
+	void FloorBVH::Build(const TriangleSoup& soup)
+	{
+		nodes.clear();
+		leaves.clear();
+		numTriangles = soup.NumTriangles();
+		rootChild = 0;
+
+		// Find the centre of every triangle to split the ranges by.
+		BuildState state = { soup, std::vector<Vector3>(numTriangles), std::vector<int32_t>(numTriangles) };
+		for (int triangle = 0; triangle < numTriangles; triangle++)
+		{
+			state.centres[triangle] = (GetVertex(soup, triangle, 0) + GetVertex(soup, triangle, 1) + GetVertex(soup, triangle, 2)) * (1.0f / 3.0f);
+			state.order[triangle] = triangle;
+		}
+		GetRangeBounds(soup, state.order, 0, numTriangles, boundsMin, boundsMax);
+		if (numTriangles == 0) return;
+
+		// A full four wide tree has about a third as many nodes and a quarter as many leaves as triangles.
+		nodes.reserve(numTriangles / 3 + 1);
+		leaves.reserve(numTriangles / 2 + 1);
+		rootChild = BuildRange(state, 0, numTriangles);
+	}
+
+	int32_t FloorBVH::BuildRange(BuildState& state, int first, int count)
+	{
+		// Small enough ranges become a leaf, with the unused lanes left degenerate.
+		if (count <= 4)
+		{
+			Leaf leaf;
+			std::memset(&leaf, 0, sizeof(leaf));
+			leaf.numTriangles = count;
+			for (int lane = 0; lane < count; lane++)
+			{
+				const int triangle = state.order[first + lane];
+				const Vector3 v0 = GetVertex(state.soup, triangle, 0);
+				const Vector3 edge1 = GetVertex(state.soup, triangle, 1) - v0;
+				const Vector3 edge2 = GetVertex(state.soup, triangle, 2) - v0;
+				const Vector3 normal = GetTriangleNormal(edge1, edge2);
+				leaf.v0X[lane] = v0.x; leaf.v0Y[lane] = v0.y; leaf.v0Z[lane] = v0.z;
+				leaf.edge1X[lane] = edge1.x; leaf.edge1Y[lane] = edge1.y; leaf.edge1Z[lane] = edge1.z;
+				leaf.edge2X[lane] = edge2.x; leaf.edge2Y[lane] = edge2.y; leaf.edge2Z[lane] = edge2.z;
+				leaf.normalX[lane] = normal.x; leaf.normalY[lane] = normal.y; leaf.normalZ[lane] = normal.z;
+				leaf.triangles[lane] = triangle;
+			}
+			leaves.push_back(leaf);
+			return ~(int32_t)(leaves.size() - 1);
+		}
+
+		// Otherwise split the range in half at the median along its longest axis, then split each half again for four children.
+		const int half = count / 2;
+		SplitRange(state.centres, state.order, first, count);
+		SplitRange(state.centres, state.order, first, half);
+		SplitRange(state.centres, state.order, first + half, count - half);
+		const int childFirsts[4] = { first, first + half / 2, first + half, first + half + (count - half) / 2 };
+		const int childCounts[4] = { half / 2, half - half / 2, (count - half) / 2, count - half - (count - half) / 2 };
+
+		const int32_t nodeIndex = (int32_t)nodes.size();
+		Node emptyNode;
+		std::memset(&emptyNode, 0, sizeof(emptyNode));
+		nodes.push_back(emptyNode);
+		for (int i = 0; i < 4; i++)
+		{
+			Vector3 childMin, childMax;
+			GetRangeBounds(state.soup, state.order, childFirsts[i], childCounts[i], childMin, childMax);
+			const int32_t child = BuildRange(state, childFirsts[i], childCounts[i]);
+
+			// The recursion can grow the nodes, so only take the reference after it.
+			Node& node = nodes[nodeIndex];
+			node.minX[i] = childMin.x; node.minY[i] = childMin.y; node.minZ[i] = childMin.z;
+			node.maxX[i] = childMax.x; node.maxY[i] = childMax.y; node.maxZ[i] = childMax.z;
+			node.children[i] = child;
+		}
+		nodes[nodeIndex].numChildren = 4;
+		return nodeIndex;
+	}
+
+	bool FloorBVH::RayCast(const Vector3& start, const Vector3& end, FloorHit& outHit) const
+	{
+		Query query;
+		query.start = start;
+		query.delta = end - start;
+		query.inverseDelta = Vector3(SafeInverse(query.delta.x), SafeInverse(query.delta.y), SafeInverse(query.delta.z));
+		query.radius = 0.0f;
+		query.maxTime = 1.0f;
+		query.hasHit = false;
+		if (!Traverse(query)) return false;
+		outHit = query.hit;
+		return true;
+	}
+
+	bool FloorBVH::SweepSphere(const Vector3& start, const Vector3& end, float radius, FloorHit& outHit) const
+	{
+		Query query;
+		query.start = start;
+		query.delta = end - start;
+		query.inverseDelta = Vector3(SafeInverse(query.delta.x), SafeInverse(query.delta.y), SafeInverse(query.delta.z));
+		query.radius = radius;
+		query.maxTime = 1.0f;
+		query.hasHit = false;
+		if (!Traverse(query)) return false;
+		outHit = query.hit;
+		return true;
+	}
+
+	bool FloorBVH::Traverse(Query& query) const
+	{
+		if (numTriangles == 0) return false;
+
+		struct StackEntry
+		{
+			int32_t child;
+			float entryTime;
+		};
+		StackEntry stack[TraversalStackSize];
+		int stackSize = 0;
+		stack[stackSize++] = { rootChild, 0.0f };
+
+		while (stackSize > 0)
+		{
+			// Skip children that start beyond a hit found since they were pushed.
+			const StackEntry entry = stack[--stackSize];
+			if (entry.entryTime >= query.maxTime) continue;
+			if (entry.child < 0)
+			{
+				IntersectLeaf(leaves[~entry.child], query);
+				continue;
+			}
+
+			// Push the children hit furthest first so the nearest is tested first and shortens the query for the rest.
+			const Node& node = nodes[entry.child];
+			float entryTimes[4];
+			const int hitMask = IntersectChildren(node, query, entryTimes);
+			StackEntry hitChildren[4];
+			int numHit = 0;
+			for (int i = 0; i < 4; i++)
+			{
+				if (!(hitMask & (1 << i))) continue;
+				int insert = numHit++;
+				while (insert > 0 && hitChildren[insert - 1].entryTime < entryTimes[i])
+				{
+					hitChildren[insert] = hitChildren[insert - 1];
+					insert--;
+				}
+				hitChildren[insert] = { node.children[i], entryTimes[i] };
+			}
+			for (int i = 0; i < numHit; i++) stack[stackSize++] = hitChildren[i];
+		}
+		return query.hasHit;
+	}
+
+	int FloorBVH::IntersectChildren(const Node& node, const Query& query, float* outEntryTimes) const
+	{
+		// Slab test the ray against each box, grown by the radius for a sphere.
+		const int usedMask = (1 << node.numChildren) - 1;
+#if IKCORE_SSE
+		const __m128 radius = _mm_set1_ps(query.radius);
+		const __m128 startX = _mm_set1_ps(query.start.x);
+		const __m128 startY = _mm_set1_ps(query.start.y);
+		const __m128 startZ = _mm_set1_ps(query.start.z);
+		const __m128 inverseX = _mm_set1_ps(query.inverseDelta.x);
+		const __m128 inverseY = _mm_set1_ps(query.inverseDelta.y);
+		const __m128 inverseZ = _mm_set1_ps(query.inverseDelta.z);
+
+		const __m128 minTimeX = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(node.minX), radius), startX), inverseX);
+		const __m128 maxTimeX = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(node.maxX), radius), startX), inverseX);
+		const __m128 minTimeY = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(node.minY), radius), startY), inverseY);
+		const __m128 maxTimeY = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(node.maxY), radius), startY), inverseY);
+		const __m128 minTimeZ = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(node.minZ), radius), startZ), inverseZ);
+		const __m128 maxTimeZ = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(node.maxZ), radius), startZ), inverseZ);
+
+		const __m128 entry = _mm_max_ps(_mm_max_ps(_mm_min_ps(minTimeX, maxTimeX), _mm_min_ps(minTimeY, maxTimeY)), _mm_max_ps(_mm_min_ps(minTimeZ, maxTimeZ), _mm_setzero_ps()));
+		const __m128 exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(minTimeX, maxTimeX), _mm_max_ps(minTimeY, maxTimeY)), _mm_min_ps(_mm_max_ps(minTimeZ, maxTimeZ), _mm_set1_ps(query.maxTime)));
+		_mm_storeu_ps(outEntryTimes, entry);
+		return _mm_movemask_ps(_mm_cmple_ps(entry, exit)) & usedMask;
+#else
+		int hitMask = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			const float minTimeX = (node.minX[i] - query.radius - query.start.x) * query.inverseDelta.x;
+			const float maxTimeX = (node.maxX[i] + query.radius - query.start.x) * query.inverseDelta.x;
+			const float minTimeY = (node.minY[i] - query.radius - query.start.y) * query.inverseDelta.y;
+			const float maxTimeY = (node.maxY[i] + query.radius - query.start.y) * query.inverseDelta.y;
+			const float minTimeZ = (node.minZ[i] - query.radius - query.start.z) * query.inverseDelta.z;
+			const float maxTimeZ = (node.maxZ[i] + query.radius - query.start.z) * query.inverseDelta.z;
+			const float entry = std::max(std::max(std::min(minTimeX, maxTimeX), std::min(minTimeY, maxTimeY)), std::max(std::min(minTimeZ, maxTimeZ), 0.0f));
+			const float exit = std::min(std::min(std::max(minTimeX, maxTimeX), std::max(minTimeY, maxTimeY)), std::min(std::max(minTimeZ, maxTimeZ), query.maxTime));
+			outEntryTimes[i] = entry;
+			if (entry <= exit) hitMask |= 1 << i;
+		}
+		return hitMask & usedMask;
+#endif
+	}
+
+	void FloorBVH::IntersectLeaf(const Leaf& leaf, Query& query) const
+	{
+		const int usedMask = (1 << leaf.numTriangles) - 1;
+		if (query.radius <= 0.0f)
+		{
+			// Moller-Trumbore on every lane at once, the same as RayTriangle.
+			float times[4];
+			int hitMask = 0;
+#if IKCORE_SSE
+			const __m128 deltaX = _mm_set1_ps(query.delta.x);
+			const __m128 deltaY = _mm_set1_ps(query.delta.y);
+			const __m128 deltaZ = _mm_set1_ps(query.delta.z);
+			const __m128 edge1X = _mm_loadu_ps(leaf.edge1X);
+			const __m128 edge1Y = _mm_loadu_ps(leaf.edge1Y);
+			const __m128 edge1Z = _mm_loadu_ps(leaf.edge1Z);
+			const __m128 edge2X = _mm_loadu_ps(leaf.edge2X);
+			const __m128 edge2Y = _mm_loadu_ps(leaf.edge2Y);
+			const __m128 edge2Z = _mm_loadu_ps(leaf.edge2Z);
+
+			const __m128 pX = _mm_sub_ps(_mm_mul_ps(deltaY, edge2Z), _mm_mul_ps(deltaZ, edge2Y));
+			const __m128 pY = _mm_sub_ps(_mm_mul_ps(deltaZ, edge2X), _mm_mul_ps(deltaX, edge2Z));
+			const __m128 pZ = _mm_sub_ps(_mm_mul_ps(deltaX, edge2Y), _mm_mul_ps(deltaY, edge2X));
+			const __m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edge1X, pX), _mm_mul_ps(edge1Y, pY)), _mm_mul_ps(edge1Z, pZ));
+			const __m128 absDeterminant = _mm_andnot_ps(_mm_set1_ps(-0.0f), determinant);
+			const __m128 inverseDeterminant = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+
+			const __m128 tX = _mm_sub_ps(_mm_set1_ps(query.start.x), _mm_loadu_ps(leaf.v0X));
+			const __m128 tY = _mm_sub_ps(_mm_set1_ps(query.start.y), _mm_loadu_ps(leaf.v0Y));
+			const __m128 tZ = _mm_sub_ps(_mm_set1_ps(query.start.z), _mm_loadu_ps(leaf.v0Z));
+			const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tX, pX), _mm_mul_ps(tY, pY)), _mm_mul_ps(tZ, pZ)), inverseDeterminant);
+
+			const __m128 qX = _mm_sub_ps(_mm_mul_ps(tY, edge1Z), _mm_mul_ps(tZ, edge1Y));
+			const __m128 qY = _mm_sub_ps(_mm_mul_ps(tZ, edge1X), _mm_mul_ps(tX, edge1Z));
+			const __m128 qZ = _mm_sub_ps(_mm_mul_ps(tX, edge1Y), _mm_mul_ps(tY, edge1X));
+			const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(deltaX, qX), _mm_mul_ps(deltaY, qY)), _mm_mul_ps(deltaZ, qZ)), inverseDeterminant);
+			const __m128 time = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(edge2X, qX), _mm_mul_ps(edge2Y, qY)), _mm_mul_ps(edge2Z, qZ)), inverseDeterminant);
+
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0f);
+			__m128 valid = _mm_cmpge_ps(absDeterminant, _mm_set1_ps(SmallNumber));
+			valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+			valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+			valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(time, zero), _mm_cmplt_ps(time, _mm_set1_ps(query.maxTime))));
+			_mm_storeu_ps(times, time);
+			hitMask = _mm_movemask_ps(valid) & usedMask;
+#else
+			for (int lane = 0; lane < leaf.numTriangles; lane++)
+			{
+				const Vector3 v0(leaf.v0X[lane], leaf.v0Y[lane], leaf.v0Z[lane]);
+				const Vector3 edge1(leaf.edge1X[lane], leaf.edge1Y[lane], leaf.edge1Z[lane]);
+				const Vector3 edge2(leaf.edge2X[lane], leaf.edge2Y[lane], leaf.edge2Z[lane]);
+				if (RayTriangle(query.start, query.delta, v0, edge1, edge2, query.maxTime, times[lane])) hitMask |= 1 << lane;
+			}
+#endif
+			// Keep the closest lane hit.
+			int closestLane = -1;
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if ((hitMask & (1 << lane)) && times[lane] < query.maxTime)
+				{
+					query.maxTime = times[lane];
+					closestLane = lane;
+				}
+			}
+			if (closestLane < 0) return;
+
+			const Vector3 location = query.start + query.delta * query.maxTime;
+			const Vector3 v0(leaf.v0X[closestLane], leaf.v0Y[closestLane], leaf.v0Z[closestLane]);
+			const Vector3 normal(leaf.normalX[closestLane], leaf.normalY[closestLane], leaf.normalZ[closestLane]);
+			SetHit(query.hit, query.maxTime, location, location, normal, query.start, v0, leaf.triangles[closestLane]);
+			query.hasHit = true;
+			return;
+		}
+
+		// Only sweep the triangles whose plane the sphere reaches, found on every lane at once.
+		int reachMask = usedMask;
+#if IKCORE_SSE
+		const __m128 normalX = _mm_loadu_ps(leaf.normalX);
+		const __m128 normalY = _mm_loadu_ps(leaf.normalY);
+		const __m128 normalZ = _mm_loadu_ps(leaf.normalZ);
+		const __m128 v0X = _mm_loadu_ps(leaf.v0X);
+		const __m128 v0Y = _mm_loadu_ps(leaf.v0Y);
+		const __m128 v0Z = _mm_loadu_ps(leaf.v0Z);
+		const Vector3 end = query.start + query.delta;
+		const __m128 startDistance = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(normalX, _mm_sub_ps(_mm_set1_ps(query.start.x), v0X)),
+			_mm_mul_ps(normalY, _mm_sub_ps(_mm_set1_ps(query.start.y), v0Y))),
+			_mm_mul_ps(normalZ, _mm_sub_ps(_mm_set1_ps(query.start.z), v0Z)));
+		const __m128 endDistance = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(normalX, _mm_sub_ps(_mm_set1_ps(end.x), v0X)),
+			_mm_mul_ps(normalY, _mm_sub_ps(_mm_set1_ps(end.y), v0Y))),
+			_mm_mul_ps(normalZ, _mm_sub_ps(_mm_set1_ps(end.z), v0Z)));
+		const __m128 radius = _mm_set1_ps(query.radius);
+		const __m128 reach = _mm_and_ps(
+			_mm_cmple_ps(_mm_min_ps(startDistance, endDistance), radius),
+			_mm_cmpge_ps(_mm_max_ps(startDistance, endDistance), _mm_sub_ps(_mm_setzero_ps(), radius)));
+		reachMask &= _mm_movemask_ps(reach);
+#endif
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if (!(reachMask & (1 << lane))) continue;
+			const Vector3 v0(leaf.v0X[lane], leaf.v0Y[lane], leaf.v0Z[lane]);
+			const Vector3 edge1(leaf.edge1X[lane], leaf.edge1Y[lane], leaf.edge1Z[lane]);
+			const Vector3 edge2(leaf.edge2X[lane], leaf.edge2Y[lane], leaf.edge2Z[lane]);
+			const Vector3 normal(leaf.normalX[lane], leaf.normalY[lane], leaf.normalZ[lane]);
+			float time;
+			Vector3 impact;
+			if (!SweepSphereTriangle(query.start, query.delta, query.radius, v0, edge1, edge2, normal, query.maxTime, time, impact)) continue;
+
+			SetHit(query.hit, time, query.start + query.delta * time, impact, normal, query.start, v0, leaf.triangles[lane]);
+			query.maxTime = time;
+			query.hasHit = true;
+		}
+	}
+}
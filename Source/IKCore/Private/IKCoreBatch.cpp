@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKCoreBatch.h"
+
+namespace IKCore
+{
+	void SolveHipOffsets(int count, const float* leftFloorZ, const float* rightFloorZ, const float* capsuleBottomZ, float* outHipOffset)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			outHipOffset[i] = HipOffset(leftFloorZ[i], rightFloorZ[i], capsuleBottomZ[i]);
+		}
+	}
+
+	void InterpCapsuleHalfHeights(int count, const float* currentHalfHeight, const float* originalHalfHeight, const float* hipOffset, const float* interpSpeed, float deltaTime, float* outHalfHeight)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			outHalfHeight[i] = InterpTo(currentHalfHeight[i], CapsuleTargetHalfHeight(originalHalfHeight[i], hipOffset[i]), deltaTime, interpSpeed[i]);
+		}
+	}
+
+	void TransformPositionsNoScale(int count, const Quat* rotation, const Vector3* translation, const Vector3* relativePosition, Vector3* outPosition)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			outPosition[i] = TransformPositionNoScale(rotation[i], translation[i], relativePosition[i]);
+		}
+	}
+}
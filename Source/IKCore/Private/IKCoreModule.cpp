@@ -0,0 +1,6 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Modules/ModuleManager.h"
+
+/* Only built by UnrealBuildTool, the standalone build leaves this file out. */
+IMPLEMENT_MODULE(FDefaultModuleImpl, IKCore);
@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKCoreReplay.h"
+#include <cstring>
+
+namespace IKCore
+{
+	static const uint8_t ReplayMagic[4] = { 'I', 'K', 'R', 'P' };
+
+	static bool BitsEqual(float a, float b)
+	{
+		return std::memcmp(&a, &b, sizeof(float)) == 0;
+	}
+
+	static bool BitsEqual(const Vector3& a, const Vector3& b)
+	{
+		return BitsEqual(a.x, b.x) && BitsEqual(a.y, b.y) && BitsEqual(a.z, b.z);
+	}
+
+	void ReplayIK(const ReplayCharacter& character, ReplayFrame& frame)
+	{
+		// The feet go to their floors and the hips drop to the lower one.
+		const float capsuleBottomZ = frame.capsuleLocation.z - frame.capsuleHalfHeight;
+		frame.outLeftFoot = frame.leftFloor;
+		frame.outRightFoot = frame.rightFloor;
+		frame.outHipOffset = HipOffset(frame.leftFloor.z, frame.rightFloor.z, capsuleBottomZ);
+
+		// The capsule moves towards the height that keeps it above the hips.
+		const float targetHalfHeight = CapsuleTargetHalfHeight(character.originalHalfHeight, frame.outHipOffset);
+		frame.outInterpHalfHeight = InterpTo(frame.interpHalfHeight, targetHalfHeight, frame.deltaTime, character.interpSpeed);
+	}
+
+	bool ReplayOutputsMatch(const ReplayFrame& a, const ReplayFrame& b)
+	{
+		return BitsEqual(a.outLeftFoot, b.outLeftFoot) && BitsEqual(a.outRightFoot, b.outRightFoot)
+			&& BitsEqual(a.outHipOffset, b.outHipOffset) && BitsEqual(a.outInterpHalfHeight, b.outInterpHalfHeight);
+	}
+
+	ReplayWriter::ReplayWriter()
+	{
+		Write(ReplayMagic, sizeof(ReplayMagic));
+		Write(&ReplayVersion, sizeof(ReplayVersion));
+	}
+
+	void ReplayWriter::WriteCharacter(const ReplayCharacter& character)
+	{
+		const uint8_t type = (uint8_t)ReplayRecordType::Character;
+		Write(&type, sizeof(type));
+		Write(&character.id, sizeof(character.id));
+		Write(&character.originalHalfHeight, sizeof(character.originalHalfHeight));
+		Write(&character.interpSpeed, sizeof(character.interpSpeed));
+	}
+
+	void ReplayWriter::WriteFrame(const ReplayFrame& frame)
+	{
+		// Field by field so padding never reaches the stream.
+		const uint8_t type = (uint8_t)ReplayRecordType::Frame;
+		Write(&type, sizeof(type));
+		Write(&frame.frame, sizeof(frame.frame));
+		Write(&frame.id, sizeof(frame.id));
+		Write(&frame.deltaTime, sizeof(frame.deltaTime));
+		Write(&frame.forwardAxis, sizeof(frame.forwardAxis));
+		Write(&frame.rightAxis, sizeof(frame.rightAxis));
+		Write(&frame.capsuleRotation, sizeof(frame.capsuleRotation));
+		Write(&frame.capsuleLocation, sizeof(frame.capsuleLocation));
+		Write(&frame.capsuleHalfHeight, sizeof(frame.capsuleHalfHeight));
+		Write(&frame.interpHalfHeight, sizeof(frame.interpHalfHeight));
+		Write(&frame.leftFloor, sizeof(frame.leftFloor));
+		Write(&frame.rightFloor, sizeof(frame.rightFloor));
+		Write(&frame.outLeftFoot, sizeof(frame.outLeftFoot));
+		Write(&frame.outRightFoot, sizeof(frame.outRightFoot));
+		Write(&frame.outHipOffset, sizeof(frame.outHipOffset));
+		Write(&frame.outInterpHalfHeight, sizeof(frame.outInterpHalfHeight));
+	}
+
+	void ReplayWriter::Write(const void* data, size_t size)
+	{
+		const size_t start = buffer.size();
+		buffer.resize(start + size);
+		std::memcpy(buffer.data() + start, data, size);
+	}
+
+	ReplayReader::ReplayReader(const uint8_t* inData, size_t inSize) : data(inData), size(inSize), offset(0), valid(false)
+	{
+		uint8_t magic[4];
+		uint32_t version = 0;
+		valid = Read(magic, sizeof(magic)) && std::memcmp(magic, ReplayMagic, sizeof(magic)) == 0 && Read(&version, sizeof(version)) && version == ReplayVersion;
+	}
+
+	ReplayRecordType ReplayReader::Next(ReplayCharacter& outCharacter, ReplayFrame& outFrame)
+	{
+		uint8_t type = 0;
+		if (!valid || !Read(&type, sizeof(type))) return ReplayRecordType::None;
+
+		switch ((ReplayRecordType)type)
+		{
+		case ReplayRecordType::Character:
+		{
+			bool read = Read(&outCharacter.id, sizeof(outCharacter.id))
+				&& Read(&outCharacter.originalHalfHeight, sizeof(outCharacter.originalHalfHeight))
+				&& Read(&outCharacter.interpSpeed, sizeof(outCharacter.interpSpeed));
+			return read ? ReplayRecordType::Character : ReplayRecordType::None;
+		}
+		case ReplayRecordType::Frame:
+		{
+			bool read = Read(&outFrame.frame, sizeof(outFrame.frame))
+				&& Read(&outFrame.id, sizeof(outFrame.id))
+				&& Read(&outFrame.deltaTime, sizeof(outFrame.deltaTime))
+				&& Read(&outFrame.forwardAxis, sizeof(outFrame.forwardAxis))
+				&& Read(&outFrame.rightAxis, sizeof(outFrame.rightAxis))
+				&& Read(&outFrame.capsuleRotation, sizeof(outFrame.capsuleRotation))
+				&& Read(&outFrame.capsuleLocation, sizeof(outFrame.capsuleLocation))
+				&& Read(&outFrame.capsuleHalfHeight, sizeof(outFrame.capsuleHalfHeight))
+				&& Read(&outFrame.interpHalfHeight, sizeof(outFrame.interpHalfHeight))
+				&& Read(&outFrame.leftFloor, sizeof(outFrame.leftFloor))
+				&& Read(&outFrame.rightFloor, sizeof(outFrame.rightFloor))
+				&& Read(&outFrame.outLeftFoot, sizeof(outFrame.outLeftFoot))
+				&& Read(&outFrame.outRightFoot, sizeof(outFrame.outRightFoot))
+				&& Read(&outFrame.outHipOffset, sizeof(outFrame.outHipOffset))
+				&& Read(&outFrame.outInterpHalfHeight, sizeof(outFrame.outInterpHalfHeight));
+			return read ? ReplayRecordType::Frame : ReplayRecordType::None;
+		}
+		default:
+			return ReplayRecordType::None;
+		}
+	}
+
+	bool ReplayReader::Read(void* outData, size_t readSize)
+	{
+		if (size - offset < readSize) return false;
+		std::memcpy(outData, data + offset, readSize);
+		offset += readSize;
+		return true;
+	}
+}
@@ -0,0 +1,304 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKCoreTwoBone.h"
+
+#if IKCORE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace IKCore
+{
+	/* Matches KINDA_SMALL_NUMBER and SMALL_NUMBER. */
+	static const float KindaSmallNumber = 1.e-4f;
+	static const float SmallNumber = 1.e-8f;
+
+	static float Dot(const Vector3& a, const Vector3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	/* Returns the vector normalised, or zero if it is too short, matching FVector::GetSafeNormal. */
+	static Vector3 GetSafeNormal(const Vector3& v)
+	{
+		const float lengthSquared = Dot(v, v);
+		if (lengthSquared == 1.0f) return v;
+		if (lengthSquared < SmallNumber) return Vector3();
+		return v * (1.0f / std::sqrt(lengthSquared));
+	}
+
+	/* Finds two axis perpendicular to the direction and each other, matching FVector::FindBestAxisVectors. */
+	static void FindBestAxisVectors(const Vector3& direction, Vector3& outAxis1, Vector3& outAxis2)
+	{
+		const float absX = std::fabs(direction.x);
+		const float absY = std::fabs(direction.y);
+		const float absZ = std::fabs(direction.z);
+		outAxis1 = absZ > absX && absZ > absY ? Vector3(1.0f, 0.0f, 0.0f) : Vector3(0.0f, 0.0f, 1.0f);
+		outAxis1 = GetSafeNormal(outAxis1 - direction * Dot(outAxis1, direction));
+		outAxis2 = Cross(outAxis1, direction);
+	}
+
+	void TwoBoneBatch::Resize(int count)
+	{
+		for (std::vector<float>* field : { &rootX, &rootY, &rootZ, &jointX, &jointY, &jointZ, &endX, &endY, &endZ,
+			&jointTargetX, &jointTargetY, &jointTargetZ, &effectorX, &effectorY, &effectorZ, &upperLength, &lowerLength, &hipOffset,
+			&outJointX, &outJointY, &outJointZ, &outEndX, &outEndY, &outEndZ,
+			&upperRotationX, &upperRotationY, &upperRotationZ, &upperRotationW, &lowerRotationX, &lowerRotationY, &lowerRotationZ, &lowerRotationW })
+		{
+			field->resize(count);
+		}
+	}
+
+	void TwoBoneBatch::SetLeg(int index, const Vector3& root, const Vector3& joint, const Vector3& end, const Vector3& jointTarget, const Vector3& effector, float legHipOffset)
+	{
+		rootX[index] = root.x; rootY[index] = root.y; rootZ[index] = root.z;
+		jointX[index] = joint.x; jointY[index] = joint.y; jointZ[index] = joint.z;
+		endX[index] = end.x; endY[index] = end.y; endZ[index] = end.z;
+		jointTargetX[index] = jointTarget.x; jointTargetY[index] = jointTarget.y; jointTargetZ[index] = jointTarget.z;
+		effectorX[index] = effector.x; effectorY[index] = effector.y; effectorZ[index] = effector.z;
+		const Vector3 upper = joint - root;
+		const Vector3 lower = end - joint;
+		upperLength[index] = std::sqrt(Dot(upper, upper));
+		lowerLength[index] = std::sqrt(Dot(lower, lower));
+		hipOffset[index] = legHipOffset;
+	}
+
+	void SolveTwoBoneIK(const Vector3& root, const Vector3& jointTarget, const Vector3& effector, float upperLength, float lowerLength, Vector3& outJoint, Vector3& outEnd)
+	{
+		// The direction to reach in.
+		const Vector3 desiredDelta = effector - root;
+		float desiredLength = std::sqrt(Dot(desiredDelta, desiredDelta));
+		Vector3 desiredDir;
+		if (desiredLength < KindaSmallNumber)
+		{
+			desiredLength = KindaSmallNumber;
+			desiredDir = Vector3(1.0f, 0.0f, 0.0f);
+		}
+		else desiredDir = GetSafeNormal(desiredDelta);
+
+		// The direction to bend the joint in, perpendicular to the reach.
+		const Vector3 jointTargetDelta = jointTarget - root;
+		Vector3 jointPlaneNormal, jointBendDir;
+		if (Dot(jointTargetDelta, jointTargetDelta) < KindaSmallNumber * KindaSmallNumber)
+		{
+			jointBendDir = Vector3(0.0f, 1.0f, 0.0f);
+			jointPlaneNormal = Vector3(0.0f, 0.0f, 1.0f);
+		}
+		else
+		{
+			jointPlaneNormal = Cross(desiredDir, jointTargetDelta);
+			if (Dot(jointPlaneNormal, jointPlaneNormal) < KindaSmallNumber * KindaSmallNumber) FindBestAxisVectors(desiredDir, jointPlaneNormal, jointBendDir);
+			else jointBendDir = GetSafeNormal(jointTargetDelta - desiredDir * Dot(jointTargetDelta, desiredDir));
+		}
+
+		// Out of reach fully extends the chain towards the effector.
+		const float maxLength = upperLength + lowerLength;
+		if (desiredLength >= maxLength)
+		{
+			outEnd = root + desiredDir * maxLength;
+			outJoint = root + desiredDir * upperLength;
+			return;
+		}
+
+		// Otherwise place the joint from the angle between the reach and the upper bone, from the cosine rule.
+		const float twoAB = 2.0f * upperLength * desiredLength;
+		float cosAngle = twoAB != 0.0f ? (upperLength * upperLength + desiredLength * desiredLength - lowerLength * lowerLength) / twoAB : 0.0f;
+		cosAngle = cosAngle < -1.0f ? -1.0f : (cosAngle > 1.0f ? 1.0f : cosAngle);
+		const float jointLineDist = upperLength * std::sqrt(1.0f - cosAngle * cosAngle);
+		const float projJointDist = upperLength * cosAngle;
+		outJoint = root + desiredDir * projJointDist + jointBendDir * jointLineDist;
+		outEnd = effector;
+	}
+
+	Quat FindBetweenNormals(const Vector3& a, const Vector3& b)
+	{
+		float w = 1.0f + Dot(a, b);
+		Quat result;
+		if (w >= 1.e-6f) result = Quat(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x, w);
+		else result = std::fabs(a.x) > std::fabs(a.y) ? Quat(-a.z, 0.0f, a.x, 0.0f) : Quat(0.0f, -a.z, a.y, 0.0f);
+
+		// Normalise.
+		const float sizeSquared = result.x * result.x + result.y * result.y + result.z * result.z + result.w * result.w;
+		if (sizeSquared < SmallNumber) return Quat();
+		const float scale = 1.0f / std::sqrt(sizeSquared);
+		return Quat(result.x * scale, result.y * scale, result.z * scale, result.w * scale);
+	}
+
+	/* Solves a single leg of the batch. */
+	static void SolveLeg(TwoBoneBatch& batch, int i)
+	{
+		// Move the whole leg with the hips.
+		const Vector3 root(batch.rootX[i], batch.rootY[i], batch.rootZ[i] + batch.hipOffset[i]);
+		const Vector3 joint(batch.jointX[i], batch.jointY[i], batch.jointZ[i] + batch.hipOffset[i]);
+		const Vector3 end(batch.endX[i], batch.endY[i], batch.endZ[i] + batch.hipOffset[i]);
+		const Vector3 jointTarget(batch.jointTargetX[i], batch.jointTargetY[i], batch.jointTargetZ[i]);
+		const Vector3 effector(batch.effectorX[i], batch.effectorY[i], batch.effectorZ[i]);
+
+		Vector3 outJoint, outEnd;
+		SolveTwoBoneIK(root, jointTarget, effector, batch.upperLength[i], batch.lowerLength[i], outJoint, outEnd);
+		batch.outJointX[i] = outJoint.x; batch.outJointY[i] = outJoint.y; batch.outJointZ[i] = outJoint.z;
+		batch.outEndX[i] = outEnd.x; batch.outEndY[i] = outEnd.y; batch.outEndZ[i] = outEnd.z;
+
+		// Rotate each bone from its animated direction to its solved one.
+		const Quat upperRotation = FindBetweenNormals(GetSafeNormal(joint - root), GetSafeNormal(outJoint - root));
+		const Quat lowerRotation = FindBetweenNormals(GetSafeNormal(end - joint), GetSafeNormal(outEnd - outJoint));
+		batch.upperRotationX[i] = upperRotation.x; batch.upperRotationY[i] = upperRotation.y; batch.upperRotationZ[i] = upperRotation.z; batch.upperRotationW[i] = upperRotation.w;
+		batch.lowerRotationX[i] = lowerRotation.x; batch.lowerRotationY[i] = lowerRotation.y; batch.lowerRotationZ[i] = lowerRotation.z; batch.lowerRotationW[i] = lowerRotation.w;
+	}
+
+	void SolveTwoBoneBatchScalar(TwoBoneBatch& batch)
+	{
+		const int count = batch.Num();
+		for (int i = 0; i < count; i++) SolveLeg(batch, i);
+	}
+
+#if IKCORE_SSE
+	/* Four 3D vectors, one per lane. */
+	struct Vector4x3
+	{
+		__m128 x, y, z;
+	};
+
+	static inline Vector4x3 Load(const std::vector<float>& x, const std::vector<float>& y, const std::vector<float>& z, int i)
+	{
+		return { _mm_loadu_ps(&x[i]), _mm_loadu_ps(&y[i]), _mm_loadu_ps(&z[i]) };
+	}
+
+	static inline void Store(const Vector4x3& v, std::vector<float>& x, std::vector<float>& y, std::vector<float>& z, int i)
+	{
+		_mm_storeu_ps(&x[i], v.x);
+		_mm_storeu_ps(&y[i], v.y);
+		_mm_storeu_ps(&z[i], v.z);
+	}
+
+	static inline Vector4x3 Add(const Vector4x3& a, const Vector4x3& b) { return { _mm_add_ps(a.x, b.x), _mm_add_ps(a.y, b.y), _mm_add_ps(a.z, b.z) }; }
+	static inline Vector4x3 Sub(const Vector4x3& a, const Vector4x3& b) { return { _mm_sub_ps(a.x, b.x), _mm_sub_ps(a.y, b.y), _mm_sub_ps(a.z, b.z) }; }
+	static inline Vector4x3 Mul(const Vector4x3& a, __m128 s) { return { _mm_mul_ps(a.x, s), _mm_mul_ps(a.y, s), _mm_mul_ps(a.z, s) }; }
+	static inline __m128 Dot(const Vector4x3& a, const Vector4x3& b) { return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z)); }
+	static inline __m128 Select(__m128 mask, __m128 a, __m128 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+	static inline Vector4x3 Select(__m128 mask, const Vector4x3& a, const Vector4x3& b) { return { Select(mask, a.x, b.x), Select(mask, a.y, b.y), Select(mask, a.z, b.z) }; }
+
+	static inline Vector4x3 Cross(const Vector4x3& a, const Vector4x3& b)
+	{
+		return { _mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y)), _mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(a.x, b.z)), _mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(a.y, b.x)) };
+	}
+
+	/* Normalises each lane, leaving zero where the vector is too short, matching GetSafeNormal. */
+	static inline Vector4x3 SafeNormal(const Vector4x3& v)
+	{
+		const __m128 lengthSquared = Dot(v, v);
+		const __m128 valid = _mm_cmpge_ps(lengthSquared, _mm_set1_ps(SmallNumber));
+		const __m128 scale = _mm_and_ps(valid, _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(lengthSquared, _mm_set1_ps(SmallNumber)))));
+		return Mul(v, scale);
+	}
+
+	/* Finds the rotation between the normals in each lane and stores it, matching FindBetweenNormals. */
+	static inline void StoreBetweenNormals(const Vector4x3& a, const Vector4x3& b, std::vector<float>& outX, std::vector<float>& outY, std::vector<float>& outZ, std::vector<float>& outW, int i)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 w = _mm_add_ps(_mm_set1_ps(1.0f), Dot(a, b));
+		const Vector4x3 axis = Cross(a, b);
+
+		// Opposite normals rotate half way round an axis perpendicular to the first.
+		const __m128 opposite = _mm_cmplt_ps(w, _mm_set1_ps(1.e-6f));
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 useX = _mm_cmpgt_ps(_mm_andnot_ps(signMask, a.x), _mm_andnot_ps(signMask, a.y));
+		const __m128 negZ = _mm_xor_ps(a.z, signMask);
+		Vector4x3 oppositeAxis = { Select(useX, negZ, zero), Select(useX, zero, negZ), Select(useX, a.x, a.y) };
+
+		Vector4x3 q = Select(opposite, oppositeAxis, axis);
+		__m128 qw = Select(opposite, zero, w);
+
+		// Normalise, leaving identity where the rotation is too small.
+		const __m128 sizeSquared = _mm_add_ps(Dot(q, q), _mm_mul_ps(qw, qw));
+		const __m128 valid = _mm_cmpge_ps(sizeSquared, _mm_set1_ps(SmallNumber));
+		const __m128 scale = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(sizeSquared, _mm_set1_ps(SmallNumber))));
+		q = Mul(q, _mm_and_ps(valid, scale));
+		qw = Select(valid, _mm_mul_ps(qw, scale), _mm_set1_ps(1.0f));
+		Store(q, outX, outY, outZ, i);
+		_mm_storeu_ps(&outW[i], qw);
+	}
+
+	/* Solves four legs from index i. Returns a bit per lane that needs the scalar solve instead. */
+	static int SolveLegs4(TwoBoneBatch& batch, int i)
+	{
+		const __m128 zero = _mm_setzero_ps();
+
+		// Move the whole leg with the hips.
+		const __m128 hipOffset = _mm_loadu_ps(&batch.hipOffset[i]);
+		Vector4x3 root = Load(batch.rootX, batch.rootY, batch.rootZ, i);
+		Vector4x3 joint = Load(batch.jointX, batch.jointY, batch.jointZ, i);
+		Vector4x3 end = Load(batch.endX, batch.endY, batch.endZ, i);
+		root.z = _mm_add_ps(root.z, hipOffset);
+		joint.z = _mm_add_ps(joint.z, hipOffset);
+		end.z = _mm_add_ps(end.z, hipOffset);
+		const Vector4x3 jointTarget = Load(batch.jointTargetX, batch.jointTargetY, batch.jointTargetZ, i);
+		const Vector4x3 effector = Load(batch.effectorX, batch.effectorY, batch.effectorZ, i);
+		const __m128 upperLength = _mm_loadu_ps(&batch.upperLength[i]);
+		const __m128 lowerLength = _mm_loadu_ps(&batch.lowerLength[i]);
+
+		// The direction to reach in.
+		const Vector4x3 desiredDelta = Sub(effector, root);
+		const __m128 desiredLength = _mm_sqrt_ps(Dot(desiredDelta, desiredDelta));
+		const Vector4x3 desiredDir = SafeNormal(desiredDelta);
+
+		// The direction to bend the joint in, perpendicular to the reach.
+		const Vector4x3 jointTargetDelta = Sub(jointTarget, root);
+		const Vector4x3 jointPlaneNormal = Cross(desiredDir, jointTargetDelta);
+		const Vector4x3 jointBendDir = SafeNormal(Sub(jointTargetDelta, Mul(desiredDir, Dot(jointTargetDelta, desiredDir))));
+
+		// Lanes with no reach direction or no bend plane take the scalar fallbacks.
+		const __m128 smallSquared = _mm_set1_ps(KindaSmallNumber * KindaSmallNumber);
+		__m128 degenerate = _mm_cmplt_ps(desiredLength, _mm_set1_ps(KindaSmallNumber));
+		degenerate = _mm_or_ps(degenerate, _mm_cmplt_ps(Dot(jointTargetDelta, jointTargetDelta), smallSquared));
+		degenerate = _mm_or_ps(degenerate, _mm_cmplt_ps(Dot(jointPlaneNormal, jointPlaneNormal), smallSquared));
+
+		// Place the joint from the angle between the reach and the upper bone, from the cosine rule.
+		const __m128 twoAB = _mm_mul_ps(_mm_set1_ps(2.0f), _mm_mul_ps(upperLength, desiredLength));
+		const __m128 cosNumerator = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(upperLength, upperLength), _mm_mul_ps(desiredLength, desiredLength)), _mm_mul_ps(lowerLength, lowerLength));
+		__m128 cosAngle = _mm_and_ps(_mm_cmpneq_ps(twoAB, zero), _mm_div_ps(cosNumerator, _mm_max_ps(twoAB, _mm_set1_ps(SmallNumber))));
+		cosAngle = _mm_min_ps(_mm_max_ps(cosAngle, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+		const __m128 jointLineDist = _mm_mul_ps(upperLength, _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(cosAngle, cosAngle)), zero)));
+		const __m128 projJointDist = _mm_mul_ps(upperLength, cosAngle);
+		Vector4x3 outJoint = Add(root, Add(Mul(desiredDir, projJointDist), Mul(jointBendDir, jointLineDist)));
+		Vector4x3 outEnd = effector;
+
+		// Out of reach fully extends the chain towards the effector.
+		const __m128 maxLength = _mm_add_ps(upperLength, lowerLength);
+		const __m128 outOfReach = _mm_cmpge_ps(desiredLength, maxLength);
+		outJoint = Select(outOfReach, Add(root, Mul(desiredDir, upperLength)), outJoint);
+		outEnd = Select(outOfReach, Add(root, Mul(desiredDir, maxLength)), outEnd);
+		Store(outJoint, batch.outJointX, batch.outJointY, batch.outJointZ, i);
+		Store(outEnd, batch.outEndX, batch.outEndY, batch.outEndZ, i);
+
+		// Rotate each bone from its animated direction to its solved one.
+		StoreBetweenNormals(SafeNormal(Sub(joint, root)), SafeNormal(Sub(outJoint, root)), batch.upperRotationX, batch.upperRotationY, batch.upperRotationZ, batch.upperRotationW, i);
+		StoreBetweenNormals(SafeNormal(Sub(end, joint)), SafeNormal(Sub(outEnd, outJoint)), batch.lowerRotationX, batch.lowerRotationY, batch.lowerRotationZ, batch.lowerRotationW, i);
+
+		return _mm_movemask_ps(degenerate);
+	}
+#endif
+
+	void SolveTwoBoneBatch(TwoBoneBatch& batch)
+	{
+		const int count = batch.Num();
+		int i = 0;
+#if IKCORE_SSE
+		for (; i + 4 <= count; i += 4)
+		{
+			const int degenerateLanes = SolveLegs4(batch, i);
+			if (degenerateLanes == 0) continue;
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (degenerateLanes & (1 << lane)) SolveLeg(batch, i + lane);
+			}
+		}
+#endif
+		// The remainder, or everything without SSE.
+		for (; i < count; i++) SolveLeg(batch, i);
+	}
+
+	bool IsTwoBoneBatchVectorised()
+	{
+		return IKCORE_SSE != 0;
+	}
+}
@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "IKCoreMath.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Floor queries against level collision exported as a triangle soup, so foot traces can run without the engine or its physics scene.
+ * Soup file: the 4 byte magic "IKTS", a uint32 version, a uint32 vertex count and a uint32 triangle count,
+ * then each vertex as three floats and each triangle as three uint32 vertex indices, little endian like the replay stream. */
+namespace IKCore
+{
+	/* The version of the soup file written. Files of another version are not read. */
+	static const uint32_t TriangleSoupVersion = 1;
+
+	/* World space triangles with no other data, as exported from a levels collision. */
+	struct IKCORE_API TriangleSoup
+	{
+		std::vector<Vector3> vertices; /* Every vertex position. */
+		std::vector<uint32_t> indices; /* Three vertex indices per triangle. */
+
+		/* Returns the number of triangles in the soup. */
+		int NumTriangles() const { return (int)(indices.size() / 3); }
+
+		/* Adds a triangle with its own three vertices. */
+		void AddTriangle(const Vector3& a, const Vector3& b, const Vector3& c);
+	};
+
+	/* Writes a soup into the file format. */
+	IKCORE_API void WriteTriangleSoup(const TriangleSoup& soup, std::vector<uint8_t>& outData);
+
+	/* Reads a soup from the file format. Returns false if the data is not a valid soup. */
+	IKCORE_API bool ReadTriangleSoup(const uint8_t* data, size_t size, TriangleSoup& outSoup);
+
+	/* The closest hit of a floor query, matching the fields of FHitResult it is converted to. */
+	struct FloorHit
+	{
+		float time; /* How far along the query the hit is, from 0 at the start to 1 at the end. */
+		Vector3 location; /* The ray position or sphere centre at the hit. */
+		Vector3 impactPoint; /* The point on the triangle that was hit. */
+		Vector3 normal; /* The triangle normal, facing the start of the query. */
+		int triangle; /* The index of the triangle hit in the soup. */
+
+		FloorHit() : time(1.0f), triangle(-1) {}
+	};
+
+	/* Finds the closest triangle a ray or sphere moving from start to end hits, testing every triangle.
+	 * The reference the BVH queries are checked against. A sphere already touching a triangle at the start hits at time 0. */
+	IKCORE_API bool RayCastTriangles(const TriangleSoup& soup, const Vector3& start, const Vector3& end, FloorHit& outHit);
+	IKCORE_API bool SweepSphereTriangles(const TriangleSoup& soup, const Vector3& start, const Vector3& end, float radius, FloorHit& outHit);
+
+	/* A four wide bounding volume hierarchy over a triangle soup. Each node tests its four child boxes at once,
+	 * and each leaf holds up to four triangles tested at once, both with SSE where available. */
+	class IKCORE_API FloorBVH
+	{
+	public:
+
+		/* Constructor, empty until built. */
+		FloorBVH();
+
+		/* Builds the hierarchy over a soup, replacing anything built before. The triangles are copied into the leaves so the soup does not need to outlive the BVH. */
+		void Build(const TriangleSoup& soup);
+
+		/* Returns the number of triangles and nodes built. */
+		int NumTriangles() const { return numTriangles; }
+		int NumNodes() const { return (int)nodes.size(); }
+
+		/* Returns the bounds of every triangle, which are invalid with min above max when empty. */
+		const Vector3& GetBoundsMin() const { return boundsMin; }
+		const Vector3& GetBoundsMax() const { return boundsMax; }
+
+		/* Finds the closest triangle a ray from start to end hits. */
+		bool RayCast(const Vector3& start, const Vector3& end, FloorHit& outHit) const;
+
+		/* Finds the closest triangle a sphere moving from start to end hits. A sphere already touching a triangle at the start hits at time 0. */
+		bool SweepSphere(const Vector3& start, const Vector3& end, float radius, FloorHit& outHit) const;
+
+	private:
+
+		/* An inner node, with the bounds of its children stored as a structure of arrays. */
+		struct Node
+		{
+			float minX[4], minY[4], minZ[4]; /* The minimum corner of each childs bounds. */
+			float maxX[4], maxY[4], maxZ[4]; /* The maximum corner of each childs bounds. */
+			int32_t children[4]; /* An inner node index, or the bitwise not of a leaf index when negative. */
+			int32_t numChildren; /* How many of the children are used, always the first ones. */
+		};
+
+		/* A leaf of up to four triangles, stored as a structure of arrays. Unused lanes are degenerate and never hit. */
+		struct Leaf
+		{
+			float v0X[4], v0Y[4], v0Z[4]; /* The first vertex. */
+			float edge1X[4], edge1Y[4], edge1Z[4]; /* The second vertex minus the first. */
+			float edge2X[4], edge2Y[4], edge2Z[4]; /* The third vertex minus the first. */
+			float normalX[4], normalY[4], normalZ[4]; /* The unit normal, zero for degenerate triangles. */
+			int32_t triangles[4]; /* The index of each triangle in the soup. */
+			int32_t numTriangles; /* How many of the lanes are used, always the first ones. */
+		};
+
+		/* The triangle order and centres used while building. */
+		struct BuildState;
+
+		/* A query shared by the traversal, a ray when the radius is zero. */
+		struct Query;
+
+		/* Makes a leaf of a range of up to four triangles, or an inner node splitting the range into up to four children it recurses into. Returns the child to store in the parent. */
+		int32_t BuildRange(BuildState& state, int first, int count);
+
+		/* Walks the hierarchy nearest child first, testing the leaves the query reaches. */
+		bool Traverse(Query& query) const;
+
+		/* Tests the query against the four child bounds of a node, writing the entry time of each child hit. Returns a bit mask of the children hit. */
+		int IntersectChildren(const Node& node, const Query& query, float* outEntryTimes) const;
+
+		/* Tests the query against the triangles of a leaf, storing the hit if it is closer. */
+		void IntersectLeaf(const Leaf& leaf, Query& query) const;
+
+	private:
+
+		std::vector<Node> nodes; /* The inner nodes, the root first. */
+		std::vector<Leaf> leaves; /* The triangles of every leaf. */
+		Vector3 boundsMin, boundsMax; /* The bounds of every triangle. */
+		int32_t rootChild; /* The child the traversal starts from, a leaf when there are four triangles or less. */
+		int numTriangles; /* The number of triangles built. */
+	};
+}
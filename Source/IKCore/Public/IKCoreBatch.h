@@ -0,0 +1,18 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "IKCoreMath.h"
+
+/* The IK math run over a batch of characters at once. Every argument is one array per field with an entry per character,
+ * so each loop only touches the data it needs. */
+namespace IKCore
+{
+	/* Finds the hip offset of each character from the floor under each of its feet. */
+	IKCORE_API void SolveHipOffsets(int count, const float* leftFloorZ, const float* rightFloorZ, const float* capsuleBottomZ, float* outHipOffset);
+
+	/* Moves each capsule half height towards the height that keeps the capsule above its hips. */
+	IKCORE_API void InterpCapsuleHalfHeights(int count, const float* currentHalfHeight, const float* originalHalfHeight, const float* hipOffset, const float* interpSpeed, float deltaTime, float* outHalfHeight);
+
+	/* Transforms a position relative to each character into world space, ignoring scale. Used for the default feet positions. */
+	IKCORE_API void TransformPositionsNoScale(int count, const Quat* rotation, const Vector3* translation, const Vector3* relativePosition, Vector3* outPosition);
+}
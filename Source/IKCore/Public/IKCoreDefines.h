@@ -0,0 +1,15 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/* Defined by UnrealBuildTool when built as a module, empty when built standalone. */
+#ifndef IKCORE_API
+#define IKCORE_API
+#endif
+
+/* Are the vectorised paths built with SSE? */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IKCORE_SSE 1
+#else
+#define IKCORE_SSE 0
+#endif
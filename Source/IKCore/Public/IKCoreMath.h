@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "IKCoreDefines.h"
+#include <cmath>
+
+/* Plain C++ IK math shared by the game and the standalone tools. Nothing in here may depend on the engine. */
+namespace IKCore
+{
+	/* A 3D vector laid out the same as FVector. */
+	struct Vector3
+	{
+		float x, y, z;
+
+		Vector3() : x(0.0f), y(0.0f), z(0.0f) {}
+		Vector3(float inX, float inY, float inZ) : x(inX), y(inY), z(inZ) {}
+
+		Vector3 operator+(const Vector3& other) const { return Vector3(x + other.x, y + other.y, z + other.z); }
+		Vector3 operator-(const Vector3& other) const { return Vector3(x - other.x, y - other.y, z - other.z); }
+		Vector3 operator*(float scale) const { return Vector3(x * scale, y * scale, z * scale); }
+	};
+
+	/* A rotation quaternion laid out the same as FQuat. */
+	struct Quat
+	{
+		float x, y, z, w;
+
+		Quat() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
+		Quat(float inX, float inY, float inZ, float inW) : x(inX), y(inY), z(inZ), w(inW) {}
+	};
+
+	/* Returns the cross product of two vectors. */
+	inline Vector3 Cross(const Vector3& a, const Vector3& b)
+	{
+		return Vector3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+
+	/* Rotates a vector by a quaternion, matching FQuat::RotateVector. */
+	inline Vector3 RotateVector(const Quat& rotation, const Vector3& v)
+	{
+		const Vector3 q(rotation.x, rotation.y, rotation.z);
+		const Vector3 t = Cross(q, v) * 2.0f;
+		return v + t * rotation.w + Cross(q, t);
+	}
+
+	/* Transforms a position by a rotation and translation ignoring scale, matching FTransform::TransformPositionNoScale. */
+	inline Vector3 TransformPositionNoScale(const Quat& rotation, const Vector3& translation, const Vector3& position)
+	{
+		return RotateVector(rotation, position) + translation;
+	}
+
+	/* Moves current towards target at the given speed, matching FMath::FInterpTo. */
+	inline float InterpTo(float current, float target, float deltaTime, float interpSpeed)
+	{
+		// No speed snaps to the target.
+		if (interpSpeed <= 0.0f) return target;
+
+		// Close enough snaps to the target.
+		const float distance = target - current;
+		if (distance * distance < 1.e-8f) return target;
+
+		float alpha = deltaTime * interpSpeed;
+		alpha = alpha < 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha);
+		return current + distance * alpha;
+	}
+
+	/* Returns how far the hips must drop for the lower foot to reach its floor from the bottom of the capsule. */
+	inline float HipOffset(float leftFloorZ, float rightFloorZ, float capsuleBottomZ)
+	{
+		const float lowerFloorZ = leftFloorZ < rightFloorZ ? leftFloorZ : rightFloorZ;
+		return -std::fabs(std::fabs(lowerFloorZ) - std::fabs(capsuleBottomZ));
+	}
+
+	/* Returns the capsule half height that keeps the capsule above the dropped hips. */
+	inline float CapsuleTargetHalfHeight(float originalHalfHeight, float hipOffset)
+	{
+		return originalHalfHeight - std::fabs(hipOffset) * 0.5f;
+	}
+}
@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "IKCoreMath.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Record and replay of the IK pipeline. The game records each characters IK inputs and outputs per frame into a binary stream,
+ * and the same stream is fed back through the IK math with no physics or rendering to check and time it.
+ * Stream: the 4 byte magic "IKRP" and a uint32 version, then records each starting with a ReplayRecordType byte.
+ * Values are written raw in the byte order of the machine that recorded them, which is little endian on every target. */
+namespace IKCore
+{
+	/* The version of the stream written. Streams of another version are not read. */
+	static const uint32_t ReplayVersion = 1;
+
+	/* The types of record in a stream. */
+	enum class ReplayRecordType : uint8_t
+	{
+		None,		/* The end of the stream, or a stream that could not be read. */
+		Character,	/* The settings of a character, written before its first frame. */
+		Frame		/* One characters IK update in a frame. */
+	};
+
+	/* The settings of a recorded character that do not change between frames. */
+	struct ReplayCharacter
+	{
+		uint32_t id; /* Identifies the character within the stream. */
+		float originalHalfHeight; /* The capsule half height with no hip offset. */
+		float interpSpeed; /* How fast the capsule half height moves towards its target. */
+
+		ReplayCharacter() : id(0), originalHalfHeight(0.0f), interpSpeed(0.0f) {}
+	};
+
+	/* A characters IK inputs and the outputs the game produced from them for a frame. */
+	struct ReplayFrame
+	{
+		uint32_t frame; /* The frame number it was recorded in. */
+		uint32_t id; /* The character it belongs to. */
+		float deltaTime; /* The world delta time. */
+		float forwardAxis, rightAxis; /* The movement input. */
+		Quat capsuleRotation; /* The capsule world rotation. */
+		Vector3 capsuleLocation; /* The capsule world location. */
+		float capsuleHalfHeight; /* The scaled capsule half height before the update. */
+		float interpHalfHeight; /* The interpolated capsule half height the update starts from. */
+		Vector3 leftFloor, rightFloor; /* The floor locations found under each foot. */
+
+		Vector3 outLeftFoot, outRightFoot; /* The foot locations given to the anim instance. */
+		float outHipOffset; /* The hip offset given to the anim instance. */
+		float outInterpHalfHeight; /* The interpolated capsule half height after the update. */
+
+		ReplayFrame() : frame(0), id(0), deltaTime(0.0f), forwardAxis(0.0f), rightAxis(0.0f), capsuleHalfHeight(0.0f), interpHalfHeight(0.0f), outHipOffset(0.0f), outInterpHalfHeight(0.0f) {}
+	};
+
+	/* Runs the IK math of a frame from its inputs, writing the outputs of the frame. Matches AMainPlayer::UpdateIK and UpdateCapsule. */
+	IKCORE_API void ReplayIK(const ReplayCharacter& character, ReplayFrame& frame);
+
+	/* Returns true if the outputs of two frames are bit for bit the same. */
+	IKCORE_API bool ReplayOutputsMatch(const ReplayFrame& a, const ReplayFrame& b);
+
+	/* Writes records into a growing buffer, which the owner flushes wherever it likes. */
+	class IKCORE_API ReplayWriter
+	{
+	public:
+
+		/* Constructor, starts the buffer with the stream header. */
+		ReplayWriter();
+
+		/* Writes a character record. */
+		void WriteCharacter(const ReplayCharacter& character);
+
+		/* Writes a frame record. */
+		void WriteFrame(const ReplayFrame& frame);
+
+		/* Returns the bytes written since the last clear. */
+		const std::vector<uint8_t>& GetBuffer() const { return buffer; }
+
+		/* Empties the buffer after it has been flushed, keeping its memory. The header is not written again. */
+		void Clear() { buffer.clear(); }
+
+	private:
+
+		/* Appends raw bytes. */
+		void Write(const void* data, size_t size);
+
+	private:
+
+		std::vector<uint8_t> buffer; /* The bytes not yet flushed. */
+	};
+
+	/* Reads records from a whole stream in memory. */
+	class IKCORE_API ReplayReader
+	{
+	public:
+
+		/* Constructor, checks the header. The data has to outlive the reader. */
+		ReplayReader(const uint8_t* inData, size_t inSize);
+
+		/* Returns true if the header was valid. */
+		bool IsValid() const { return valid; }
+
+		/* Reads the next record into the character or frame, returning its type. None at the end or if the stream is truncated. */
+		ReplayRecordType Next(ReplayCharacter& outCharacter, ReplayFrame& outFrame);
+
+	private:
+
+		/* Reads raw bytes, returning false if there are not enough left. */
+		bool Read(void* outData, size_t size);
+
+	private:
+
+		const uint8_t* data; /* The stream. */
+		size_t size; /* The size of the stream. */
+		size_t offset; /* The read position. */
+		bool valid; /* Was the header valid? */
+	};
+}
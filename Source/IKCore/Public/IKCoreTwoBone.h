@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "IKCoreMath.h"
+#include <vector>
+
+/* Two bone leg IK for many characters at once. Each leg is one entry, so a character adds its left and right leg. */
+namespace IKCore
+{
+	/* A batch of legs stored as a structure of arrays. Inputs are the animated leg before the hip offset, outputs are the solved leg after it. */
+	struct IKCORE_API TwoBoneBatch
+	{
+		std::vector<float> rootX, rootY, rootZ; /* Animated thigh position. */
+		std::vector<float> jointX, jointY, jointZ; /* Animated knee position. */
+		std::vector<float> endX, endY, endZ; /* Animated foot position. */
+		std::vector<float> jointTargetX, jointTargetY, jointTargetZ; /* Position the knee bends towards. */
+		std::vector<float> effectorX, effectorY, effectorZ; /* Position the foot reaches for. */
+		std::vector<float> upperLength, lowerLength; /* Thigh to knee and knee to foot bone lengths. */
+		std::vector<float> hipOffset; /* How far the whole leg is moved down with the hips before solving. */
+
+		std::vector<float> outJointX, outJointY, outJointZ; /* Solved knee position. */
+		std::vector<float> outEndX, outEndY, outEndZ; /* Solved foot position. */
+		std::vector<float> upperRotationX, upperRotationY, upperRotationZ, upperRotationW; /* Rotation applied on top of the thigh. */
+		std::vector<float> lowerRotationX, lowerRotationY, lowerRotationZ, lowerRotationW; /* Rotation applied on top of the knee. */
+
+		/* Returns the number of legs in the batch. */
+		int Num() const { return (int)rootX.size(); }
+
+		/* Resizes every array to hold the given number of legs. Keeps its memory when shrinking. */
+		void Resize(int count);
+
+		/* Sets the inputs of a leg, taking the bone lengths from the animated positions. */
+		void SetLeg(int index, const Vector3& root, const Vector3& joint, const Vector3& end, const Vector3& jointTarget, const Vector3& effector, float legHipOffset);
+
+		/* Returns the solved knee and foot positions of a leg. */
+		Vector3 GetJoint(int index) const { return Vector3(outJointX[index], outJointY[index], outJointZ[index]); }
+		Vector3 GetEnd(int index) const { return Vector3(outEndX[index], outEndY[index], outEndZ[index]); }
+
+		/* Returns the solved thigh and knee rotations of a leg, applied as rotation * animated rotation. */
+		Quat GetUpperRotation(int index) const { return Quat(upperRotationX[index], upperRotationY[index], upperRotationZ[index], upperRotationW[index]); }
+		Quat GetLowerRotation(int index) const { return Quat(lowerRotationX[index], lowerRotationY[index], lowerRotationZ[index], lowerRotationW[index]); }
+	};
+
+	/* Solves a two bone chain for its new joint and end positions, matching AnimationCore::SolveTwoBoneIK without stretching. */
+	IKCORE_API void SolveTwoBoneIK(const Vector3& root, const Vector3& jointTarget, const Vector3& effector, float upperLength, float lowerLength, Vector3& outJoint, Vector3& outEnd);
+
+	/* Returns the rotation from one normal to another, matching FQuat::FindBetweenNormals. */
+	IKCORE_API Quat FindBetweenNormals(const Vector3& a, const Vector3& b);
+
+	/* Solves every leg in the batch one at a time. The reference the vectorised solve is checked against. */
+	IKCORE_API void SolveTwoBoneBatchScalar(TwoBoneBatch& batch);
+
+	/* Solves every leg in the batch, four at a time with SSE where available. Legs the vectorised path cannot handle use the scalar solve. */
+	IKCORE_API void SolveTwoBoneBatch(TwoBoneBatch& batch);
+
+	/* Is SolveTwoBoneBatch vectorised in this build? */
+	IKCORE_API bool IsTwoBoneBatchVectorised();
+}
@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKCoreBatch.h"
+#include "IKCoreTwoBone.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+/* Micro-benchmarks of the IK core batch functions against the same math run one character at a time.
+ * Also checks the vectorised two bone solve matches the scalar one, returning 1 if it does not.
+ * Usage: ikcore_benchmark [iterations] */
+
+/* The largest difference allowed between the vectorised and scalar two bone solves, relative to the size of the value. */
+static const float TwoBoneTolerance = 1.e-4f;
+
+/* Every field of a character the way the character class holds them, used for the one at a time comparison. */
+struct CharacterData
+{
+	float leftFloorZ, rightFloorZ, capsuleBottomZ;
+	float halfHeight, originalHalfHeight, interpSpeed;
+	IKCore::Quat rotation;
+	IKCore::Vector3 translation, relativeFoot;
+	float hipOffset;
+	IKCore::Vector3 foot;
+};
+
+/* The same characters stored as a structure of arrays for the batch functions. */
+struct CharacterBatch
+{
+	std::vector<float> leftFloorZ, rightFloorZ, capsuleBottomZ;
+	std::vector<float> halfHeight, originalHalfHeight, interpSpeed;
+	std::vector<IKCore::Quat> rotation;
+	std::vector<IKCore::Vector3> translation, relativeFoot;
+	std::vector<float> hipOffset;
+	std::vector<IKCore::Vector3> foot;
+};
+
+/* Fills both layouts with the same random characters. */
+static void MakeCharacters(int count, std::vector<CharacterData>& outCharacters, CharacterBatch& outBatch)
+{
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> floorZ(-20.0f, 20.0f);
+	std::uniform_real_distribution<float> angle(-3.14159f, 3.14159f);
+	std::uniform_real_distribution<float> position(-10000.0f, 10000.0f);
+
+	outCharacters.resize(count);
+	for (CharacterData& character : outCharacters)
+	{
+		float yaw = angle(random) * 0.5f;
+		character.leftFloorZ = floorZ(random);
+		character.rightFloorZ = floorZ(random);
+		character.capsuleBottomZ = floorZ(random);
+		character.halfHeight = 90.0f;
+		character.originalHalfHeight = 96.0f;
+		character.interpSpeed = 10.0f;
+		character.rotation = IKCore::Quat(0.0f, 0.0f, std::sin(yaw), std::cos(yaw));
+		character.translation = IKCore::Vector3(position(random), position(random), 100.0f);
+		character.relativeFoot = IKCore::Vector3(10.0f, -15.0f, -90.0f);
+		character.hipOffset = 0.0f;
+	}
+
+	outBatch = CharacterBatch();
+	for (const CharacterData& character : outCharacters)
+	{
+		outBatch.leftFloorZ.push_back(character.leftFloorZ);
+		outBatch.rightFloorZ.push_back(character.rightFloorZ);
+		outBatch.capsuleBottomZ.push_back(character.capsuleBottomZ);
+		outBatch.halfHeight.push_back(character.halfHeight);
+		outBatch.originalHalfHeight.push_back(character.originalHalfHeight);
+		outBatch.interpSpeed.push_back(character.interpSpeed);
+		outBatch.rotation.push_back(character.rotation);
+		outBatch.translation.push_back(character.translation);
+		outBatch.relativeFoot.push_back(character.relativeFoot);
+	}
+	outBatch.hipOffset.resize(count);
+	outBatch.foot.resize(count);
+}
+
+/* Fills the batch with the left and right legs of random characters, some with their feet out of reach. */
+static void MakeLegs(int characterCount, IKCore::TwoBoneBatch& outBatch)
+{
+	std::mt19937 random(5678);
+	std::uniform_real_distribution<float> position(-10000.0f, 10000.0f);
+	std::uniform_real_distribution<float> floorOffset(-45.0f, 25.0f);
+	std::uniform_real_distribution<float> footSlide(-5.0f, 5.0f);
+	std::uniform_real_distribution<float> hipOffset(-30.0f, 0.0f);
+
+	outBatch.Resize(characterCount * 2);
+	for (int character = 0; character < characterCount; character++)
+	{
+		const IKCore::Vector3 location(position(random), position(random), 0.0f);
+		const float hips = hipOffset(random);
+		for (int side = 0; side < 2; side++)
+		{
+			const float y = side == 0 ? -12.0f : 12.0f;
+			const IKCore::Vector3 root = location + IKCore::Vector3(0.0f, y, 95.0f);
+			const IKCore::Vector3 joint = location + IKCore::Vector3(3.0f, y, 50.0f);
+			const IKCore::Vector3 end = location + IKCore::Vector3(0.0f, y, 8.0f);
+			const IKCore::Vector3 jointTarget = joint + IKCore::Vector3(50.0f, 0.0f, hips);
+			const IKCore::Vector3 effector = end + IKCore::Vector3(footSlide(random), footSlide(random), floorOffset(random));
+			outBatch.SetLeg(character * 2 + side, root, joint, end, jointTarget, effector, hips);
+		}
+	}
+}
+
+/* Returns the largest difference between the outputs of two solved batches, relative to the size of the values above 1. */
+static float MaxDifference(const IKCore::TwoBoneBatch& a, const IKCore::TwoBoneBatch& b)
+{
+	const std::vector<float> IKCore::TwoBoneBatch::* outputs[] = {
+		&IKCore::TwoBoneBatch::outJointX, &IKCore::TwoBoneBatch::outJointY, &IKCore::TwoBoneBatch::outJointZ,
+		&IKCore::TwoBoneBatch::outEndX, &IKCore::TwoBoneBatch::outEndY, &IKCore::TwoBoneBatch::outEndZ,
+		&IKCore::TwoBoneBatch::upperRotationX, &IKCore::TwoBoneBatch::upperRotationY, &IKCore::TwoBoneBatch::upperRotationZ, &IKCore::TwoBoneBatch::upperRotationW,
+		&IKCore::TwoBoneBatch::lowerRotationX, &IKCore::TwoBoneBatch::lowerRotationY, &IKCore::TwoBoneBatch::lowerRotationZ, &IKCore::TwoBoneBatch::lowerRotationW };
+
+	float maxDifference = 0.0f;
+	for (const std::vector<float> IKCore::TwoBoneBatch::* output : outputs)
+	{
+		for (int i = 0; i < a.Num(); i++) maxDifference = std::max(maxDifference, std::fabs((a.*output)[i] - (b.*output)[i]) / std::max(1.0f, std::fabs((b.*output)[i])));
+	}
+	return maxDifference;
+}
+
+/* Runs the function the given number of times and returns the average nanoseconds per character. */
+static double Measure(int iterations, int count, const std::function<void()>& function)
+{
+	function();
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++) function();
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::high_resolution_clock::now() - start;
+	return elapsed.count() / ((double)iterations * count);
+}
+
+int main(int argc, char** argv)
+{
+	const int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+	const float deltaTime = 1.0f / 60.0f;
+	const int counts[] = { 64, 1024, 16384 };
+	float checksum = 0.0f;
+
+	std::printf("%-28s %10s %14s %14s\n", "benchmark", "characters", "batch ns/char", "single ns/char");
+	for (int count : counts)
+	{
+		std::vector<CharacterData> characters;
+		CharacterBatch batch;
+		MakeCharacters(count, characters, batch);
+
+		// Hip offsets.
+		double batchTime = Measure(iterations, count, [&]()
+		{
+			IKCore::SolveHipOffsets(count, batch.leftFloorZ.data(), batch.rightFloorZ.data(), batch.capsuleBottomZ.data(), batch.hipOffset.data());
+		});
+		double singleTime = Measure(iterations, count, [&]()
+		{
+			for (CharacterData& character : characters) character.hipOffset = IKCore::HipOffset(character.leftFloorZ, character.rightFloorZ, character.capsuleBottomZ);
+		});
+		std::printf("%-28s %10d %14.2f %14.2f\n", "SolveHipOffsets", count, batchTime, singleTime);
+		checksum += batch.hipOffset[count - 1] + characters[count - 1].hipOffset;
+
+		// Capsule half heights, written back in place as the character does.
+		batchTime = Measure(iterations, count, [&]()
+		{
+			IKCore::InterpCapsuleHalfHeights(count, batch.halfHeight.data(), batch.originalHalfHeight.data(), batch.hipOffset.data(), batch.interpSpeed.data(), deltaTime, batch.halfHeight.data());
+		});
+		singleTime = Measure(iterations, count, [&]()
+		{
+			for (CharacterData& character : characters)
+			{
+				character.halfHeight = IKCore::InterpTo(character.halfHeight, IKCore::CapsuleTargetHalfHeight(character.originalHalfHeight, character.hipOffset), deltaTime, character.interpSpeed);
+			}
+		});
+		std::printf("%-28s %10d %14.2f %14.2f\n", "InterpCapsuleHalfHeights", count, batchTime, singleTime);
+		checksum += batch.halfHeight[count - 1] + characters[count - 1].halfHeight;
+
+		// Default feet positions.
+		batchTime = Measure(iterations, count, [&]()
+		{
+			IKCore::TransformPositionsNoScale(count, batch.rotation.data(), batch.translation.data(), batch.relativeFoot.data(), batch.foot.data());
+		});
+		singleTime = Measure(iterations, count, [&]()
+		{
+			for (CharacterData& character : characters) character.foot = IKCore::TransformPositionNoScale(character.rotation, character.translation, character.relativeFoot);
+		});
+		std::printf("%-28s %10d %14.2f %14.2f\n", "TransformPositionsNoScale", count, batchTime, singleTime);
+		checksum += batch.foot[count - 1].z + characters[count - 1].foot.z;
+	}
+
+	// The two bone solve, vectorised against scalar. Each character is two legs.
+	bool matches = true;
+	std::printf("\n%-28s %10s %14s %14s %14s\n", IKCore::IsTwoBoneBatchVectorised() ? "two bone (sse)" : "two bone (scalar)", "characters", "batch ns/char", "scalar ns/char", "max rel diff");
+	for (int count : counts)
+	{
+		IKCore::TwoBoneBatch batch, reference;
+		MakeLegs(count, batch);
+		MakeLegs(count, reference);
+		double batchTime = Measure(iterations, count, [&]() { IKCore::SolveTwoBoneBatch(batch); });
+		double scalarTime = Measure(iterations, count, [&]() { IKCore::SolveTwoBoneBatchScalar(reference); });
+		float maxDifference = MaxDifference(batch, reference);
+		matches = matches && maxDifference <= TwoBoneTolerance;
+		std::printf("%-28s %10d %14.2f %14.2f %14g\n", "SolveTwoBoneBatch", count, batchTime, scalarTime, maxDifference);
+		checksum += batch.outJointZ[count - 1] + reference.outJointZ[count - 1];
+	}
+
+	// Printed so the compiler cannot drop the work.
+	std::printf("checksum %f\n", checksum);
+	if (!matches) std::printf("two bone solve differs from the scalar reference by more than %g\n", TwoBoneTolerance);
+	return matches ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKCoreBVH.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+/* Times floor queries against level collision exported with -run=IKFloorExport, using the BVH and testing every triangle.
+ * Also checks every BVH query matches testing every triangle, returning 1 if any differ or the level cannot be read.
+ * Compare the times with ik.FloorQuery.Compare in game, which runs the same queries through the physics scene.
+ * Usage: ik_floorquery <level.ikts> [queries]
+ *        ik_floorquery --selftest [queries]    Queries a generated level of uneven ground, stairs and boxes. */
+
+/* The largest difference in hit time allowed between the BVH and testing every triangle. */
+static const float HitTimeTolerance = 1.e-4f;
+
+/* The foot trace sphere radius and how far below the start a foot trace ends, matching the character defaults. */
+static const float FootTraceRadius = 5.0f;
+static const float FootTraceDistance = 200.0f;
+
+/* A query from start to end, a ray when the radius is zero. */
+struct FloorQuery
+{
+	IKCore::Vector3 start, end;
+	float radius;
+};
+
+/* Reads a whole file, returning false if it cannot be opened. */
+static bool ReadFile(const char* path, std::vector<uint8_t>& outData)
+{
+	std::FILE* file = std::fopen(path, "rb");
+	if (!file) return false;
+	std::fseek(file, 0, SEEK_END);
+	long size = std::ftell(file);
+	std::fseek(file, 0, SEEK_SET);
+	outData.resize(size > 0 ? (size_t)size : 0);
+	size_t read = outData.empty() ? 0 : std::fread(outData.data(), 1, outData.size(), file);
+	std::fclose(file);
+	return read == outData.size();
+}
+
+/* Adds the six faces of a box. */
+static void AddBox(IKCore::TriangleSoup& soup, const IKCore::Vector3& min, const IKCore::Vector3& max)
+{
+	const IKCore::Vector3 corners[8] = {
+		IKCore::Vector3(min.x, min.y, min.z), IKCore::Vector3(max.x, min.y, min.z), IKCore::Vector3(max.x, max.y, min.z), IKCore::Vector3(min.x, max.y, min.z),
+		IKCore::Vector3(min.x, min.y, max.z), IKCore::Vector3(max.x, min.y, max.z), IKCore::Vector3(max.x, max.y, max.z), IKCore::Vector3(min.x, max.y, max.z) };
+	const int faces[6][4] = { { 0, 3, 2, 1 }, { 4, 5, 6, 7 }, { 0, 1, 5, 4 }, { 1, 2, 6, 5 }, { 2, 3, 7, 6 }, { 3, 0, 4, 7 } };
+	for (const int* face : faces)
+	{
+		soup.AddTriangle(corners[face[0]], corners[face[1]], corners[face[2]]);
+		soup.AddTriangle(corners[face[0]], corners[face[2]], corners[face[3]]);
+	}
+}
+
+/* Generates a level of uneven ground with stairs and boxes on it, written and read back through the file format. */
+static std::vector<uint8_t> MakeSelfTestLevel()
+{
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> groundZ(-15.0f, 15.0f);
+	std::uniform_real_distribution<float> position(-2500.0f, 2500.0f);
+	std::uniform_real_distribution<float> boxSize(20.0f, 200.0f);
+
+	// Uneven ground of 100 unit cells sharing their corners.
+	IKCore::TriangleSoup soup;
+	const int gridSize = 50;
+	const float cellSize = 100.0f;
+	std::vector<float> heights((gridSize + 1) * (gridSize + 1));
+	for (float& height : heights) height = groundZ(random);
+	for (int y = 0; y < gridSize; y++)
+	{
+		for (int x = 0; x < gridSize; x++)
+		{
+			const float minX = (x - gridSize / 2) * cellSize, minY = (y - gridSize / 2) * cellSize;
+			const IKCore::Vector3 a(minX, minY, heights[y * (gridSize + 1) + x]);
+			const IKCore::Vector3 b(minX + cellSize, minY, heights[y * (gridSize + 1) + x + 1]);
+			const IKCore::Vector3 c(minX + cellSize, minY + cellSize, heights[(y + 1) * (gridSize + 1) + x + 1]);
+			const IKCore::Vector3 d(minX, minY + cellSize, heights[(y + 1) * (gridSize + 1) + x]);
+			soup.AddTriangle(a, b, c);
+			soup.AddTriangle(a, c, d);
+		}
+	}
+
+	// Flights of stairs and scattered boxes.
+	for (int flight = 0; flight < 20; flight++)
+	{
+		const IKCore::Vector3 origin(position(random), position(random), 0.0f);
+		for (int step = 0; step < 12; step++)
+		{
+			AddBox(soup, IKCore::Vector3(origin.x + step * 30.0f, origin.y, -20.0f), IKCore::Vector3(origin.x + (step + 1) * 30.0f, origin.y + 150.0f, (step + 1) * 18.0f));
+		}
+	}
+	for (int box = 0; box < 200; box++)
+	{
+		const IKCore::Vector3 min(position(random), position(random), -20.0f);
+		AddBox(soup, min, IKCore::Vector3(min.x + boxSize(random), min.y + boxSize(random), min.z + boxSize(random)));
+	}
+
+	std::vector<uint8_t> data;
+	IKCore::WriteTriangleSoup(soup, data);
+	return data;
+}
+
+/* Makes foot traces straight down from above the level, and a quarter of queries in random directions to cover the general case. */
+static std::vector<FloorQuery> MakeQueries(const IKCore::FloorBVH& bvh, int numQueries)
+{
+	std::mt19937 random(5678);
+	const IKCore::Vector3& min = bvh.GetBoundsMin();
+	const IKCore::Vector3& max = bvh.GetBoundsMax();
+	std::uniform_real_distribution<float> x(min.x, max.x), y(min.y, max.y), z(min.z, max.z + FootTraceDistance);
+	std::uniform_real_distribution<float> direction(-FootTraceDistance, FootTraceDistance);
+
+	std::vector<FloorQuery> queries(numQueries);
+	for (int i = 0; i < numQueries; i++)
+	{
+		FloorQuery& query = queries[i];
+		query.start = IKCore::Vector3(x(random), y(random), z(random));
+		query.end = i % 4 == 3 ? query.start + IKCore::Vector3(direction(random), direction(random), direction(random)) : query.start - IKCore::Vector3(0.0f, 0.0f, FootTraceDistance);
+		query.radius = i % 2 == 0 ? FootTraceRadius : 0.0f;
+	}
+	return queries;
+}
+
+/* Runs a query against the BVH or every triangle. */
+static bool RunQuery(const IKCore::TriangleSoup& soup, const IKCore::FloorBVH& bvh, bool useBVH, const FloorQuery& query, IKCore::FloorHit& outHit)
+{
+	if (useBVH) return query.radius > 0.0f ? bvh.SweepSphere(query.start, query.end, query.radius, outHit) : bvh.RayCast(query.start, query.end, outHit);
+	return query.radius > 0.0f ? IKCore::SweepSphereTriangles(soup, query.start, query.end, query.radius, outHit) : IKCore::RayCastTriangles(soup, query.start, query.end, outHit);
+}
+
+/* Returns the average time in nanoseconds each query of the given kind takes. */
+static double TimeQueries(const IKCore::TriangleSoup& soup, const IKCore::FloorBVH& bvh, bool useBVH, bool sweeps, const std::vector<FloorQuery>& queries, int iterations, float& checksum)
+{
+	size_t numRun = 0;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (int iteration = 0; iteration < iterations; iteration++)
+	{
+		for (const FloorQuery& query : queries)
+		{
+			if ((query.radius > 0.0f) != sweeps) continue;
+			IKCore::FloorHit hit;
+			if (RunQuery(soup, bvh, useBVH, query, hit)) checksum += hit.time;
+			numRun++;
+		}
+	}
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::high_resolution_clock::now() - start;
+	return numRun == 0 ? 0.0 : elapsed.count() / numRun;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::printf("usage: ik_floorquery <level.ikts> [queries]\n       ik_floorquery --selftest [queries]\n");
+		return 1;
+	}
+	int numQueries = argc > 2 ? std::atoi(argv[2]) : 2000;
+	if (numQueries < 1) numQueries = 1;
+
+	// Load the level.
+	std::vector<uint8_t> data;
+	if (std::strcmp(argv[1], "--selftest") == 0) data = MakeSelfTestLevel();
+	else if (!ReadFile(argv[1], data))
+	{
+		std::printf("could not read %s\n", argv[1]);
+		return 1;
+	}
+
+	IKCore::TriangleSoup soup;
+	if (!IKCore::ReadTriangleSoup(data.data(), data.size(), soup))
+	{
+		std::printf("%s is not a triangle soup of version %u\n", argv[1], IKCore::TriangleSoupVersion);
+		return 1;
+	}
+
+	std::chrono::high_resolution_clock::time_point buildStart = std::chrono::high_resolution_clock::now();
+	IKCore::FloorBVH bvh;
+	bvh.Build(soup);
+	std::chrono::duration<double, std::milli> buildTime = std::chrono::high_resolution_clock::now() - buildStart;
+	std::printf("triangles %d nodes %d bytes %zu build %.2f ms%s\n", bvh.NumTriangles(), bvh.NumNodes(), data.size(), buildTime.count(), IKCORE_SSE ? " (sse)" : "");
+	if (bvh.NumTriangles() == 0) return 0;
+
+	// Check every BVH query against testing every triangle.
+	const std::vector<FloorQuery> queries = MakeQueries(bvh, numQueries);
+	size_t mismatches = 0, hits = 0;
+	for (const FloorQuery& query : queries)
+	{
+		IKCore::FloorHit bvhHit, expectedHit;
+		const bool bvhHasHit = RunQuery(soup, bvh, true, query, bvhHit);
+		const bool expectedHasHit = RunQuery(soup, bvh, false, query, expectedHit);
+		hits += expectedHasHit ? 1 : 0;
+		if (bvhHasHit == expectedHasHit && (!bvhHasHit || std::fabs(bvhHit.time - expectedHit.time) <= HitTimeTolerance)) continue;
+		if (mismatches++ < 10)
+		{
+			std::printf("%s from (%.2f %.2f %.2f) to (%.2f %.2f %.2f) differs: bvh %s %.6f, every triangle %s %.6f\n", query.radius > 0.0f ? "sweep" : "ray",
+				query.start.x, query.start.y, query.start.z, query.end.x, query.end.y, query.end.z,
+				bvhHasHit ? "hit" : "miss", bvhHit.time, expectedHasHit ? "hit" : "miss", expectedHit.time);
+		}
+	}
+
+	// Time both ways, running the slow one over fewer iterations.
+	float checksum = 0.0f;
+	const int bvhIterations = 20;
+	std::printf("bvh ray %.1f ns sweep %.1f ns\n", TimeQueries(soup, bvh, true, false, queries, bvhIterations, checksum), TimeQueries(soup, bvh, true, true, queries, bvhIterations, checksum));
+	std::printf("every triangle ray %.1f ns sweep %.1f ns\n", TimeQueries(soup, bvh, false, false, queries, 1, checksum), TimeQueries(soup, bvh, false, true, queries, 1, checksum));
+	std::printf("checksum %f\n", checksum);
+	std::printf("%zu of %zu queries hit, %zu differ between the bvh and every triangle\n", hits, queries.size(), mismatches);
+	return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKCoreReplay.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+
+/* Replays an IK recording through the IK math with no engine, checking every output matches the recording bit for bit and timing it.
+ * Returns 1 if any frame differs or the recording cannot be read.
+ * Usage: ik_replay <recording.ikrp> [iterations]
+ *        ik_replay --selftest [iterations]    Replays a generated recording, checking the stream round trips. */
+
+/* A recording read into memory. */
+struct Recording
+{
+	std::map<uint32_t, IKCore::ReplayCharacter> characters;
+	std::vector<IKCore::ReplayFrame> frames;
+};
+
+/* Reads every record of a stream, returning false if it is not a valid stream. */
+static bool ReadRecording(const std::vector<uint8_t>& data, Recording& outRecording)
+{
+	IKCore::ReplayReader reader(data.data(), data.size());
+	if (!reader.IsValid()) return false;
+
+	IKCore::ReplayCharacter character;
+	IKCore::ReplayFrame frame;
+	for (;;)
+	{
+		IKCore::ReplayRecordType type = reader.Next(character, frame);
+		if (type == IKCore::ReplayRecordType::None) break;
+		if (type == IKCore::ReplayRecordType::Character) outRecording.characters[character.id] = character;
+		else outRecording.frames.push_back(frame);
+	}
+	return true;
+}
+
+/* Reads a whole file, returning false if it cannot be opened. */
+static bool ReadFile(const char* path, std::vector<uint8_t>& outData)
+{
+	std::FILE* file = std::fopen(path, "rb");
+	if (!file) return false;
+	std::fseek(file, 0, SEEK_END);
+	long size = std::ftell(file);
+	std::fseek(file, 0, SEEK_SET);
+	outData.resize(size > 0 ? (size_t)size : 0);
+	size_t read = outData.empty() ? 0 : std::fread(outData.data(), 1, outData.size(), file);
+	std::fclose(file);
+	return read == outData.size();
+}
+
+/* Records a few characters walking over uneven floors the way the game does, so the tool can check itself without a recording. */
+static std::vector<uint8_t> MakeSelfTestRecording()
+{
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> floorZ(-20.0f, 20.0f);
+	std::uniform_real_distribution<float> position(-10000.0f, 10000.0f);
+
+	IKCore::ReplayWriter writer;
+	const uint32_t numCharacters = 16, numFrames = 600;
+	std::vector<float> interpHalfHeights(numCharacters, 96.0f);
+	for (uint32_t id = 0; id < numCharacters; id++)
+	{
+		IKCore::ReplayCharacter character;
+		character.id = id;
+		character.originalHalfHeight = 96.0f;
+		character.interpSpeed = 7.0f;
+		writer.WriteCharacter(character);
+	}
+
+	for (uint32_t frameNumber = 0; frameNumber < numFrames; frameNumber++)
+	{
+		for (uint32_t id = 0; id < numCharacters; id++)
+		{
+			IKCore::ReplayCharacter character;
+			character.id = id;
+			character.originalHalfHeight = 96.0f;
+			character.interpSpeed = 7.0f;
+
+			IKCore::ReplayFrame frame;
+			frame.frame = frameNumber;
+			frame.id = id;
+			frame.deltaTime = 1.0f / 60.0f;
+			frame.capsuleLocation = IKCore::Vector3(position(random), position(random), 96.0f);
+			frame.capsuleHalfHeight = interpHalfHeights[id];
+			frame.interpHalfHeight = interpHalfHeights[id];
+			frame.leftFloor = IKCore::Vector3(frame.capsuleLocation.x - 10.0f, frame.capsuleLocation.y, floorZ(random));
+			frame.rightFloor = IKCore::Vector3(frame.capsuleLocation.x + 10.0f, frame.capsuleLocation.y, floorZ(random));
+			IKCore::ReplayIK(character, frame);
+			interpHalfHeights[id] = frame.outInterpHalfHeight;
+			writer.WriteFrame(frame);
+		}
+	}
+	return writer.GetBuffer();
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::printf("usage: ik_replay <recording.ikrp> [iterations]\n       ik_replay --selftest [iterations]\n");
+		return 1;
+	}
+	int iterations = argc > 2 ? std::atoi(argv[2]) : 10;
+	if (iterations < 1) iterations = 1;
+
+	// Load the recording.
+	std::vector<uint8_t> data;
+	if (std::strcmp(argv[1], "--selftest") == 0) data = MakeSelfTestRecording();
+	else if (!ReadFile(argv[1], data))
+	{
+		std::printf("could not read %s\n", argv[1]);
+		return 1;
+	}
+
+	Recording recording;
+	if (!ReadRecording(data, recording))
+	{
+		std::printf("%s is not an IK recording of version %u\n", argv[1], IKCore::ReplayVersion);
+		return 1;
+	}
+
+	// Replay every frame, checking its outputs against the recording.
+	size_t mismatches = 0, missingCharacters = 0;
+	std::vector<IKCore::ReplayFrame> replayed(recording.frames);
+	for (size_t i = 0; i < replayed.size(); i++)
+	{
+		std::map<uint32_t, IKCore::ReplayCharacter>::const_iterator character = recording.characters.find(replayed[i].id);
+		if (character == recording.characters.end())
+		{
+			missingCharacters++;
+			continue;
+		}
+
+		IKCore::ReplayIK(character->second, replayed[i]);
+		if (IKCore::ReplayOutputsMatch(replayed[i], recording.frames[i])) continue;
+		if (mismatches++ < 10)
+		{
+			const IKCore::ReplayFrame& expected = recording.frames[i];
+			std::printf("frame %u character %u differs: hip %.9g != %.9g, half height %.9g != %.9g\n", expected.frame, expected.id,
+				replayed[i].outHipOffset, expected.outHipOffset, replayed[i].outInterpHalfHeight, expected.outInterpHalfHeight);
+		}
+	}
+
+	// Time the replay without the checks.
+	float checksum = 0.0f;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (int iteration = 0; iteration < iterations; iteration++)
+	{
+		for (IKCore::ReplayFrame& frame : replayed)
+		{
+			std::map<uint32_t, IKCore::ReplayCharacter>::const_iterator character = recording.characters.find(frame.id);
+			if (character == recording.characters.end()) continue;
+			IKCore::ReplayIK(character->second, frame);
+			checksum += frame.outHipOffset;
+		}
+	}
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+	std::printf("characters %zu frames %zu bytes %zu\n", recording.characters.size(), recording.frames.size(), data.size());
+	std::printf("replay %.2f ns/frame over %d iterations, checksum %f\n", replayed.empty() ? 0.0 : elapsed.count() / ((double)iterations * replayed.size()), iterations, checksum);
+	if (missingCharacters > 0) std::printf("%zu frames have no character record\n", missingCharacters);
+	std::printf("%zu of %zu frames differ from the recording\n", mismatches, replayed.size());
+	return mismatches == 0 && missingCharacters == 0 ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKCoreBatch.h"
+#include <cmath>
+#include <cstdio>
+
+/* Unit tests of the IK core math against values worked out by hand, including the edge cases of FMath::FInterpTo it matches.
+ * Prints every failed check and returns 1 if any failed.
+ * Usage: ikcore_tests */
+
+/* The largest difference allowed from an expected value. */
+static const float Tolerance = 1.e-4f;
+
+/* The number of checks that have failed. */
+static int numFailed = 0;
+
+/* Checks a value against the expected one. */
+static void CheckFloat(const char* name, float value, float expected)
+{
+	if (std::fabs(value - expected) <= Tolerance) return;
+	std::printf("FAILED %s: got %f, expected %f\n", name, value, expected);
+	numFailed++;
+}
+
+/* Checks each component of a vector against the expected one. */
+static void CheckVector(const char* name, const IKCore::Vector3& value, const IKCore::Vector3& expected)
+{
+	if (std::fabs(value.x - expected.x) <= Tolerance && std::fabs(value.y - expected.y) <= Tolerance && std::fabs(value.z - expected.z) <= Tolerance) return;
+	std::printf("FAILED %s: got (%f, %f, %f), expected (%f, %f, %f)\n", name, value.x, value.y, value.z, expected.x, expected.y, expected.z);
+	numFailed++;
+}
+
+/* Returns a rotation of the given number of degrees around the up axis. */
+static IKCore::Quat MakeYaw(float degrees)
+{
+	float halfAngle = degrees * 3.14159265f / 360.0f;
+	return IKCore::Quat(0.0f, 0.0f, std::sin(halfAngle), std::cos(halfAngle));
+}
+
+static void TestHipOffset()
+{
+	// The lower floor is used, dropping the hips by its distance from the bottom of the capsule.
+	CheckFloat("HipOffset lower left floor", IKCore::HipOffset(-5.0f, 3.0f, -10.0f), -5.0f);
+	CheckFloat("HipOffset lower right floor", IKCore::HipOffset(3.0f, -5.0f, -10.0f), -5.0f);
+	CheckFloat("HipOffset level floor", IKCore::HipOffset(-10.0f, -10.0f, -10.0f), 0.0f);
+	CheckFloat("HipOffset floor above capsule", IKCore::HipOffset(2.0f, 4.0f, 0.0f), -2.0f);
+	CheckFloat("HipOffset is never positive", IKCore::HipOffset(120.0f, 130.0f, 100.0f), -20.0f);
+}
+
+static void TestCapsuleTargetHalfHeight()
+{
+	// The capsule shrinks by half the hip offset either way.
+	CheckFloat("CapsuleTargetHalfHeight no offset", IKCore::CapsuleTargetHalfHeight(96.0f, 0.0f), 96.0f);
+	CheckFloat("CapsuleTargetHalfHeight negative offset", IKCore::CapsuleTargetHalfHeight(96.0f, -10.0f), 91.0f);
+	CheckFloat("CapsuleTargetHalfHeight positive offset", IKCore::CapsuleTargetHalfHeight(96.0f, 10.0f), 91.0f);
+}
+
+static void TestInterpTo()
+{
+	CheckFloat("InterpTo partial step", IKCore::InterpTo(0.0f, 10.0f, 0.1f, 5.0f), 5.0f);
+	CheckFloat("InterpTo downwards", IKCore::InterpTo(10.0f, 0.0f, 0.05f, 4.0f), 8.0f);
+
+	// No speed snaps straight to the target.
+	CheckFloat("InterpTo zero speed", IKCore::InterpTo(0.0f, 10.0f, 0.1f, 0.0f), 10.0f);
+	CheckFloat("InterpTo negative speed", IKCore::InterpTo(0.0f, 10.0f, 0.1f, -1.0f), 10.0f);
+
+	// No time does not move, and negative time is clamped to no time.
+	CheckFloat("InterpTo zero delta time", IKCore::InterpTo(0.0f, 10.0f, 0.0f, 5.0f), 0.0f);
+	CheckFloat("InterpTo negative delta time", IKCore::InterpTo(0.0f, 10.0f, -0.1f, 5.0f), 0.0f);
+
+	// A step past the target is clamped to the target.
+	CheckFloat("InterpTo overshoot", IKCore::InterpTo(0.0f, 10.0f, 1.0f, 5.0f), 10.0f);
+
+	// Within the squared distance of SMALL_NUMBER snaps to the target.
+	CheckFloat("InterpTo nearly there", IKCore::InterpTo(10.0f - 5.e-5f, 10.0f, 0.0f, 5.0f), 10.0f);
+}
+
+static void TestTransformPositionNoScale()
+{
+	CheckVector("TransformPositionNoScale identity", IKCore::TransformPositionNoScale(IKCore::Quat(), IKCore::Vector3(10.0f, 20.0f, 30.0f), IKCore::Vector3(1.0f, 2.0f, 3.0f)), IKCore::Vector3(11.0f, 22.0f, 33.0f));
+	CheckVector("TransformPositionNoScale yaw 90", IKCore::TransformPositionNoScale(MakeYaw(90.0f), IKCore::Vector3(10.0f, 20.0f, 30.0f), IKCore::Vector3(1.0f, 0.0f, 0.0f)), IKCore::Vector3(10.0f, 21.0f, 30.0f));
+	CheckVector("TransformPositionNoScale yaw 180", IKCore::TransformPositionNoScale(MakeYaw(180.0f), IKCore::Vector3(), IKCore::Vector3(1.0f, 2.0f, 3.0f)), IKCore::Vector3(-1.0f, -2.0f, 3.0f));
+
+	// Roll of 90 degrees around the forward axis takes up to left.
+	IKCore::Quat roll(std::sin(3.14159265f / 4.0f), 0.0f, 0.0f, std::cos(3.14159265f / 4.0f));
+	CheckVector("TransformPositionNoScale roll 90", IKCore::TransformPositionNoScale(roll, IKCore::Vector3(), IKCore::Vector3(0.0f, 0.0f, 1.0f)), IKCore::Vector3(0.0f, -1.0f, 0.0f));
+}
+
+static void TestBatchMatchesScalar()
+{
+	// The batch functions run the same math over every character.
+	const int count = 5;
+	const float leftFloorZ[count] = { -5.0f, 3.0f, 0.0f, 12.0f, -40.0f };
+	const float rightFloorZ[count] = { 3.0f, -5.0f, 0.0f, 8.0f, -35.0f };
+	const float capsuleBottomZ[count] = { -10.0f, -10.0f, 0.0f, 0.0f, -50.0f };
+	const float currentHalfHeight[count] = { 96.0f, 90.0f, 96.0f, 80.0f, 96.0f };
+	const float originalHalfHeight[count] = { 96.0f, 96.0f, 96.0f, 96.0f, 96.0f };
+	const float interpSpeed[count] = { 7.0f, 7.0f, 0.0f, 20.0f, 7.0f };
+	IKCore::Quat rotation[count] = { IKCore::Quat(), MakeYaw(90.0f), MakeYaw(180.0f), MakeYaw(-45.0f), MakeYaw(30.0f) };
+	IKCore::Vector3 translation[count] = { IKCore::Vector3(0.0f, 0.0f, 100.0f), IKCore::Vector3(50.0f, 0.0f, 0.0f), IKCore::Vector3(), IKCore::Vector3(-10.0f, 5.0f, 2.0f), IKCore::Vector3(1.0f, 1.0f, 1.0f) };
+	IKCore::Vector3 relativeFoot[count] = { IKCore::Vector3(10.0f, -15.0f, -90.0f), IKCore::Vector3(10.0f, 15.0f, -90.0f), IKCore::Vector3(1.0f, 0.0f, 0.0f), IKCore::Vector3(0.0f, 1.0f, 0.0f), IKCore::Vector3(3.0f, 4.0f, 5.0f) };
+
+	float hipOffset[count], halfHeight[count];
+	IKCore::Vector3 foot[count];
+	IKCore::SolveHipOffsets(count, leftFloorZ, rightFloorZ, capsuleBottomZ, hipOffset);
+	IKCore::InterpCapsuleHalfHeights(count, currentHalfHeight, originalHalfHeight, hipOffset, interpSpeed, 0.016f, halfHeight);
+	IKCore::TransformPositionsNoScale(count, rotation, translation, relativeFoot, foot);
+	for (int i = 0; i < count; i++)
+	{
+		float expectedHipOffset = IKCore::HipOffset(leftFloorZ[i], rightFloorZ[i], capsuleBottomZ[i]);
+		CheckFloat("SolveHipOffsets", hipOffset[i], expectedHipOffset);
+		CheckFloat("InterpCapsuleHalfHeights", halfHeight[i], IKCore::InterpTo(currentHalfHeight[i], IKCore::CapsuleTargetHalfHeight(originalHalfHeight[i], expectedHipOffset), 0.016f, interpSpeed[i]));
+		CheckVector("TransformPositionsNoScale", foot[i], IKCore::TransformPositionNoScale(rotation[i], translation[i], relativeFoot[i]));
+	}
+}
+
+int main()
+{
+	TestHipOffset();
+	TestCapsuleTargetHalfHeight();
+	TestInterpTo();
+	TestTransformPositionNoScale();
+	TestBatchMatchesScalar();
+
+	if (numFailed > 0)
+	{
+		std::printf("%d checks failed\n", numFailed);
+		return 1;
+	}
+	std::printf("all checks passed\n");
+	return 0;
+}
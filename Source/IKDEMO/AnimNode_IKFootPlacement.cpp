@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AnimNode_IKFootPlacement.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "IKCoreConversions.h"
+#include "IKAnimInstance.h"
+
+FAnimNode_IKFootPlacement::FAnimNode_IKFootPlacement()
+	: kneeTargetOffset(0.0f, 50.0f, 0.0f)
+	, animatedFloorHeight(0.0f)
+	, leftFootLocation(FVector::ZeroVector)
+	, rightFootLocation(FVector::ZeroVector)
+	, hipOffset(0.0f)
+	, hasIKValues(false)
+{
+	//...
+}
+
+void FAnimNode_IKFootPlacement::UpdateInternal(const FAnimationUpdateContext& Context)
+{
+	FAnimNode_SkeletalControlBase::UpdateInternal(Context);
+
+	// Read the values the proxy copied from the anim instance on the game thread, skipping the solve while the anim budget has turned the IK off.
+	UObject* animInstance = Context.AnimInstanceProxy->GetAnimInstanceObject();
+	hasIKValues = animInstance && animInstance->IsA<UIKAnimInstance>() && static_cast<const FIKAnimInstanceProxy*>(Context.AnimInstanceProxy)->ikEnabled;
+	if (hasIKValues)
+	{
+		const FIKAnimInstanceProxy* proxy = static_cast<const FIKAnimInstanceProxy*>(Context.AnimInstanceProxy);
+		leftFootLocation = proxy->leftFootLocation;
+		rightFootLocation = proxy->rightFootLocation;
+		hipOffset = proxy->hipOffset;
+	}
+}
+
+void FAnimNode_IKFootPlacement::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
+{
+	if (!hasIKValues) return;
+
+	// Offset the pelvis down by the hip offset.
+	const FBoneContainer& boneContainer = Output.Pose.GetPose().GetBoneContainer();
+	FCompactPoseBoneIndex pelvisIndex = pelvisBone.GetCompactPoseIndex(boneContainer);
+	FTransform pelvisTransform = Output.Pose.GetComponentSpaceTransform(pelvisIndex);
+	FVector hipTranslation(0.0f, 0.0f, hipOffset);
+	pelvisTransform.AddToTranslation(hipTranslation);
+	OutBoneTransforms.Add(FBoneTransform(pelvisIndex, pelvisTransform));
+
+	// Solve both legs together from the offset hips.
+	legBatch.Resize(2);
+	GatherLeg(Output, 0, leftFootBone, leftFootLocation, hipTranslation);
+	GatherLeg(Output, 1, rightFootBone, rightFootLocation, hipTranslation);
+	IKCore::SolveTwoBoneBatch(legBatch);
+	ApplyLeg(Output, 0, leftFootBone, hipTranslation, OutBoneTransforms);
+	ApplyLeg(Output, 1, rightFootBone, hipTranslation, OutBoneTransforms);
+
+	// The output has to be in bone order.
+	OutBoneTransforms.Sort(FCompareBoneTransformIndex());
+}
+
+void FAnimNode_IKFootPlacement::GatherLeg(FComponentSpacePoseContext& Output, int32 leg, const FBoneReference& footBone, const FVector& floorLocation, const FVector& hipTranslation)
+{
+	// Get the leg chain.
+	const FBoneContainer& boneContainer = Output.Pose.GetPose().GetBoneContainer();
+	FCompactPoseBoneIndex footIndex = footBone.GetCompactPoseIndex(boneContainer);
+	FCompactPoseBoneIndex kneeIndex = boneContainer.GetParentBoneIndex(footIndex);
+	FCompactPoseBoneIndex thighIndex = boneContainer.GetParentBoneIndex(kneeIndex);
+	FVector thighLocation = Output.Pose.GetComponentSpaceTransform(thighIndex).GetLocation();
+	FVector kneeLocation = Output.Pose.GetComponentSpaceTransform(kneeIndex).GetLocation();
+	FVector footLocation = Output.Pose.GetComponentSpaceTransform(footIndex).GetLocation();
+
+	// Move the animated foot by how far the traced floor is from the animated floor, an untraced floor leaves the foot where it is.
+	FVector effector = footLocation + hipTranslation;
+	if (!floorLocation.IsZero())
+	{
+		FVector floorComponentSpace = Output.AnimInstanceProxy->GetComponentTransform().InverseTransformPosition(floorLocation);
+		effector.Z = footLocation.Z + floorComponentSpace.Z - animatedFloorHeight;
+	}
+
+	// The whole leg moves with the pelvis, which the batch applies.
+	FVector kneeTarget = kneeLocation + hipTranslation + kneeTargetOffset;
+	legBatch.SetLeg(leg, IKCore::ToIKCore(thighLocation), IKCore::ToIKCore(kneeLocation), IKCore::ToIKCore(footLocation), IKCore::ToIKCore(kneeTarget), IKCore::ToIKCore(effector), hipTranslation.Z);
+}
+
+void FAnimNode_IKFootPlacement::ApplyLeg(FComponentSpacePoseContext& Output, int32 leg, const FBoneReference& footBone, const FVector& hipTranslation, TArray<FBoneTransform>& OutBoneTransforms) const
+{
+	// Get the leg chain.
+	const FBoneContainer& boneContainer = Output.Pose.GetPose().GetBoneContainer();
+	FCompactPoseBoneIndex footIndex = footBone.GetCompactPoseIndex(boneContainer);
+	FCompactPoseBoneIndex kneeIndex = boneContainer.GetParentBoneIndex(footIndex);
+	FCompactPoseBoneIndex thighIndex = boneContainer.GetParentBoneIndex(kneeIndex);
+	FTransform thighTransform = Output.Pose.GetComponentSpaceTransform(thighIndex);
+	FTransform kneeTransform = Output.Pose.GetComponentSpaceTransform(kneeIndex);
+	FTransform footTransform = Output.Pose.GetComponentSpaceTransform(footIndex);
+
+	// Rotate the thigh and knee onto the solve and place the knee and foot.
+	thighTransform.AddToTranslation(hipTranslation);
+	thighTransform.SetRotation(IKCore::ToEngine(legBatch.GetUpperRotation(leg)) * thighTransform.GetRotation());
+	kneeTransform.SetRotation(IKCore::ToEngine(legBatch.GetLowerRotation(leg)) * kneeTransform.GetRotation());
+	kneeTransform.SetTranslation(IKCore::ToEngine(legBatch.GetJoint(leg)));
+	footTransform.SetTranslation(IKCore::ToEngine(legBatch.GetEnd(leg)));
+	OutBoneTransforms.Add(FBoneTransform(thighIndex, thighTransform));
+	OutBoneTransforms.Add(FBoneTransform(kneeIndex, kneeTransform));
+	OutBoneTransforms.Add(FBoneTransform(footIndex, footTransform));
+}
+
+bool FAnimNode_IKFootPlacement::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones)
+{
+	if (!pelvisBone.IsValidToEvaluate(RequiredBones) || !leftFootBone.IsValidToEvaluate(RequiredBones) || !rightFootBone.IsValidToEvaluate(RequiredBones)) return false;
+
+	// Both feet need a thigh and a knee above them.
+	for (const FBoneReference* footBone : { &leftFootBone, &rightFootBone })
+	{
+		FCompactPoseBoneIndex kneeIndex = RequiredBones.GetParentBoneIndex(footBone->GetCompactPoseIndex(RequiredBones));
+		if (kneeIndex == INDEX_NONE || RequiredBones.GetParentBoneIndex(kneeIndex) == INDEX_NONE) return false;
+	}
+	return true;
+}
+
+void FAnimNode_IKFootPlacement::InitializeBoneReferences(const FBoneContainer& RequiredBones)
+{
+	pelvisBone.Initialize(RequiredBones);
+	leftFootBone.Initialize(RequiredBones);
+	rightFootBone.Initialize(RequiredBones);
+}
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "BoneControllers/AnimNode_SkeletalControlBase.h"
+#include "IKCoreTwoBone.h"
+#include "AnimNode_IKFootPlacement.generated.h"
+
+/* Native foot placement. Offsets the pelvis by the hip offset and solves both legs as two bone chains onto the floor locations from the IK anim instance.
+ * NOTE: Reads the values copied into the FIKAnimInstanceProxy so the whole solve runs on the animation worker thread. */
+USTRUCT(BlueprintInternalUseOnly)
+struct IKDEMO_API FAnimNode_IKFootPlacement : public FAnimNode_SkeletalControlBase
+{
+	GENERATED_BODY()
+
+public:
+
+	/* The pelvis bone offset by the hip offset. */
+	UPROPERTY(EditAnywhere, Category = "IK")
+	FBoneReference pelvisBone;
+
+	/* The left foot bone, its parent and grandparent are used as the rest of the leg. */
+	UPROPERTY(EditAnywhere, Category = "IK")
+	FBoneReference leftFootBone;
+
+	/* The right foot bone, its parent and grandparent are used as the rest of the leg. */
+	UPROPERTY(EditAnywhere, Category = "IK")
+	FBoneReference rightFootBone;
+
+	/* Component space offset from each knee to bend the leg towards. */
+	UPROPERTY(EditAnywhere, Category = "IK")
+	FVector kneeTargetOffset;
+
+	/* The component space height of the floor in the input animation, the feet are moved by the difference to the traced floor. */
+	UPROPERTY(EditAnywhere, Category = "IK")
+	float animatedFloorHeight;
+
+public:
+
+	/* Constructor. */
+	FAnimNode_IKFootPlacement();
+
+	/* FAnimNode_SkeletalControlBase interface. */
+	virtual void UpdateInternal(const FAnimationUpdateContext& Context) override;
+	virtual void EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms) override;
+	virtual bool IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones) override;
+
+private:
+
+	/* FAnimNode_SkeletalControlBase interface. */
+	virtual void InitializeBoneReferences(const FBoneContainer& RequiredBones) override;
+
+	/* Adds one legs animated chain, knee target and foot effector to the leg batch. */
+	void GatherLeg(FComponentSpacePoseContext& Output, int32 leg, const FBoneReference& footBone, const FVector& floorLocation, const FVector& hipTranslation);
+
+	/* Applies one legs solve from the leg batch, adding the resulting thigh, calf and foot transforms to the output. */
+	void ApplyLeg(FComponentSpacePoseContext& Output, int32 leg, const FBoneReference& footBone, const FVector& hipTranslation, TArray<FBoneTransform>& OutBoneTransforms) const;
+
+private:
+
+	FVector leftFootLocation; /* The world location of the left foot floor this update. */
+	FVector rightFootLocation; /* The world location of the right foot floor this update. */
+	float hipOffset; /* The amount to offset the hips this update. */
+	bool hasIKValues; /* Is the node running in an IK anim instance with its IK turned on? */
+	IKCore::TwoBoneBatch legBatch; /* The left and right legs solved together, kept to reuse its memory. */
+};
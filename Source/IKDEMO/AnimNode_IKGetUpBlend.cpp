@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AnimNode_IKGetUpBlend.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "IKAnimInstance.h"
+
+FAnimNode_IKGetUpBlend::FAnimNode_IKGetUpBlend()
+	: snapshotName(UIKAnimInstance::GetUpSnapshotName)
+	, getUpAlpha(1.0f)
+{
+	//...
+}
+
+void FAnimNode_IKGetUpBlend::Initialize_AnyThread(const FAnimationInitializeContext& Context)
+{
+	FAnimNode_Base::Initialize_AnyThread(Context);
+	source.Initialize(Context);
+}
+
+void FAnimNode_IKGetUpBlend::CacheBones_AnyThread(const FAnimationCacheBonesContext& Context)
+{
+	source.CacheBones(Context);
+}
+
+void FAnimNode_IKGetUpBlend::Update_AnyThread(const FAnimationUpdateContext& Context)
+{
+	GetEvaluateGraphExposedInputs().Execute(Context);
+	source.Update(Context);
+
+	// Read the alpha the proxy copied from the anim instance on the game thread.
+	UObject* animInstance = Context.AnimInstanceProxy->GetAnimInstanceObject();
+	getUpAlpha = animInstance && animInstance->IsA<UIKAnimInstance>() ? static_cast<const FIKAnimInstanceProxy*>(Context.AnimInstanceProxy)->getUpAlpha : 1.0f;
+}
+
+void FAnimNode_IKGetUpBlend::Evaluate_AnyThread(FPoseContext& Output)
+{
+	source.Evaluate(Output);
+	if (getUpAlpha >= 1.0f) return;
+
+	const FPoseSnapshot* snapshot = Output.AnimInstanceProxy->GetPoseSnapshot(snapshotName);
+	if (!snapshot || !snapshot->bIsValid) return;
+
+	// The snapshot is of the same mesh, so its bones are in mesh pose order.
+	const FBoneContainer& boneContainer = Output.Pose.GetBoneContainer();
+	for (FCompactPoseBoneIndex boneIndex : Output.Pose.ForEachBoneIndex())
+	{
+		int32 meshIndex = boneContainer.MakeMeshPoseIndex(boneIndex).GetInt();
+		if (!snapshot->LocalTransforms.IsValidIndex(meshIndex)) continue;
+
+		FTransform sourceTransform = Output.Pose[boneIndex];
+		Output.Pose[boneIndex].Blend(snapshot->LocalTransforms[meshIndex], sourceTransform, getUpAlpha);
+	}
+}
+
+void FAnimNode_IKGetUpBlend::GatherDebugData(FNodeDebugData& DebugData)
+{
+	FString debugLine = DebugData.GetNodeName(this);
+	debugLine += FString::Printf(TEXT("(Snapshot: %s Alpha: %.2f)"), *snapshotName.ToString(), getUpAlpha);
+	DebugData.AddDebugItem(debugLine);
+	source.GatherDebugData(DebugData);
+}
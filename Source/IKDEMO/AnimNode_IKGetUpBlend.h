@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "Animation/AnimNodeBase.h"
+#include "AnimNode_IKGetUpBlend.generated.h"
+
+/* Blends from the pose snapshot taken of the ragdoll to the source pose while the character gets up.
+ * NOTE: Reads the get-up alpha copied into the FIKAnimInstanceProxy so the blend runs on the animation worker thread. */
+USTRUCT(BlueprintInternalUseOnly)
+struct IKDEMO_API FAnimNode_IKGetUpBlend : public FAnimNode_Base
+{
+	GENERATED_BODY()
+
+public:
+
+	/* The pose blended to, such as the locomotion with a get-up montage slot. */
+	UPROPERTY(EditAnywhere, Category = "Links")
+	FPoseLink source;
+
+	/* The pose snapshot blended from. */
+	UPROPERTY(EditAnywhere, Category = "Settings")
+	FName snapshotName;
+
+public:
+
+	/* Constructor. */
+	FAnimNode_IKGetUpBlend();
+
+	/* FAnimNode_Base interface. */
+	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+	virtual void CacheBones_AnyThread(const FAnimationCacheBonesContext& Context) override;
+	virtual void Update_AnyThread(const FAnimationUpdateContext& Context) override;
+	virtual void Evaluate_AnyThread(FPoseContext& Output) override;
+	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+
+private:
+
+	float getUpAlpha; /* How far through the blend this update, 1 is only the source pose. */
+};
@@ -2,7 +2,67 @@
 
 #include "IKAnimInstance.h"
 
-UIKAnimInstance::UIKAnimInstance()
+const FName UIKAnimInstance::GetUpSnapshotName(TEXT("IKGetUp"));
+
+FIKAnimInstanceProxy::FIKAnimInstanceProxy()
+	: FAnimInstanceProxy()
+	, leftFootLocation(FVector::ZeroVector)
+	, rightFootLocation(FVector::ZeroVector)
+	, hipOffset(0.0f)
+	, getUpAlpha(1.0f)
+	, ikEnabled(true)
+	, ikOutput(nullptr)
 {
 	//...
 }
+
+FIKAnimInstanceProxy::FIKAnimInstanceProxy(UAnimInstance* Instance)
+	: FAnimInstanceProxy(Instance)
+	, leftFootLocation(FVector::ZeroVector)
+	, rightFootLocation(FVector::ZeroVector)
+	, hipOffset(0.0f)
+	, getUpAlpha(1.0f)
+	, ikEnabled(true)
+{
+	UIKAnimInstance* IKAnim = Cast<UIKAnimInstance>(Instance);
+	ikOutput = IKAnim ? &IKAnim->ikOutput : nullptr;
+}
+
+void FIKAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	FAnimInstanceProxy::PreUpdate(InAnimInstance, DeltaSeconds);
+	if (!ikOutput) return;
+
+	// Swap in the latest set of values if one has been published, otherwise keep using the last.
+	if (ikOutput->IsDirty()) ikOutput->SwapReadBuffers();
+	const FIKAnimOutput& output = ikOutput->Read();
+	leftFootLocation = output.leftFootLocation;
+	rightFootLocation = output.rightFootLocation;
+	hipOffset = output.hipOffset;
+	getUpAlpha = output.getUpAlpha;
+	ikEnabled = output.ikEnabled;
+
+	// Mirror the values onto the anim instance before its graph runs, so blueprints read this updates IK and not the last ones.
+	UIKAnimInstance* IKAnim = CastChecked<UIKAnimInstance>(InAnimInstance);
+	IKAnim->currentLeftFootLocation = leftFootLocation;
+	IKAnim->currentRightFootLocation = rightFootLocation;
+	IKAnim->currentHipOffset = hipOffset;
+	IKAnim->currentGetUpAlpha = getUpAlpha;
+	IKAnim->currentIKEnabled = ikEnabled;
+}
+
+UIKAnimInstance::UIKAnimInstance()
+{
+	currentGetUpAlpha = 1.0f;
+	currentIKEnabled = true;
+}
+
+FAnimInstanceProxy* UIKAnimInstance::CreateAnimInstanceProxy()
+{
+	return new FIKAnimInstanceProxy(this);
+}
+
+void UIKAnimInstance::DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy)
+{
+	delete static_cast<FIKAnimInstanceProxy*>(InProxy);
+}
@@ -3,8 +3,52 @@
 #pragma once
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Containers/TripleBuffer.h"
 #include "IKAnimInstance.generated.h"
 
+/* The IK values published by the character on the game thread for the animation update to consume. */
+struct FIKAnimOutput
+{
+	FVector leftFootLocation; /* The world location of the left foot floor. */
+	FVector rightFootLocation; /* The world location of the right foot floor. */
+	float hipOffset; /* The amount to offset the hips. */
+	float getUpAlpha; /* How far through blending from the get-up snapshot to the animated pose. */
+	bool ikEnabled; /* Should the foot placement be solved, false while the anim budget has turned the IK off. */
+
+	FIKAnimOutput() : leftFootLocation(FVector::ZeroVector), rightFootLocation(FVector::ZeroVector), hipOffset(0.0f), getUpAlpha(1.0f), ikEnabled(true) {}
+};
+
+/* Anim instance proxy holding a copy of the IK values so they can be read by anim nodes on the animation worker thread. */
+USTRUCT()
+struct IKDEMO_API FIKAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Constructors. */
+	FIKAnimInstanceProxy();
+	FIKAnimInstanceProxy(UAnimInstance* Instance);
+
+public:
+
+	FVector leftFootLocation; /* The world location of the left foot floor, consumed from the anim instances IK output. */
+	FVector rightFootLocation; /* The world location of the right foot floor, consumed from the anim instances IK output. */
+	float hipOffset; /* The amount to offset the hips, consumed from the anim instances IK output. */
+	float getUpAlpha; /* How far through blending from the get-up snapshot to the animated pose, consumed from the anim instances IK output. */
+	bool ikEnabled; /* Should the foot placement be solved, consumed from the anim instances IK output. */
+
+protected:
+
+	/* Takes the latest published IK output and copies it onto the anim instance, on the game thread before the anim graph reads either. */
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+
+private:
+
+	TTripleBuffer<FIKAnimOutput>* ikOutput; /* The IK output of the anim instance, null if the instance is not a UIKAnimInstance. */
+};
+
 /* IK anim instance class to hold some C++ updated variables for the MainPlayer class. */
 UCLASS()
 class IKDEMO_API UIKAnimInstance : public UAnimInstance
@@ -16,17 +60,46 @@ public:
 	/* Constructor. */
 	UIKAnimInstance();
 
+	/* Publishes new IK values for the next animation update. Lock free, the animation update always sees a whole set of values.
+	 * NOTE: Game thread only, the IK anim instance proxy is the only consumer. */
+	void PublishIKOutput(const FIKAnimOutput& output) { ikOutput.Write(output); }
+
 public:
 
-	/* The current world location of the left foot. */
+	/* The world location of the left foot used by this animation update. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
 	FVector currentLeftFootLocation;
 
-	/* The current world location of the right foot. */
+	/* The world location of the right foot used by this animation update. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
 	FVector currentRightFootLocation;
 
-	/* The amount to offset the hips. */
+	/* The hip offset used by this animation update. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
 	float currentHipOffset;
+
+	/* How far through blending from the get-up snapshot to the animated pose used by this animation update, 1 when not getting up. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+	float currentGetUpAlpha;
+
+	/* Is the foot placement solved by this animation update? */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+	bool currentIKEnabled;
+
+	/* The name of the pose snapshot taken of the ragdoll when getting up. */
+	static const FName GetUpSnapshotName;
+
+protected:
+
+	/* Creates the IK proxy used by the animation worker thread. */
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+
+	/* Destroys the IK proxy. */
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override;
+
+private:
+
+	friend struct FIKAnimInstanceProxy;
+
+	TTripleBuffer<FIKAnimOutput> ikOutput; /* The IK values published by the character and consumed by the proxy. */
 };
@@ -0,0 +1,330 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKBenchmarkGameMode.h"
+#include "UObject/ConstructorHelpers.h"
+#include "AIController.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "Components/StaticMeshComponent.h"
+#include "GameFramework/SpectatorPawn.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Engine/NetDriver.h"
+#include "MainPlayer.h"
+#include "IKBenchmarkPlayerController.h"
+#include "IKSettings.h"
+#include "IKProfiling.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogIKBenchmark, Log, All);
+
+/* How long in seconds to wait for the remote clients to report their results before writing without them. */
+static const double ClientReportTimeout = 10.0;
+
+/* The length of the scripted input loop in frames. Each character is offset into it so they do not all move at once. */
+static const int32 ScriptedInputLoopFrames = 240;
+
+AIKBenchmarkGameMode::AIKBenchmarkGameMode()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// The players only spectate, remote clients measure themselves.
+	DefaultPawnClass = ASpectatorPawn::StaticClass();
+	PlayerControllerClass = AIKBenchmarkPlayerController::StaticClass();
+
+	// Setup default assets.
+	static ConstructorHelpers::FClassFinder<AMainPlayer> playerClassFinder(TEXT("/Game/DemoAssets/Character/BP_Player"));
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> cubeFinder(TEXT("/Engine/BasicShapes/Cube.Cube"));
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> stairFinder(TEXT("/Game/DemoAssets/Static/Linear_Stair_StaticMesh.Linear_Stair_StaticMesh"));
+	characterClass = playerClassFinder.Class;
+	cubeMesh = cubeFinder.Object;
+	stairMesh = stairFinder.Object;
+
+	// Setup default benchmark variables.
+	numCharacters = 200;
+	numFrames = 1000;
+	numWarmupFrames = 60;
+	numClients = 0;
+	benchmarkOrigin = FVector(0.0f, 0.0f, -20000.0f);
+	keepIKLOD = false;
+	frameCount = 0;
+	measureStartTime = 0.0;
+	gameThreadMilliseconds = 0.0;
+	measuredSeconds = 0.0;
+	waitingForClients = false;
+	waitingForReports = false;
+	reportsRequestTime = 0.0;
+}
+
+void AIKBenchmarkGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	// Read the benchmark options.
+	const TCHAR* commandLine = FCommandLine::Get();
+	FParse::Value(commandLine, TEXT("IKBenchmarkCharacters="), numCharacters);
+	FParse::Value(commandLine, TEXT("IKBenchmarkFrames="), numFrames);
+	FParse::Value(commandLine, TEXT("IKBenchmarkWarmup="), numWarmupFrames);
+	FParse::Value(commandLine, TEXT("IKBenchmarkClients="), numClients);
+	waitingForClients = numClients > 0;
+	keepIKLOD = FParse::Param(commandLine, TEXT("IKBenchmarkLOD"));
+	if (!FParse::Value(commandLine, TEXT("IKBenchmarkOutput="), outputPath)) outputPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("IKBenchmark.json");
+
+	// Nothing is rendered with -nullrhi, so unless asked for keep every character at full IK.
+	if (!keepIKLOD)
+	{
+		UIKSettings* settings = GetMutableDefault<UIKSettings>();
+		settings->freezeIKWhenNotRendered = false;
+		settings->reducedIKDistance = MAX_FLT;
+		settings->frozenIKDistance = MAX_FLT;
+	}
+}
+
+void AIKBenchmarkGameMode::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (!characterClass || !cubeMesh || !stairMesh)
+	{
+		UE_LOG(LogIKBenchmark, Error, TEXT("IK benchmark is missing its character class or meshes."));
+		FPlatformMisc::RequestExit(false);
+		return;
+	}
+
+	// Flat ground.
+	const float areaExtent = 1500.0f;
+	const float cubeExtent = cubeMesh->GetBounds().BoxExtent.X;
+	FVector flatCenter = benchmarkOrigin;
+	SpawnGeometry(cubeMesh, flatCenter, FRotator::ZeroRotator, FVector(areaExtent / cubeExtent, areaExtent / cubeExtent, 1.0f));
+
+	// Stairs, on top of ground to catch anyone that walks off them.
+	FVector stairCenter = benchmarkOrigin + FVector(areaExtent * 3.0f, 0.0f, 0.0f);
+	SpawnGeometry(cubeMesh, stairCenter, FRotator::ZeroRotator, FVector(areaExtent / cubeExtent, areaExtent / cubeExtent, 1.0f));
+	FBoxSphereBounds stairBounds = stairMesh->GetBounds();
+	FVector stairLocation = stairCenter + FVector(0.0f, 0.0f, cubeExtent) - stairBounds.Origin + FVector(0.0f, 0.0f, stairBounds.BoxExtent.Z);
+	SpawnGeometry(stairMesh, stairLocation, FRotator::ZeroRotator, FVector::OneVector);
+
+	// Slope, on top of ground to catch anyone that walks off it.
+	const float slopeAngle = 20.0f;
+	FVector slopeCenter = benchmarkOrigin - FVector(areaExtent * 3.0f, 0.0f, 0.0f);
+	SpawnGeometry(cubeMesh, slopeCenter, FRotator::ZeroRotator, FVector(areaExtent / cubeExtent, areaExtent / cubeExtent, 1.0f));
+	SpawnGeometry(cubeMesh, slopeCenter + FVector(0.0f, 0.0f, areaExtent * 0.5f * FMath::Sin(FMath::DegreesToRadians(slopeAngle))), FRotator(slopeAngle, 0.0f, 0.0f), FVector(areaExtent * 0.5f / cubeExtent, areaExtent * 0.5f / cubeExtent, 1.0f));
+
+	// Split the characters between the three areas.
+	int32 perArea = numCharacters / 3;
+	SpawnCharacters(numCharacters - perArea * 2, flatCenter + FVector(0.0f, 0.0f, cubeExtent), areaExtent * 0.8f);
+	SpawnCharacters(perArea, stairLocation + FVector(0.0f, 0.0f, stairBounds.BoxExtent.Z), FMath::Min(stairBounds.BoxExtent.X, stairBounds.BoxExtent.Y));
+	SpawnCharacters(perArea, slopeCenter + FVector(0.0f, 0.0f, areaExtent * FMath::Sin(FMath::DegreesToRadians(slopeAngle))), areaExtent * 0.4f);
+
+	UE_LOG(LogIKBenchmark, Display, TEXT("IK benchmark started: %d characters, %d frames after %d warmup frames."), characters.Num(), numFrames, numWarmupFrames);
+}
+
+void AIKBenchmarkGameMode::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// Hold the benchmark until every remote client has joined.
+	if (waitingForClients)
+	{
+		if (GetNumRemoteClients() < numClients) return;
+		waitingForClients = false;
+		UE_LOG(LogIKBenchmark, Display, TEXT("IK benchmark clients joined: %d."), GetNumRemoteClients());
+	}
+
+	// Write the results once the clients have reported theirs.
+	if (waitingForReports)
+	{
+		bool allReported = true;
+		for (FConstPlayerControllerIterator it = GetWorld()->GetPlayerControllerIterator(); it; ++it)
+		{
+			AIKBenchmarkPlayerController* controller = Cast<AIKBenchmarkPlayerController>(it->Get());
+			if (controller && !controller->IsLocalController() && !controller->HasReportedStats()) allReported = false;
+		}
+		if (allReported || FPlatformTime::Seconds() - reportsRequestTime >= ClientReportTimeout) WriteResults();
+		return;
+	}
+
+	// Drive the characters.
+	frameCount++;
+	UpdateScriptedInput(frameCount);
+
+	// Start measuring once the warmup is over, the game thread time is always that of the last frame.
+	if (frameCount == numWarmupFrames)
+	{
+		FIKProfileTimers::Reset();
+		FIKProfileTimers::enabled = true;
+		measureStartTime = FPlatformTime::Seconds();
+		for (FConstPlayerControllerIterator it = GetWorld()->GetPlayerControllerIterator(); it; ++it)
+		{
+			AIKBenchmarkPlayerController* controller = Cast<AIKBenchmarkPlayerController>(it->Get());
+			if (controller && !controller->IsLocalController()) controller->ClientStartMeasuring();
+		}
+	}
+	else if (frameCount > numWarmupFrames)
+	{
+		gameThreadMilliseconds += FPlatformTime::ToMilliseconds(GGameThreadTime);
+		for (FConstPlayerControllerIterator it = GetWorld()->GetPlayerControllerIterator(); it; ++it)
+		{
+			AIKBenchmarkPlayerController* controller = Cast<AIKBenchmarkPlayerController>(it->Get());
+			if (controller && !controller->IsLocalController()) controller->SampleBandwidth();
+		}
+	}
+
+	if (frameCount == numWarmupFrames + numFrames) FinishBenchmark();
+}
+
+void AIKBenchmarkGameMode::SpawnGeometry(UStaticMesh* mesh, const FVector& location, const FRotator& rotation, const FVector& scale)
+{
+	// Set the mesh before the actor finishes spawning so its static collision is built with it.
+	FTransform transform(rotation, location, scale);
+	AStaticMeshActor* meshActor = GetWorld()->SpawnActorDeferred<AStaticMeshActor>(AStaticMeshActor::StaticClass(), transform);
+	meshActor->GetStaticMeshComponent()->SetStaticMesh(mesh);
+	UGameplayStatics::FinishSpawningActor(meshActor, transform);
+}
+
+void AIKBenchmarkGameMode::SpawnCharacters(int32 count, const FVector& center, float extent)
+{
+	if (count <= 0) return;
+
+	// Lay the characters out on a grid dropped onto the area.
+	int32 side = FMath::CeilToInt(FMath::Sqrt((float)count));
+	float spacing = side > 1 ? extent * 2.0f / (side - 1) : 0.0f;
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	for (int32 i = 0; i < count; i++)
+	{
+		FVector location = center + FVector(-extent + (i % side) * spacing, -extent + (i / side) * spacing, 150.0f);
+		FRotator rotation(0.0f, (i * 37) % 360, 0.0f);
+		AMainPlayer* character = GetWorld()->SpawnActor<AMainPlayer>(characterClass, location, rotation, spawnParams);
+		if (!character) continue;
+
+		// An AI controller lets the scripted input move the character.
+		character->AIControllerClass = AAIController::StaticClass();
+		character->SpawnDefaultController();
+		characters.Add(character);
+	}
+}
+
+void AIKBenchmarkGameMode::UpdateScriptedInput(int32 frame)
+{
+	// Each character idles, walks forward, walks right, then idles again.
+	for (int32 i = 0; i < characters.Num(); i++)
+	{
+		if (!characters[i]) continue;
+		int32 loopFrame = (frame + i * 37) % ScriptedInputLoopFrames;
+		float forward = loopFrame >= 120 && loopFrame < 160 ? 1.0f : 0.0f;
+		float right = loopFrame >= 160 && loopFrame < 200 ? 1.0f : 0.0f;
+		characters[i]->SetScriptedInput(forward, right);
+	}
+}
+
+int32 AIKBenchmarkGameMode::GetNumRemoteClients() const
+{
+	UNetDriver* netDriver = GetWorld()->GetNetDriver();
+	return netDriver ? netDriver->ClientConnections.Num() : 0;
+}
+
+void AIKBenchmarkGameMode::FinishBenchmark()
+{
+	FIKProfileTimers::enabled = false;
+	measuredSeconds = FPlatformTime::Seconds() - measureStartTime;
+
+	// Ask the remote clients for their results, written once they have all reported.
+	if (GetNumRemoteClients() > 0)
+	{
+		for (FConstPlayerControllerIterator it = GetWorld()->GetPlayerControllerIterator(); it; ++it)
+		{
+			AIKBenchmarkPlayerController* controller = Cast<AIKBenchmarkPlayerController>(it->Get());
+			if (controller && !controller->IsLocalController()) controller->ClientFinishMeasuring();
+		}
+		waitingForReports = true;
+		reportsRequestTime = FPlatformTime::Seconds();
+		return;
+	}
+
+	WriteResults();
+}
+
+void AIKBenchmarkGameMode::WriteResults()
+{
+	waitingForReports = false;
+	int32 measuredFrames = FMath::Max(numFrames, 1);
+
+	// Setup the results.
+	TSharedRef<FJsonObject> results = MakeShared<FJsonObject>();
+	results->SetNumberField(TEXT("characters"), characters.Num());
+	results->SetNumberField(TEXT("frames"), numFrames);
+	results->SetNumberField(TEXT("warmupFrames"), numWarmupFrames);
+	results->SetBoolField(TEXT("ikLOD"), keepIKLOD);
+	results->SetStringField(TEXT("footTraceMode"), StaticEnum<EIKFootTraceMode>()->GetNameStringByValue((int64)UIKSettings::Get()->footTraceMode));
+	results->SetNumberField(TEXT("frameTimeMs"), measuredSeconds * 1000.0 / measuredFrames);
+	results->SetNumberField(TEXT("gameThreadTimeMs"), gameThreadMilliseconds / measuredFrames);
+
+	// Time spent in each section of the IK path.
+	TSharedRef<FJsonObject> sections = MakeShared<FJsonObject>();
+	for (int32 i = 0; i < (int32)EIKProfileSection::Count; i++)
+	{
+		TSharedRef<FJsonObject> section = MakeShared<FJsonObject>();
+		section->SetNumberField(TEXT("totalMs"), FIKProfileTimers::seconds[i] * 1000.0);
+		section->SetNumberField(TEXT("perFrameMs"), FIKProfileTimers::seconds[i] * 1000.0 / measuredFrames);
+		section->SetNumberField(TEXT("calls"), (double)FIKProfileTimers::calls[i]);
+		sections->SetObjectField(FIKProfileTimers::GetSectionName((EIKProfileSection)i), section);
+	}
+	results->SetObjectField(TEXT("sections"), sections);
+	results->SetNumberField(TEXT("traces"), (double)FIKProfileTimers::traces);
+	results->SetNumberField(TEXT("tracesPerFrame"), (double)FIKProfileTimers::traces / measuredFrames);
+
+	// IK replication from this machine and the bandwidth and timings of each remote client.
+	TSharedRef<FJsonObject> network = MakeShared<FJsonObject>();
+	network->SetNumberField(TEXT("netStates"), (double)FIKProfileTimers::netStates);
+	network->SetNumberField(TEXT("netStatePayloadBytesPerFrame"), (double)FIKProfileTimers::netStates * FIKNetState::NumBytes / measuredFrames);
+	TArray<TSharedPtr<FJsonValue>> clients;
+	for (FConstPlayerControllerIterator it = GetWorld()->GetPlayerControllerIterator(); it; ++it)
+	{
+		AIKBenchmarkPlayerController* controller = Cast<AIKBenchmarkPlayerController>(it->Get());
+		if (!controller || controller->IsLocalController()) continue;
+
+		TSharedRef<FJsonObject> client = MakeShared<FJsonObject>();
+		client->SetNumberField(TEXT("outBytesPerSecond"), controller->GetAverageOutBytesPerSecond());
+		client->SetNumberField(TEXT("inBytesPerSecond"), controller->GetAverageInBytesPerSecond());
+		client->SetBoolField(TEXT("reported"), controller->HasReportedStats());
+		const FIKBenchmarkClientStats& stats = controller->GetReportedStats();
+		client->SetNumberField(TEXT("frames"), stats.frames);
+		client->SetNumberField(TEXT("frameTimeMs"), stats.frameTimeMs);
+		client->SetNumberField(TEXT("gameThreadTimeMs"), stats.gameThreadTimeMs);
+		client->SetNumberField(TEXT("ikTickMs"), stats.ikTickMs);
+		client->SetNumberField(TEXT("tracesPerFrame"), stats.tracesPerFrame);
+		client->SetNumberField(TEXT("netStatesPerFrame"), stats.netStatesPerFrame);
+		clients.Add(MakeShared<FJsonValueObject>(client));
+	}
+	network->SetArrayField(TEXT("clients"), clients);
+	results->SetObjectField(TEXT("network"), network);
+
+	// Memory use of the whole process.
+	FPlatformMemoryStats memoryStats = FPlatformMemory::GetStats();
+	TSharedRef<FJsonObject> memory = MakeShared<FJsonObject>();
+	memory->SetNumberField(TEXT("usedPhysicalMB"), memoryStats.UsedPhysical / (1024.0 * 1024.0));
+	memory->SetNumberField(TEXT("peakUsedPhysicalMB"), memoryStats.PeakUsedPhysical / (1024.0 * 1024.0));
+	results->SetObjectField(TEXT("memory"), memory);
+
+	// Write the results and quit.
+	FString json;
+	TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&json);
+	FJsonSerializer::Serialize(results, writer);
+	if (FFileHelper::SaveStringToFile(json, *outputPath)) UE_LOG(LogIKBenchmark, Display, TEXT("IK benchmark results written to %s"), *outputPath);
+	else UE_LOG(LogIKBenchmark, Error, TEXT("Could not write IK benchmark results to %s"), *outputPath);
+	UE_LOG(LogIKBenchmark, Display, TEXT("%s"), *json);
+
+	// Let the clients quit with the server.
+	for (FConstPlayerControllerIterator it = GetWorld()->GetPlayerControllerIterator(); it; ++it)
+	{
+		AIKBenchmarkPlayerController* controller = Cast<AIKBenchmarkPlayerController>(it->Get());
+		if (controller && !controller->IsLocalController()) controller->ClientEndBenchmark();
+	}
+	FPlatformMisc::RequestExit(false);
+}
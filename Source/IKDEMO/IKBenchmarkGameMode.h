@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "GameFramework/GameModeBase.h"
+#include "IKBenchmarkGameMode.generated.h"
+
+class AMainPlayer;
+class UStaticMesh;
+
+/* Headless benchmark of the IK characters. Spawns a crowd on flat ground, stairs and slopes, drives them with scripted input
+ * for a fixed number of frames then writes the IK timings as JSON and quits.
+ * Usage: UE4Editor IKDEMO /Game/Maps/LVL_Demo?game=/Script/IKDEMO.IKBenchmarkGameMode -game -nullrhi -unattended -deterministic
+ *        [-IKBenchmarkCharacters=200] [-IKBenchmarkFrames=1000] [-IKBenchmarkWarmup=60] [-IKBenchmarkOutput=Path.json] [-IKBenchmarkLOD]
+ * Network: Add ?listen to the map and -IKBenchmarkClients=N, then start N clients with UE4Editor IKDEMO 127.0.0.1 -game -nullrhi -unattended.
+ *          The benchmark waits for the clients, then adds each clients bandwidth and its own reported IK timings to the results. */
+UCLASS(minimalapi)
+class AIKBenchmarkGameMode : public AGameModeBase
+{
+	GENERATED_BODY()
+
+public:
+
+	/* The IK character spawned. */
+	UPROPERTY(EditAnywhere, Category = "Benchmark")
+	TSubclassOf<AMainPlayer> characterClass;
+
+	/* The mesh used to build the flat ground and slopes. */
+	UPROPERTY(EditAnywhere, Category = "Benchmark")
+	UStaticMesh* cubeMesh;
+
+	/* The mesh used to build the stairs. */
+	UPROPERTY(EditAnywhere, Category = "Benchmark")
+	UStaticMesh* stairMesh;
+
+	/* The number of characters to spawn, split between the flat ground, stairs and slopes. */
+	UPROPERTY(EditAnywhere, Category = "Benchmark")
+	int32 numCharacters;
+
+	/* The number of frames to measure. */
+	UPROPERTY(EditAnywhere, Category = "Benchmark")
+	int32 numFrames;
+
+	/* The number of frames to run before measuring so the characters have landed and settled. */
+	UPROPERTY(EditAnywhere, Category = "Benchmark")
+	int32 numWarmupFrames;
+
+	/* The number of remote clients to wait for before starting. 0 runs without clients. */
+	UPROPERTY(EditAnywhere, Category = "Benchmark")
+	int32 numClients;
+
+	/* Where the benchmark area is built, away from the rest of the level. */
+	UPROPERTY(EditAnywhere, Category = "Benchmark")
+	FVector benchmarkOrigin;
+
+public:
+
+	/* Constructor. */
+	AIKBenchmarkGameMode();
+
+	/* Reads the benchmark options from the command line. */
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
+	/* Frame. */
+	virtual void Tick(float DeltaSeconds) override;
+
+protected:
+
+	/* Builds the benchmark area and spawns the characters. */
+	virtual void BeginPlay() override;
+
+private:
+
+	/* Spawns a static mesh actor to walk on. */
+	void SpawnGeometry(UStaticMesh* mesh, const FVector& location, const FRotator& rotation, const FVector& scale);
+
+	/* Spawns a grid of characters over an area. */
+	void SpawnCharacters(int32 count, const FVector& center, float extent);
+
+	/* Sets each characters scripted input for the given frame. */
+	void UpdateScriptedInput(int32 frame);
+
+	/* Returns the number of remote clients that have joined. */
+	int32 GetNumRemoteClients() const;
+
+	/* Stops measuring and asks the clients for their results. */
+	void FinishBenchmark();
+
+	/* Writes the results and quits. */
+	void WriteResults();
+
+private:
+
+	UPROPERTY()
+	TArray<AMainPlayer*> characters; /* The spawned characters. */
+
+	FString outputPath; /* Where the JSON results are written. */
+	bool keepIKLOD; /* Should the IK LOD settings be kept instead of forcing full IK on every character? */
+	int32 frameCount; /* The number of frames run so far, including the warmup. */
+	double measureStartTime; /* The time measuring started. */
+	double gameThreadMilliseconds; /* The total game thread time of the measured frames. */
+	double measuredSeconds; /* The time the measured frames took. */
+	bool waitingForClients; /* Is the benchmark waiting for its remote clients to join? */
+	bool waitingForReports; /* Is the benchmark waiting for its remote clients to report their results? */
+	double reportsRequestTime; /* The time the clients were asked for their results. */
+};
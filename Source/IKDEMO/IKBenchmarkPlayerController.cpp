@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKBenchmarkPlayerController.h"
+#include "Engine/NetConnection.h"
+#include "IKProfiling.h"
+
+AIKBenchmarkPlayerController::AIKBenchmarkPlayerController()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// Setup default benchmark variables.
+	reportedStats = false;
+	measuring = false;
+	measuredFrames = 0;
+	measureStartTime = 0.0;
+	gameThreadMilliseconds = 0.0;
+	outBytesPerSecondTotal = 0.0;
+	inBytesPerSecondTotal = 0.0;
+	bandwidthSamples = 0;
+}
+
+void AIKBenchmarkPlayerController::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// The game thread time is always that of the last frame.
+	if (measuring)
+	{
+		measuredFrames++;
+		gameThreadMilliseconds += FPlatformTime::ToMilliseconds(GGameThreadTime);
+	}
+}
+
+void AIKBenchmarkPlayerController::ClientStartMeasuring_Implementation()
+{
+	FIKProfileTimers::Reset();
+	FIKProfileTimers::enabled = true;
+	measuring = true;
+	measuredFrames = 0;
+	measureStartTime = FPlatformTime::Seconds();
+	gameThreadMilliseconds = 0.0;
+}
+
+void AIKBenchmarkPlayerController::ClientFinishMeasuring_Implementation()
+{
+	if (!measuring) return;
+	FIKProfileTimers::enabled = false;
+	measuring = false;
+
+	// Average everything over the frames measured here, which can differ from the servers.
+	int32 frames = FMath::Max(measuredFrames, 1);
+	FIKBenchmarkClientStats stats;
+	stats.frames = measuredFrames;
+	stats.frameTimeMs = (FPlatformTime::Seconds() - measureStartTime) * 1000.0 / frames;
+	stats.gameThreadTimeMs = gameThreadMilliseconds / frames;
+	stats.ikTickMs = FIKProfileTimers::seconds[(int32)EIKProfileSection::Tick] * 1000.0 / frames;
+	stats.tracesPerFrame = (double)FIKProfileTimers::traces / frames;
+	stats.netStatesPerFrame = (double)FIKProfileTimers::netStates / frames;
+	ServerReportStats(stats);
+}
+
+void AIKBenchmarkPlayerController::ClientEndBenchmark_Implementation()
+{
+	FPlatformMisc::RequestExit(false);
+}
+
+bool AIKBenchmarkPlayerController::ServerReportStats_Validate(const FIKBenchmarkClientStats& stats)
+{
+	return true;
+}
+
+void AIKBenchmarkPlayerController::ServerReportStats_Implementation(const FIKBenchmarkClientStats& stats)
+{
+	clientStats = stats;
+	reportedStats = true;
+}
+
+void AIKBenchmarkPlayerController::SampleBandwidth()
+{
+	UNetConnection* connection = GetNetConnection();
+	if (!connection) return;
+
+	outBytesPerSecondTotal += connection->OutBytesPerSecond;
+	inBytesPerSecondTotal += connection->InBytesPerSecond;
+	bandwidthSamples++;
+}
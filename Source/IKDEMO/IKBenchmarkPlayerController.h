@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "GameFramework/PlayerController.h"
+#include "IKBenchmarkPlayerController.generated.h"
+
+/* The timings a client measured during a networked IK benchmark, reported back to the server. */
+USTRUCT()
+struct FIKBenchmarkClientStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 frames; /* The number of frames the client measured. */
+
+	UPROPERTY()
+	float frameTimeMs; /* The average frame time. */
+
+	UPROPERTY()
+	float gameThreadTimeMs; /* The average game thread time. */
+
+	UPROPERTY()
+	float ikTickMs; /* The average time spent in the IK characters ticks per frame. */
+
+	UPROPERTY()
+	float tracesPerFrame; /* The average number of IK traces per frame. */
+
+	UPROPERTY()
+	float netStatesPerFrame; /* The average number of IK net states received per frame. */
+
+	FIKBenchmarkClientStats() : frames(0), frameTimeMs(0.0f), gameThreadTimeMs(0.0f), ikTickMs(0.0f), tracesPerFrame(0.0f), netStatesPerFrame(0.0f) {}
+};
+
+/* Player controller used by the IK benchmark. On a listen server each remote client measures its own IK timings when told to
+ * by the server and reports them back, while the server samples the bandwidth of the clients connection. */
+UCLASS()
+class AIKBenchmarkPlayerController : public APlayerController
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Constructor. */
+	AIKBenchmarkPlayerController();
+
+	/* Frame. */
+	virtual void Tick(float DeltaSeconds) override;
+
+	/* Tells the client to start measuring. */
+	UFUNCTION(Client, Reliable)
+	void ClientStartMeasuring();
+
+	/* Tells the client to stop measuring and report its results. */
+	UFUNCTION(Client, Reliable)
+	void ClientFinishMeasuring();
+
+	/* Tells the client the benchmark is over so it can quit. */
+	UFUNCTION(Client, Reliable)
+	void ClientEndBenchmark();
+
+	/* Receives the clients results on the server. */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerReportStats(const FIKBenchmarkClientStats& stats);
+
+	/* Adds this frames bandwidth of the clients connection to the averages. Called on the server each measured frame. */
+	void SampleBandwidth();
+
+	/* Returns the average bytes per second sent to the client. */
+	float GetAverageOutBytesPerSecond() const { return bandwidthSamples > 0 ? outBytesPerSecondTotal / bandwidthSamples : 0.0f; }
+
+	/* Returns the average bytes per second received from the client. */
+	float GetAverageInBytesPerSecond() const { return bandwidthSamples > 0 ? inBytesPerSecondTotal / bandwidthSamples : 0.0f; }
+
+	/* Returns true once the client has reported its results. */
+	bool HasReportedStats() const { return reportedStats; }
+
+	/* Returns the results the client reported. */
+	const FIKBenchmarkClientStats& GetReportedStats() const { return clientStats; }
+
+private:
+
+	FIKBenchmarkClientStats clientStats; /* The results reported by the client, on the server. */
+	bool reportedStats; /* Has the client reported its results? */
+	bool measuring; /* Is the client measuring? */
+	int32 measuredFrames; /* The number of frames measured on the client. */
+	double measureStartTime; /* The time the client started measuring. */
+	double gameThreadMilliseconds; /* The total game thread time of the frames measured on the client. */
+	double outBytesPerSecondTotal, inBytesPerSecondTotal; /* The sum of the bandwidth samples taken on the server. */
+	int32 bandwidthSamples; /* The number of bandwidth samples taken on the server. */
+};
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKBoneCache.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+
+FIKBoneCache::FIKBoneCache()
+{
+	rootIndex = INDEX_NONE;
+	rootBodyIndex = INDEX_NONE;
+	resolved = false;
+}
+
+void FIKBoneCache::SetRootName(FName inRootName)
+{
+	if (rootName == inRootName) return;
+	rootName = inRootName;
+	resolved = false;
+}
+
+void FIKBoneCache::Update(const USkeletalMeshComponent* meshComponent)
+{
+	if (!meshComponent) return;
+
+	// The body index only depends on the physics asset, which is swapped by the ragdoll physics LOD.
+	UPhysicsAsset* currentPhysicsAsset = meshComponent->GetPhysicsAsset();
+	if (!resolved || physicsAsset.Get() != currentPhysicsAsset)
+	{
+		physicsAsset = currentPhysicsAsset;
+		rootBodyIndex = currentPhysicsAsset ? currentPhysicsAsset->FindBodyIndex(rootName) : INDEX_NONE;
+	}
+
+	// Everything else only changes with the mesh or its anim instance.
+	if (resolved && mesh.Get() == meshComponent->SkeletalMesh && animInstance.Get() == meshComponent->GetAnimInstance()) return;
+	mesh = meshComponent->SkeletalMesh;
+	animInstance = meshComponent->GetAnimInstance();
+	resolved = true;
+
+	rootIndex = meshComponent->GetBoneIndex(rootName);
+}
+
+FTransform FIKBoneCache::GetRootTransform(const USkeletalMeshComponent* meshComponent) const
+{
+	return GetComponentSpaceTransform(meshComponent, rootIndex) * meshComponent->GetComponentTransform();
+}
+
+FBodyInstance* FIKBoneCache::GetRootBody(const USkeletalMeshComponent* meshComponent) const
+{
+	return meshComponent->Bodies.IsValidIndex(rootBodyIndex) ? meshComponent->Bodies[rootBodyIndex] : nullptr;
+}
+
+FTransform FIKBoneCache::GetComponentSpaceTransform(const USkeletalMeshComponent* meshComponent, int32 boneIndex)
+{
+	const TArray<FTransform>& componentSpaceTransforms = meshComponent->GetComponentSpaceTransforms();
+	return componentSpaceTransforms.IsValidIndex(boneIndex) ? componentSpaceTransforms[boneIndex] : FTransform::Identity;
+}
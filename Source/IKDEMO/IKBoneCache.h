@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+
+class USkeletalMeshComponent;
+class USkeletalMesh;
+class UAnimInstance;
+class UPhysicsAsset;
+struct FBodyInstance;
+
+/* The bones an IK character queries every frame, resolved from their names once and re-resolved only when the
+ * mesh component changes its skeletal mesh, anim instance or physics asset. Lookups then go straight to the component space
+ * transforms and bodies by index instead of searching by name. */
+class IKDEMO_API FIKBoneCache
+{
+public:
+
+	/* Constructor. */
+	FIKBoneCache();
+
+	/* Sets the root bone name to resolve, clearing the cache if it changed. */
+	void SetRootName(FName inRootName);
+
+	/* Resolves the names again if the mesh component has changed since they were last resolved. */
+	void Update(const USkeletalMeshComponent* meshComponent);
+
+	/* Returns the world transform of the root bone, or the components transform if it was not found. */
+	FTransform GetRootTransform(const USkeletalMeshComponent* meshComponent) const;
+
+	/* Returns the world location of the root bone, or the components location if it was not found. */
+	FVector GetRootLocation(const USkeletalMeshComponent* meshComponent) const { return GetRootTransform(meshComponent).GetLocation(); }
+
+	/* Returns the body simulating the root bone, null if there is none. */
+	FBodyInstance* GetRootBody(const USkeletalMeshComponent* meshComponent) const;
+
+private:
+
+	/* Returns the component space transform of a bone by index, or identity if the index is not valid. */
+	static FTransform GetComponentSpaceTransform(const USkeletalMeshComponent* meshComponent, int32 boneIndex);
+
+private:
+
+	FName rootName; /* The name of the root bone. */
+	int32 rootIndex; /* The root bone index, INDEX_NONE if not found. */
+	int32 rootBodyIndex; /* The index of the root bones body in the physics asset, INDEX_NONE if not found. */
+	TWeakObjectPtr<USkeletalMesh> mesh; /* The skeletal mesh the indices were resolved for. */
+	TWeakObjectPtr<UAnimInstance> animInstance; /* The anim instance running when the indices were resolved. */
+	TWeakObjectPtr<UPhysicsAsset> physicsAsset; /* The physics asset the body index was resolved for. */
+	bool resolved; /* Have the names been resolved? */
+};
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKCharacterMovementComponent.h"
+#include "MainPlayer.h"
+
+UIKCharacterMovementComponent::UIKCharacterMovementComponent()
+{
+	// Ease out of movement when the input is released by braking at a constant rate without friction, stopping from walk speed in half a second.
+	MaxWalkSpeed = 500.0f;
+	BrakingDecelerationWalking = 1000.0f;
+	bUseSeparateBrakingFriction = true;
+	BrakingFriction = 0.0f;
+
+	// Setup default jump settings.
+	jumpForwardImpulse = 50000.0f;
+	lockRotationInAir = true;
+}
+
+bool UIKCharacterMovementComponent::DoJump(bool bReplayingMoves)
+{
+	// The jump changes the movement mode, so check for running before it.
+	bool running = !IsFalling() && !Velocity.IsZero();
+	if (!Super::DoJump(bReplayingMoves)) return false;
+
+	// If the character is running jump forward.
+	if (running && UpdatedComponent) Velocity += UpdatedComponent->GetForwardVector().GetSafeNormal2D() * (jumpForwardImpulse / Mass);
+	return true;
+}
+
+FRotator UIKCharacterMovementComponent::GetDeltaRotation(float DeltaTime) const
+{
+	// When the character is in air do not allow rotation towards movement.
+	if (lockRotationInAir && IsFalling()) return FRotator::ZeroRotator;
+	return Super::GetDeltaRotation(DeltaTime);
+}
+
+void UIKCharacterMovementComponent::RequestDirectMove(const FVector& MoveVelocity, bool bForceMaxSpeed)
+{
+	if (!MoveVelocity.IsZero()) WakeOwner();
+	Super::RequestDirectMove(MoveVelocity, bForceMaxSpeed);
+}
+
+void UIKCharacterMovementComponent::RequestPathMove(const FVector& MoveInput)
+{
+	if (!MoveInput.IsZero()) WakeOwner();
+	Super::RequestPathMove(MoveInput);
+}
+
+void UIKCharacterMovementComponent::WakeOwner() const
+{
+	if (AMainPlayer* mainPlayer = Cast<AMainPlayer>(CharacterOwner)) mainPlayer->WakeUp();
+}
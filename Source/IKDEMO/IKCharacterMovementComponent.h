@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "IKCharacterMovementComponent.generated.h"
+
+/* Character movement for the IK characters. Eases out of movement when input is released, locks rotation in the air and
+ * jumps forward when running, all inside the movement simulation so they are predicted and replayed like any other move. */
+UCLASS()
+class IKDEMO_API UIKCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Constructor. */
+	UIKCharacterMovementComponent();
+
+	/* The impulse applied along the characters forward direction when jumping while running. Divided by Mass like AddImpulse. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Jumping / Falling", meta = (ClampMin = "0"))
+	float jumpForwardImpulse;
+
+	/* Should the character keep its rotation while falling instead of rotating towards its movement? */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Jumping / Falling")
+	bool lockRotationInAir;
+
+	/* Jumps, adding the forward jump impulse when leaving the ground while moving. */
+	virtual bool DoJump(bool bReplayingMoves) override;
+
+	/* Returns no rotation while falling when lockRotationInAir is set. */
+	virtual FRotator GetDeltaRotation(float DeltaTime) const override;
+
+	/* Wakes a sleeping owner before following an AI path with a velocity, as path following does not go through AddMovementInput. */
+	virtual void RequestDirectMove(const FVector& MoveVelocity, bool bForceMaxSpeed) override;
+
+	/* Wakes a sleeping owner before following an AI path with movement input. */
+	virtual void RequestPathMove(const FVector& MoveInput) override;
+
+private:
+
+	/* Wakes the owner if it is a sleeping IK character. */
+	void WakeOwner() const;
+};
@@ -0,0 +1,14 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "IKCoreMath.h"
+
+/* Converts between engine types and the matching IKCore types, which share the same layout. */
+namespace IKCore
+{
+	inline Vector3 ToIKCore(const FVector& vector) { return Vector3(vector.X, vector.Y, vector.Z); }
+	inline Quat ToIKCore(const FQuat& quat) { return Quat(quat.X, quat.Y, quat.Z, quat.W); }
+	inline FVector ToEngine(const Vector3& vector) { return FVector(vector.x, vector.y, vector.z); }
+	inline FQuat ToEngine(const Quat& quat) { return FQuat(quat.x, quat.y, quat.z, quat.w); }
+}
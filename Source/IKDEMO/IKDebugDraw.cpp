@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKDebugDraw.h"
+
+#if IK_DEBUG_DRAW
+
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+/* The number of debug shapes that can be recorded in a frame. */
+static const int32 DebugDrawCapacity = 8192;
+
+/* The number of segments in each circle of a debug capsule. */
+static const int32 CapsuleSegments = 16;
+
+static TAutoConsoleVariable<int32> CVarIKDebugDraw(
+	TEXT("ik.DebugDraw"),
+	0,
+	TEXT("Draws the IK foot traces and capsules.\n")
+	TEXT("0: Off\n")
+	TEXT("1: Characters with debugEnabled set\n")
+	TEXT("2: Every character"),
+	ECVF_Cheat);
+
+FIKDebugDraw::FIKDebugDraw()
+{
+	primitives.SetNumUninitialized(DebugDrawCapacity);
+	first = 0;
+	num = 0;
+}
+
+bool FIKDebugDraw::IsEnabledFor(bool characterDebugEnabled)
+{
+	int32 mode = CVarIKDebugDraw.GetValueOnGameThread();
+	return mode >= 2 || (mode == 1 && characterDebugEnabled);
+}
+
+FIKDebugPrimitive& FIKDebugDraw::AddPrimitive()
+{
+	if (num == DebugDrawCapacity)
+	{
+		// Drop the oldest.
+		FIKDebugPrimitive& primitive = primitives[first];
+		first = (first + 1) % DebugDrawCapacity;
+		return primitive;
+	}
+	return primitives[(first + num++) % DebugDrawCapacity];
+}
+
+void FIKDebugDraw::AddLine(const FVector& start, const FVector& end, const FColor& color, float lifeTime, float thickness)
+{
+	FIKDebugPrimitive& primitive = AddPrimitive();
+	primitive.shape = EIKDebugShape::Line;
+	primitive.location = start;
+	primitive.end = end;
+	primitive.thickness = thickness;
+	primitive.lifeTime = lifeTime;
+	primitive.color = color;
+}
+
+void FIKDebugDraw::AddPoint(const FVector& location, float size, const FColor& color, float lifeTime)
+{
+	FIKDebugPrimitive& primitive = AddPrimitive();
+	primitive.shape = EIKDebugShape::Point;
+	primitive.location = location;
+	primitive.size = size;
+	primitive.lifeTime = lifeTime;
+	primitive.color = color;
+}
+
+void FIKDebugDraw::AddCapsule(const FVector& center, float halfHeight, float radius, const FColor& color, float lifeTime, float thickness)
+{
+	FIKDebugPrimitive& primitive = AddPrimitive();
+	primitive.shape = EIKDebugShape::Capsule;
+	primitive.location = center;
+	primitive.size = radius;
+	primitive.thickness = thickness;
+	primitive.halfHeight = halfHeight;
+	primitive.lifeTime = lifeTime;
+	primitive.color = color;
+}
+
+void FIKDebugDraw::Flush(UWorld* world)
+{
+	if (num == 0) return;
+	if (!world || !world->LineBatcher || !world->PersistentLineBatcher)
+	{
+		first = num = 0;
+		return;
+	}
+
+	// Build every shape into lines and points, shapes that stay drawn go to the persistent line batcher like DrawDebugLine.
+	lines.Reset();
+	persistentLines.Reset();
+	for (int32 i = 0; i < num; i++)
+	{
+		const FIKDebugPrimitive& primitive = primitives[(first + i) % DebugDrawCapacity];
+		ULineBatchComponent* lineBatcher = primitive.lifeTime > 0.0f ? world->PersistentLineBatcher : world->LineBatcher;
+		TArray<FBatchedLine>& batchLines = primitive.lifeTime > 0.0f ? persistentLines : lines;
+		switch (primitive.shape)
+		{
+		case EIKDebugShape::Line:
+			batchLines.Add(FBatchedLine(primitive.location, primitive.end, primitive.color, primitive.lifeTime, primitive.thickness, SDPG_World));
+			break;
+		case EIKDebugShape::Point:
+			lineBatcher->BatchedPoints.Add(FBatchedPoint(primitive.location, primitive.color, primitive.size, primitive.lifeTime, SDPG_World));
+			break;
+		case EIKDebugShape::Capsule:
+			AddCapsuleLines(primitive, batchLines);
+			break;
+		}
+	}
+
+	// Submit each batch at once.
+	world->LineBatcher->DrawLines(lines);
+	world->PersistentLineBatcher->DrawLines(persistentLines);
+	world->LineBatcher->MarkRenderStateDirty();
+	world->PersistentLineBatcher->MarkRenderStateDirty();
+	first = num = 0;
+}
+
+void FIKDebugDraw::AddCapsuleLines(const FIKDebugPrimitive& capsule, TArray<FBatchedLine>& outLines)
+{
+	const float radius = capsule.size;
+	const FVector cylinderOffset(0.0f, 0.0f, FMath::Max(capsule.halfHeight - radius, 0.0f));
+	const FVector top = capsule.location + cylinderOffset;
+	const FVector bottom = capsule.location - cylinderOffset;
+	auto addLine = [&](const FVector& start, const FVector& end)
+	{
+		outLines.Add(FBatchedLine(start, end, capsule.color, capsule.lifeTime, capsule.thickness, SDPG_World));
+	};
+
+	// Rings around the top and bottom of the cylinder.
+	for (int32 i = 0; i < CapsuleSegments; i++)
+	{
+		float angleA = 2.0f * PI * i / CapsuleSegments;
+		float angleB = 2.0f * PI * (i + 1) / CapsuleSegments;
+		FVector offsetA(FMath::Cos(angleA) * radius, FMath::Sin(angleA) * radius, 0.0f);
+		FVector offsetB(FMath::Cos(angleB) * radius, FMath::Sin(angleB) * radius, 0.0f);
+		addLine(top + offsetA, top + offsetB);
+		addLine(bottom + offsetA, bottom + offsetB);
+	}
+
+	// Sides of the cylinder and half circles over each end along X and Y.
+	for (const FVector& axis : { FVector::ForwardVector, FVector::RightVector })
+	{
+		addLine(top + axis * radius, bottom + axis * radius);
+		addLine(top - axis * radius, bottom - axis * radius);
+		for (int32 i = 0; i < CapsuleSegments / 2; i++)
+		{
+			float angleA = PI * i / (CapsuleSegments / 2);
+			float angleB = PI * (i + 1) / (CapsuleSegments / 2);
+			FVector offsetA = axis * FMath::Cos(angleA) * radius;
+			FVector offsetB = axis * FMath::Cos(angleB) * radius;
+			FVector upA(0.0f, 0.0f, FMath::Sin(angleA) * radius);
+			FVector upB(0.0f, 0.0f, FMath::Sin(angleB) * radius);
+			addLine(top + offsetA + upA, top + offsetB + upB);
+			addLine(bottom + offsetA - upA, bottom + offsetB - upB);
+		}
+	}
+}
+
+#endif
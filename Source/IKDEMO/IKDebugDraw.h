@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+
+/* Should the IK debug drawing be compiled in? Never in shipping or test builds. */
+#define IK_DEBUG_DRAW !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
+
+#if IK_DEBUG_DRAW
+
+#include "Components/LineBatchComponent.h"
+
+class UWorld;
+
+/* The shapes the IK debug drawing can record. */
+enum class EIKDebugShape : uint8
+{
+	Line,
+	Point,
+	Capsule
+};
+
+/* A recorded debug shape. */
+struct FIKDebugPrimitive
+{
+	EIKDebugShape shape;
+	FVector location; /* Line start, point or capsule centre. */
+	FVector end; /* Line end. */
+	float size; /* Point size or capsule radius. */
+	float halfHeight; /* Capsule half height. */
+	float thickness; /* Line thickness. */
+	float lifeTime; /* How long the shape stays drawn, 0 for one frame. */
+	FColor color;
+};
+
+/* Records the IK debug shapes of every character into a fixed size ring buffer and draws them all once per frame.
+ * What is recorded is set by the ik.DebugDraw console variable. When the buffer is full the oldest shapes are dropped. */
+class IKDEMO_API FIKDebugDraw
+{
+public:
+
+	/* Constructor. */
+	FIKDebugDraw();
+
+	/* Returns true if a character with the given debugEnabled value should record debug shapes. */
+	static bool IsEnabledFor(bool characterDebugEnabled);
+
+	/* Records a line. */
+	void AddLine(const FVector& start, const FVector& end, const FColor& color, float lifeTime = 0.0f, float thickness = 0.0f);
+
+	/* Records a point. */
+	void AddPoint(const FVector& location, float size, const FColor& color, float lifeTime = 0.0f);
+
+	/* Records an upright capsule. */
+	void AddCapsule(const FVector& center, float halfHeight, float radius, const FColor& color, float lifeTime = 0.0f, float thickness = 0.0f);
+
+	/* Draws everything recorded since the last flush in one batch per line batcher and empties the buffer. */
+	void Flush(UWorld* world);
+
+private:
+
+	/* Returns the next primitive to record into, overwriting the oldest if the buffer is full. */
+	FIKDebugPrimitive& AddPrimitive();
+
+	/* Adds the lines outlining an upright capsule. */
+	static void AddCapsuleLines(const FIKDebugPrimitive& capsule, TArray<FBatchedLine>& outLines);
+
+private:
+
+	TArray<FIKDebugPrimitive> primitives; /* The ring buffer, allocated once at its full size. */
+	int32 first; /* Index of the oldest recorded primitive. */
+	int32 num; /* Number of recorded primitives. */
+	TArray<FBatchedLine> lines, persistentLines; /* Reused lines built by the flush for each line batcher. */
+};
+
+#endif
@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKFloorHeightfield.h"
+#include "HAL/PlatformFilemanager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Engine/World.h"
+
+FIKFloorHeightfield::FIKFloorHeightfield()
+	: mappedFile(nullptr)
+	, mappedRegion(nullptr)
+	, header(nullptr)
+	, samples(nullptr)
+{
+	//...
+}
+
+FIKFloorHeightfield::~FIKFloorHeightfield()
+{
+	delete mappedRegion;
+	delete mappedFile;
+}
+
+TUniquePtr<FIKFloorHeightfield> FIKFloorHeightfield::Load(const FString& path)
+{
+	TUniquePtr<FIKFloorHeightfield> heightfield(new FIKFloorHeightfield());
+	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!platformFile.FileExists(*path)) return nullptr;
+
+	// Map the file so only the pages under the characters are ever read in.
+	heightfield->mappedFile = platformFile.OpenMapped(*path);
+	if (heightfield->mappedFile)
+	{
+		heightfield->mappedRegion = heightfield->mappedFile->MapRegion(0, heightfield->mappedFile->GetFileSize());
+		if (heightfield->mappedRegion && heightfield->SetData(heightfield->mappedRegion->GetMappedPtr(), heightfield->mappedRegion->GetMappedSize())) return heightfield;
+		return nullptr;
+	}
+
+	// Otherwise read the whole file.
+	if (!FFileHelper::LoadFileToArray(heightfield->loadedData, *path)) return nullptr;
+	if (!heightfield->SetData(heightfield->loadedData.GetData(), heightfield->loadedData.Num())) return nullptr;
+	return heightfield;
+}
+
+bool FIKFloorHeightfield::Save(const FString& path, const FIKHeightfieldHeader& header, const TArray<FIKHeightfieldSample>& samples)
+{
+	TArray<uint8> data;
+	data.Append((const uint8*)&header, sizeof(FIKHeightfieldHeader));
+	data.Append((const uint8*)samples.GetData(), samples.Num() * sizeof(FIKHeightfieldSample));
+	return FFileHelper::SaveArrayToFile(data, *path);
+}
+
+FString FIKFloorHeightfield::GetPathForWorld(const UWorld* world)
+{
+	// Heightfields are staged as loose files next to the content, named after the map.
+	FString mapName = UWorld::RemovePIEPrefix(FPackageName::GetShortName(world->GetOutermost()->GetName()));
+	return FPaths::ProjectContentDir() / TEXT("IKHeightfields") / mapName + TEXT(".ikhf");
+}
+
+FIKHeightfieldSample FIKFloorHeightfield::PackSample(const FIKHeightfieldHeader& header, float height, const FVector& normal)
+{
+	FIKHeightfieldSample sample;
+	sample.height = (int16)FMath::Clamp(FMath::RoundToInt((height - header.originZ) / header.heightStep), MIN_int16 + 1, (int32)MAX_int16);
+	sample.normalX = (int8)FMath::RoundToInt(FMath::Clamp(normal.X, -1.0f, 1.0f) * 127.0f);
+	sample.normalY = (int8)FMath::RoundToInt(FMath::Clamp(normal.Y, -1.0f, 1.0f) * 127.0f);
+	return sample;
+}
+
+bool FIKFloorHeightfield::Query(const FVector& start, float maxDrop, float radius, FVector& outLocation) const
+{
+	// Find the cell under the start.
+	int32 x = FMath::FloorToInt((start.X - header->originX) / header->cellSize);
+	int32 y = FMath::FloorToInt((start.Y - header->originY) / header->cellSize);
+	if (x < 0 || y < 0 || x >= header->sizeX || y >= header->sizeY) return false;
+
+	// Find the highest floor layer below the start that the sphere reaches.
+	outLocation = FVector::ZeroVector;
+	const FIKHeightfieldSample* cell = samples + ((int64)y * header->sizeX + x) * header->numLayers;
+	for (int32 layer = 0; layer < header->numLayers && cell[layer].height != EmptyHeight; layer++)
+	{
+		float floorHeight = header->originZ + cell[layer].height * header->heightStep;
+		if (floorHeight > start.Z) continue;
+
+		// The sphere touches a sloped floor higher up its centre line than a flat one.
+		float normalX = cell[layer].normalX / 127.0f;
+		float normalY = cell[layer].normalY / 127.0f;
+		float normalZ = FMath::Sqrt(FMath::Max(1.0f - normalX * normalX - normalY * normalY, KINDA_SMALL_NUMBER));
+		float sphereZ = FMath::Min(floorHeight + radius / normalZ, start.Z);
+		if (sphereZ < start.Z - maxDrop) break;
+
+		outLocation = FVector(start.X, start.Y, sphereZ);
+		break;
+	}
+	return true;
+}
+
+bool FIKFloorHeightfield::SetData(const uint8* data, int64 size)
+{
+	if (!data || size < (int64)sizeof(FIKHeightfieldHeader)) return false;
+
+	// Check the header matches this version and the samples are all there.
+	const FIKHeightfieldHeader* fileHeader = (const FIKHeightfieldHeader*)data;
+	if (fileHeader->magic != Magic || fileHeader->version != Version || fileHeader->sizeX <= 0 || fileHeader->sizeY <= 0 || fileHeader->numLayers <= 0 || fileHeader->cellSize <= 0.0f) return false;
+	int64 numSamples = (int64)fileHeader->sizeX * fileHeader->sizeY * fileHeader->numLayers;
+	if (size < (int64)sizeof(FIKHeightfieldHeader) + numSamples * (int64)sizeof(FIKHeightfieldSample)) return false;
+
+	header = fileHeader;
+	samples = (const FIKHeightfieldSample*)(data + sizeof(FIKHeightfieldHeader));
+	return true;
+}
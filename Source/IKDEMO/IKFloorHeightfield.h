@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/* Header at the start of a baked floor heightfield file. */
+struct FIKHeightfieldHeader
+{
+	uint32 magic; /* Always FIKFloorHeightfield::Magic. */
+	uint32 version; /* Always FIKFloorHeightfield::Version. */
+	float originX, originY, originZ; /* World location of the minimum corner of the grid. */
+	float cellSize; /* The world size of a grid cell along X and Y. */
+	float heightStep; /* The world height of one step of a quantised sample height. */
+	int32 sizeX, sizeY; /* The number of cells along X and Y. */
+	int32 numLayers; /* The number of floor layers stored per cell. */
+};
+
+/* A single floor layer of a heightfield cell. */
+struct FIKHeightfieldSample
+{
+	int16 height; /* Height above the grid origin in height steps, EmptyHeight if there is no floor. */
+	int8 normalX, normalY; /* The X and Y of the floor normal scaled by 127, Z is always positive. */
+};
+
+/* A baked multi layer heightfield of a levels static floors, used by foot IK instead of tracing against static geometry.
+ * NOTE: Each cell stores its floor layers from highest to lowest so overhangs such as stairs above stairs are kept. */
+class IKDEMO_API FIKFloorHeightfield
+{
+public:
+
+	/* File identification. */
+	static const uint32 Magic = 0x4648494B; // "IKHF"
+	static const uint32 Version = 1;
+	static const int16 EmptyHeight = MIN_int16;
+
+	/* Destructor. */
+	~FIKFloorHeightfield();
+
+	/* Memory maps the heightfield file, falling back to reading it when the platform cannot map files. Returns null if the file is missing or invalid. */
+	static TUniquePtr<FIKFloorHeightfield> Load(const FString& path);
+
+	/* Writes a heightfield file. The samples are numLayers per cell, row by row along X. */
+	static bool Save(const FString& path, const FIKHeightfieldHeader& header, const TArray<FIKHeightfieldSample>& samples);
+
+	/* Returns where the heightfield for the given world is baked to. */
+	static FString GetPathForWorld(const UWorld* world);
+
+	/* Quantises a floor height and normal into a sample. */
+	static FIKHeightfieldSample PackSample(const FIKHeightfieldHeader& header, float height, const FVector& normal);
+
+	/* Finds the floor a sphere swept down from start by maxDrop would land on. Returns false if the location is outside of the baked area.
+	 * NOTE: Like a sweep the location returned is the centre of the sphere when touching the floor, and is zero when there is no floor. */
+	bool Query(const FVector& start, float maxDrop, float radius, FVector& outLocation) const;
+
+private:
+
+	/* Constructor. Use Load(). */
+	FIKFloorHeightfield();
+
+	/* Points the header and samples at the loaded data. Returns false if the data is not a valid heightfield. */
+	bool SetData(const uint8* data, int64 size);
+
+private:
+
+	IMappedFileHandle* mappedFile; /* The memory mapped file, null if the file was read instead. */
+	IMappedFileRegion* mappedRegion; /* The mapped region of the whole file. */
+	TArray<uint8> loadedData; /* The file contents when it could not be memory mapped. */
+	const FIKHeightfieldHeader* header; /* The header within the file data. */
+	const FIKHeightfieldSample* samples; /* The samples following the header. */
+};
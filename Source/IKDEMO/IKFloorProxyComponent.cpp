@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKFloorProxyComponent.h"
+#include "GameFramework/Actor.h"
+#include "IKFloorQuery.h"
+
+UIKFloorProxyComponent::UIKFloorProxyComponent()
+{
+	// Only the foot traces can see the proxy.
+	SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	SetCollisionObjectType(ECC_WorldStatic);
+	SetCollisionResponseToAllChannels(ECR_Ignore);
+	SetCollisionResponseToChannel(COLLISION_IKFLOOR, ECR_Block);
+	SetGenerateOverlapEvents(false);
+	SetCanEverAffectNavigation(false);
+	bHiddenInGame = true;
+	CastShadow = false;
+	bUseAsOccluder = false;
+	replaceOwnerFloors = true;
+}
+
+bool UIKFloorProxyComponent::IsReplacedByProxy(const UPrimitiveComponent* component)
+{
+	const AActor* owner = component ? component->GetOwner() : nullptr;
+	if (!owner || component->IsA<UIKFloorProxyComponent>()) return false;
+
+	TInlineComponentArray<UIKFloorProxyComponent*> proxies(owner);
+	for (const UIKFloorProxyComponent* proxy : proxies)
+	{
+		if (proxy->replaceOwnerFloors) return true;
+	}
+	return false;
+}
+
+void UIKFloorProxyComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Take the floors of the owner out of the foot traces. Done at play so the owners components are never changed in the editor.
+	if (!replaceOwnerFloors) return;
+	TInlineComponentArray<UPrimitiveComponent*> components(GetOwner());
+	for (UPrimitiveComponent* component : components)
+	{
+		if (IsReplacedByProxy(component)) component->SetCollisionResponseToChannel(COLLISION_IKFLOOR, ECR_Ignore);
+	}
+}
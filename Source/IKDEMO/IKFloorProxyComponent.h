@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "Components/StaticMeshComponent.h"
+#include "IKFloorProxyComponent.generated.h"
+
+/* Simplified walkable geometry for the foot traces, such as a few boxes or a low poly ramp over a detailed staircase.
+ * Only blocks the IKFloor channel and is hidden in game. Give it a mesh with simple collision, or one that uses complex collision as simple. */
+UCLASS(ClassGroup = (IK), meta = (BlueprintSpawnableComponent))
+class IKDEMO_API UIKFloorProxyComponent : public UStaticMeshComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Constructor. */
+	UIKFloorProxyComponent();
+
+	/* Returns true if the component has been replaced by a floor proxy of its owner, so the foot traces ignore it. */
+	static bool IsReplacedByProxy(const UPrimitiveComponent* component);
+
+	/* Should the other primitive components of the owner stop blocking the IKFloor channel, so the feet only stand on the proxies? */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "IK")
+	bool replaceOwnerFloors;
+
+protected:
+
+	/* Level start. */
+	virtual void BeginPlay() override;
+};
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKFloorQuery.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "IKCoreConversions.h"
+#include "IKProfiling.h"
+
+const FName FIKPhysicsFloorQuery::ComplexFloorTag(TEXT("IKComplexFloor"));
+
+bool FIKPhysicsFloorQuery::SweepFloor(const FVector& start, const FVector& end, float radius, const FCollisionQueryParams& params, FHitResult& outHit) const
+{
+	world->SweepSingleByChannel(outHit, start, end, FQuat::Identity, COLLISION_IKFLOOR, FCollisionShape::MakeSphere(radius), params);
+	return RefineComplexFloor(world, start, end, radius, params, outHit);
+}
+
+bool FIKPhysicsFloorQuery::RefineComplexFloor(UWorld* world, const FVector& start, const FVector& end, float radius, const FCollisionQueryParams& params, FHitResult& inOutHit)
+{
+	if (!inOutHit.bBlockingHit || params.bTraceComplex) return inOutHit.bBlockingHit;
+	const UPrimitiveComponent* component = inOutHit.GetComponent();
+	if (!component || !component->ComponentHasTag(ComplexFloorTag)) return true;
+
+	// Sweep the whole way again, as the complex surface can be below its simple collision and let the sphere reach something else.
+	FCollisionQueryParams complexParams(params);
+	complexParams.bTraceComplex = true;
+	FIKProfileTimers::AddTraces(1);
+	return world->SweepSingleByChannel(inOutHit, start, end, FQuat::Identity, COLLISION_IKFLOOR, FCollisionShape::MakeSphere(radius), complexParams);
+}
+
+TUniquePtr<FIKBVHFloorQuery> FIKBVHFloorQuery::Load(const FString& path)
+{
+	TArray<uint8> data;
+	if (!FFileHelper::LoadFileToArray(data, *path, FILEREAD_Silent)) return nullptr;
+
+	// The soup is only needed until the BVH has copied its triangles.
+	IKCore::TriangleSoup soup;
+	if (!IKCore::ReadTriangleSoup(data.GetData(), data.Num(), soup)) return nullptr;
+	TUniquePtr<FIKBVHFloorQuery> floorQuery(new FIKBVHFloorQuery());
+	floorQuery->bvh.Build(soup);
+	return floorQuery;
+}
+
+FString FIKBVHFloorQuery::GetPathForWorld(const UWorld* world)
+{
+	// Exported floors are staged as loose files next to the content, named after the map like the heightfields.
+	FString mapName = UWorld::RemovePIEPrefix(FPackageName::GetShortName(world->GetOutermost()->GetName()));
+	return FPaths::ProjectContentDir() / TEXT("IKFloors") / mapName + TEXT(".ikts");
+}
+
+bool FIKBVHFloorQuery::SweepFloor(const FVector& start, const FVector& end, float radius, const FCollisionQueryParams& params, FHitResult& outHit) const
+{
+	outHit = FHitResult(start, end);
+	IKCore::FloorHit hit;
+	if (!bvh.SweepSphere(IKCore::ToIKCore(start), IKCore::ToIKCore(end), radius, hit)) return false;
+
+	// Fill the same fields a physics sweep would.
+	outHit.bBlockingHit = true;
+	outHit.bStartPenetrating = hit.time == 0.0f;
+	outHit.Time = hit.time;
+	outHit.Distance = FVector::Dist(start, end) * hit.time;
+	outHit.Location = IKCore::ToEngine(hit.location);
+	outHit.ImpactPoint = IKCore::ToEngine(hit.impactPoint);
+	outHit.ImpactNormal = IKCore::ToEngine(hit.normal);
+	outHit.Normal = (outHit.Location - outHit.ImpactPoint).GetSafeNormal();
+	outHit.FaceIndex = hit.triangle;
+	return true;
+}
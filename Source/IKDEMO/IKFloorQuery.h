@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+#include "Engine/EngineTypes.h"
+#include "IKCoreBVH.h"
+
+/* The trace channel the static floor sweeps use, set up as IKFloor in DefaultEngine.ini. Blocked by everything by default, so floors can opt out for a proxy. */
+#define COLLISION_IKFLOOR ECC_GameTraceChannel1
+
+/* Finds the static floor under a foot by sweeping a sphere. Which backend the IK manager uses is chosen by UIKSettings::floorQueryBackend.
+ * NOTE: Dynamic only sweeps for moving floors always use the physics scene, only the static floor query goes through here. */
+class IKDEMO_API IIKFloorQuery
+{
+public:
+
+	/* Destructor. */
+	virtual ~IIKFloorQuery() {}
+
+	/* Sweeps a sphere from start to end, filling the hit like SweepSingleByChannel. Returns true on a blocking hit.
+	 * NOTE: Backends without components leave the hit component null, so their floors are not kept by the ground cache. */
+	virtual bool SweepFloor(const FVector& start, const FVector& end, float radius, const FCollisionQueryParams& params, FHitResult& outHit) const = 0;
+
+	/* Returns true if the sweeps run on the worlds physics scene, so can be queued on its async trace queue. */
+	virtual bool IsPhysicsScene() const = 0;
+
+	/* Returns the name shown in logs. */
+	virtual const TCHAR* GetName() const = 0;
+};
+
+/* Sweeps against the worlds physics scene on the IKFloor channel. Simple collision is swept unless the params ask for complex,
+ * and surfaces tagged ComplexFloorTag are swept again against complex collision when a simple sweep lands on them. */
+class IKDEMO_API FIKPhysicsFloorQuery : public IIKFloorQuery
+{
+public:
+
+	/* The component tag of surfaces whose simple collision is too rough to stand on, so the feet always use their complex collision.
+	 * NOTE: The simple collision still has to be there for the first sweep to find the surface. */
+	static const FName ComplexFloorTag;
+
+	/* Constructor. */
+	FIKPhysicsFloorQuery(UWorld* inWorld) : world(inWorld) {}
+
+	/* Sweeps again against complex collision if a simple sweep hit a surface tagged ComplexFloorTag, replacing the hit. Returns true if there is still a blocking hit. */
+	static bool RefineComplexFloor(UWorld* world, const FVector& start, const FVector& end, float radius, const FCollisionQueryParams& params, FHitResult& inOutHit);
+
+	/* IIKFloorQuery. */
+	virtual bool SweepFloor(const FVector& start, const FVector& end, float radius, const FCollisionQueryParams& params, FHitResult& outHit) const override;
+	virtual bool IsPhysicsScene() const override { return true; }
+	virtual const TCHAR* GetName() const override { return TEXT("Physics"); }
+
+private:
+
+	UWorld* world; /* The world swept, which owns the IK manager that owns this. */
+};
+
+/* Sweeps against a levels static floors exported with -run=IKFloorExport, using IKCore::FloorBVH with no physics scene.
+ * NOTE: Only what was static when exported is hit and the query params are ignored, as no character can be in the export. */
+class IKDEMO_API FIKBVHFloorQuery : public IIKFloorQuery
+{
+public:
+
+	/* Reads an exported level and builds its BVH. Returns null if the file is missing or invalid. */
+	static TUniquePtr<FIKBVHFloorQuery> Load(const FString& path);
+
+	/* Returns where the floors of the given world are exported to. */
+	static FString GetPathForWorld(const UWorld* world);
+
+	/* Returns the BVH the sweeps run on. */
+	const IKCore::FloorBVH& GetBVH() const { return bvh; }
+
+	/* IIKFloorQuery. */
+	virtual bool SweepFloor(const FVector& start, const FVector& end, float radius, const FCollisionQueryParams& params, FHitResult& outHit) const override;
+	virtual bool IsPhysicsScene() const override { return false; }
+	virtual const TCHAR* GetName() const override { return TEXT("BVH"); }
+
+private:
+
+	IKCore::FloorBVH bvh; /* The exported floors. */
+};
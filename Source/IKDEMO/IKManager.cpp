@@ -0,0 +1,612 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKManager.h"
+#include "Async/ParallelFor.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "IKTraceBudget.h"
+#include "IKSettings.h"
+#include "IKProfiling.h"
+#include "IKSkeletalMeshComponent.h"
+#include "IAnimationBudgetAllocator.h"
+#include "IKCoreConversions.h"
+#include "IKCoreBatch.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogIKFloorQuery, Log, All);
+
+static FAutoConsoleCommandWithWorldAndArgs IKFloorQueryCompareCommand(
+	TEXT("ik.FloorQuery.Compare"),
+	TEXT("Times the physics and BVH floor queries over the same random sweeps of the exported floors. Optionally takes the number of sweeps and the sphere radius."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& args, UWorld* world)
+	{
+		AIKManager* manager = AIKManager::Get(world);
+		if (manager) manager->CompareFloorQueries(args.Num() > 0 ? FCString::Atoi(*args[0]) : 10000, args.Num() > 1 ? FCString::Atof(*args[1]) : 5.0f);
+	}));
+
+/* How far below their start the compared floor queries end. */
+static const float CompareQueryDistance = 200.0f;
+
+/* The size of a cell in the spatial sort of the foot traces. Traces within the same cell are sorted next to each other. */
+static const float TraceSortCellSize = 64.0f;
+
+/* Spreads the lower 16 bits of the value out to every other bit. */
+static uint32 SpreadBits(uint32 value)
+{
+	value &= 0x0000FFFF;
+	value = (value | (value << 8)) & 0x00FF00FF;
+	value = (value | (value << 4)) & 0x0F0F0F0F;
+	value = (value | (value << 2)) & 0x33333333;
+	value = (value | (value << 1)) & 0x55555555;
+	return value;
+}
+
+/* Returns the Morton code of the cell the location is in along the X and Y axis. */
+static uint32 GetMortonCode(const FVector& location)
+{
+	uint32 x = (uint32)(FMath::FloorToInt(location.X / TraceSortCellSize) + 0x8000);
+	uint32 y = (uint32)(FMath::FloorToInt(location.Y / TraceSortCellSize) + 0x8000);
+	return SpreadBits(x) | (SpreadBits(y) << 1);
+}
+
+void FIKFootTraceBatch::Add(AMainPlayer* owner, EGroundTraceType foot, const FVector& start, const FVector& end, float radius, bool dynamicOnlyTrace)
+{
+	starts.Add(start);
+	ends.Add(end);
+	radii.Add(radius);
+	sortKeys.Add(GetMortonCode(start));
+	feet.Add((uint8)foot);
+	dynamicOnly.Add(dynamicOnlyTrace);
+	owners.Add(owner);
+}
+
+void FIKFootTraceBatch::Reset()
+{
+	starts.Reset();
+	ends.Reset();
+	radii.Reset();
+	sortKeys.Reset();
+	feet.Reset();
+	dynamicOnly.Reset();
+	owners.Reset();
+}
+
+void FIKTickBatch::Add(AMainPlayer* character, bool runCharacterIK, float deltaTime)
+{
+	characters.Add(character);
+	runIK.Add(runCharacterIK);
+	deltaTimes.Add(deltaTime);
+}
+
+void FIKTickBatch::Remove(AMainPlayer* character)
+{
+	int32 index = characters.Find(character);
+	if (index == INDEX_NONE) return;
+
+	characters.RemoveAtSwap(index);
+	runIK.RemoveAtSwap(index);
+	deltaTimes.RemoveAtSwap(index);
+}
+
+void FIKTickBatch::Prepare()
+{
+	const int32 num = characters.Num();
+	modes.SetNum(num);
+	capsuleRotations.SetNum(num);
+	capsuleLocations.SetNum(num);
+	capsuleBottoms.SetNumZeroed(num);
+	leftRelativeStarts.SetNum(num);
+	rightRelativeStarts.SetNum(num);
+	leftRelativeFeet.SetNum(num);
+	rightRelativeFeet.SetNum(num);
+	leftStarts.SetNum(num);
+	rightStarts.SetNum(num);
+	leftFeet.SetNum(num);
+	rightFeet.SetNum(num);
+	leftSweeps.SetNum(num);
+	rightSweeps.SetNum(num);
+	leftFloors.SetNumZeroed(num);
+	rightFloors.SetNumZeroed(num);
+	leftFloorZs.SetNumZeroed(num);
+	rightFloorZs.SetNumZeroed(num);
+	hipOffsets.SetNumZeroed(num);
+}
+
+void FIKTickBatch::Reset()
+{
+	characters.Reset();
+	runIK.Reset();
+	deltaTimes.Reset();
+	modes.Reset();
+	capsuleRotations.Reset();
+	capsuleLocations.Reset();
+	capsuleBottoms.Reset();
+	leftRelativeStarts.Reset();
+	rightRelativeStarts.Reset();
+	leftRelativeFeet.Reset();
+	rightRelativeFeet.Reset();
+	leftStarts.Reset();
+	rightStarts.Reset();
+	leftFeet.Reset();
+	rightFeet.Reset();
+	leftSweeps.Reset();
+	rightSweeps.Reset();
+	sweepCharacters.Reset();
+	overBudget.Reset();
+	taskSeconds.Reset();
+	leftFloors.Reset();
+	rightFloors.Reset();
+	leftFloorZs.Reset();
+	rightFloorZs.Reset();
+	hipOffsets.Reset();
+}
+
+void FIKTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (manager && !manager->IsPendingKill()) manager->RunIKTick();
+}
+
+FString FIKTickFunction::DiagnosticMessage()
+{
+	return manager ? manager->GetFullName() + TEXT("[IKTick]") : TEXT("IKTick");
+}
+
+AIKManager::AIKManager()
+{
+	// Tick after every character has queued its foot traces.
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
+	// The parallel IK tick runs with the characters before physics, its prerequisites put it after them and before their meshes.
+	ikTickFunction.bCanEverTick = true;
+	ikTickFunction.bStartWithTickEnabled = true;
+	ikTickFunction.TickGroup = TG_PrePhysics;
+	ikTickFunction.manager = this;
+
+	sleepLODCheckTime = 0.0f;
+}
+
+AIKManager* AIKManager::Get(UWorld* world)
+{
+	if (!world || !world->IsGameWorld()) return nullptr;
+
+	// Use the existing manager if there is one.
+	for (TActorIterator<AIKManager> it(world); it; ++it)
+	{
+		if (!it->IsPendingKill()) return *it;
+	}
+
+	// Otherwise spawn one.
+	FActorSpawnParameters spawnParams;
+	spawnParams.ObjectFlags |= RF_Transient;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return world->SpawnActor<AIKManager>(spawnParams);
+}
+
+FCollisionObjectQueryParams AIKManager::GetDynamicFloorObjectParams()
+{
+	FCollisionObjectQueryParams objectParams;
+	objectParams.AddObjectTypesToQuery(ECC_WorldDynamic);
+	objectParams.AddObjectTypesToQuery(ECC_PhysicsBody);
+	objectParams.AddObjectTypesToQuery(ECC_Pawn);
+	return objectParams;
+}
+
+void AIKManager::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// Map in the worlds baked floors if there are any.
+	const UIKSettings* settings = UIKSettings::Get();
+	if (settings->useFloorHeightfield) floorHeightfield = FIKFloorHeightfield::Load(FIKFloorHeightfield::GetPathForWorld(GetWorld()));
+
+	// Setup the static floor queries, keeping the physics scene for when the exported floors are missing.
+	physicsFloorQuery = MakeUnique<FIKPhysicsFloorQuery>(GetWorld());
+	if (settings->floorQueryBackend == EIKFloorQueryBackend::BVH)
+	{
+		FString path = FIKBVHFloorQuery::GetPathForWorld(GetWorld());
+		bvhFloorQuery = FIKBVHFloorQuery::Load(path);
+		if (!bvhFloorQuery.IsValid()) UE_LOG(LogIKFloorQuery, Warning, TEXT("No exported floors at %s, using the physics floor query. Run -run=IKFloorExport to export them."), *path);
+	}
+
+	// Hand the anim budget to the worlds animation budget allocator.
+	ApplyAnimBudgetSettings();
+}
+
+void AIKManager::RegisterActorTickFunctions(bool bRegister)
+{
+	Super::RegisterActorTickFunctions(bRegister);
+
+	if (bRegister)
+	{
+		ikTickFunction.manager = this;
+		ikTickFunction.RegisterTickFunction(GetLevel());
+	}
+	else if (ikTickFunction.IsTickFunctionRegistered()) ikTickFunction.UnRegisterTickFunction();
+}
+
+void AIKManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Run the batched foot traces requested this frame.
+	if (footTraces.Num() > 0) DispatchFootTraces();
+
+	// Give the animation budget allocator each characters significance for next frame.
+	if (UIKSettings::Get()->animBudgetEnabled) UpdateAnimBudget();
+
+	// Freeze the ragdolls that have come to rest.
+	if (activeRagdolls.Num() > 0) UpdateRagdolls(DeltaTime);
+
+	// Wake the sleeping characters that need IK again.
+	if (sleepingCharacters.Num() > 0) UpdateSleepingCharacters(DeltaTime);
+
+#if IK_DEBUG_DRAW
+	// Draw everything the characters recorded this frame at once.
+	debugDraw.Flush(GetWorld());
+#endif
+}
+
+void AIKManager::RegisterCharacter(AMainPlayer* character)
+{
+	characters.AddUnique(character);
+	RebuildTraceParams();
+
+	// The IK tick has to wait for the character to queue its IK, and its mesh has to wait for the IK so it animates with this frames result.
+	ikTickFunction.AddPrerequisite(character, character->PrimaryActorTick);
+	character->GetMesh()->PrimaryComponentTick.AddPrerequisite(this, ikTickFunction);
+}
+
+void AIKManager::UnregisterCharacter(AMainPlayer* character)
+{
+	characters.Remove(character);
+	ikTicks.Remove(character);
+	ikTickFunction.RemovePrerequisite(character, character->PrimaryActorTick);
+	character->GetMesh()->PrimaryComponentTick.RemovePrerequisite(this, ikTickFunction);
+	sleepingCharacters.RemoveSwap(character);
+	ReleaseRagdoll(character);
+	RebuildTraceParams();
+}
+
+bool AIKManager::RequestRagdoll(AMainPlayer* character)
+{
+	if (activeRagdolls.Contains(character)) return true;
+
+	// Refuse once the budget is full.
+	int32 maxActiveRagdolls = UIKSettings::Get()->maxActiveRagdolls;
+	if (maxActiveRagdolls > 0 && activeRagdolls.Num() >= maxActiveRagdolls)
+	{
+		INC_DWORD_STAT(STAT_IK_RagdollsOverBudget);
+		return false;
+	}
+
+	activeRagdolls.Add(character);
+	ragdollSettledTimes.Add(0.0f);
+	INC_DWORD_STAT(STAT_IK_ActiveRagdolls);
+	return true;
+}
+
+void AIKManager::ReleaseRagdoll(AMainPlayer* character)
+{
+	int32 index = activeRagdolls.Find(character);
+	if (index == INDEX_NONE) return;
+
+	activeRagdolls.RemoveAtSwap(index);
+	ragdollSettledTimes.RemoveAtSwap(index);
+	DEC_DWORD_STAT(STAT_IK_ActiveRagdolls);
+}
+
+void AIKManager::AddSleepingCharacter(AMainPlayer* character)
+{
+	sleepingCharacters.AddUnique(character);
+}
+
+void AIKManager::RemoveSleepingCharacter(AMainPlayer* character)
+{
+	sleepingCharacters.RemoveSwap(character);
+}
+
+void AIKManager::QueueIKTick(AMainPlayer* character, bool runIK, float DeltaTime)
+{
+	ikTicks.Add(character, runIK, DeltaTime);
+}
+
+void AIKManager::RunIKTick()
+{
+	const int32 num = ikTicks.Num();
+	if (num == 0) return;
+	IK_PROFILE_SCOPE(IKTick);
+
+	// Decide what each character does and take its transforms, on the game thread as it reads the characters components.
+	ikTicks.Prepare();
+	for (int32 i = 0; i < num; i++)
+	{
+		AMainPlayer* character = ikTicks.characters[i];
+		ikTicks.modes[i] = ikTicks.runIK[i] ? character->PrepareIKUpdate(ikTicks.deltaTimes[i]) : EIKUpdateMode::DefaultFeet;
+		character->GatherIKTick(ikTicks, i);
+	}
+
+	// Work out every trace start and default foot.
+	IKCore::TransformPositionsNoScale(num, ikTicks.capsuleRotations.GetData(), ikTicks.capsuleLocations.GetData(), ikTicks.leftRelativeStarts.GetData(), ikTicks.leftStarts.GetData());
+	IKCore::TransformPositionsNoScale(num, ikTicks.capsuleRotations.GetData(), ikTicks.capsuleLocations.GetData(), ikTicks.rightRelativeStarts.GetData(), ikTicks.rightStarts.GetData());
+	IKCore::TransformPositionsNoScale(num, ikTicks.capsuleRotations.GetData(), ikTicks.capsuleLocations.GetData(), ikTicks.leftRelativeFeet.GetData(), ikTicks.leftFeet.GetData());
+	IKCore::TransformPositionsNoScale(num, ikTicks.capsuleRotations.GetData(), ikTicks.capsuleLocations.GetData(), ikTicks.rightRelativeFeet.GetData(), ikTicks.rightFeet.GetData());
+
+	// Find what floors can be found without a sweep on the game thread, as the ground caches and deferred traces belong to the characters.
+	for (int32 i = 0; i < num; i++)
+	{
+		if (ikTicks.modes[i] != EIKUpdateMode::Update) continue;
+
+		// Hold the last update when over the trace budget.
+		if (!FIKTraceBudget::HasBudget()) ikTicks.modes[i] = EIKUpdateMode::Interpolate;
+		else if (ikTicks.characters[i]->PrepareIKFloors(IKCore::ToEngine(ikTicks.leftStarts[i]), IKCore::ToEngine(ikTicks.rightStarts[i]), ikTicks.leftSweeps[i], ikTicks.rightSweeps[i])) ikTicks.sweepCharacters.Add(i);
+		else ikTicks.characters[i]->FinishIKFloors(ikTicks.leftSweeps[i], ikTicks.rightSweeps[i], ikTicks.leftFloors[i], ikTicks.rightFloors[i]);
+	}
+
+	// Sweep the rest across the task graph workers, a batch of characters each. Each task gets an even share of the trace budget left,
+	// so the budget is kept without the tasks sharing a counter.
+	const int32 numSweeps = ikTicks.sweepCharacters.Num();
+	if (numSweeps > 0)
+	{
+		const int32 batchSize = UIKSettings::Get()->parallelIKBatchSize;
+		const int32 numTasks = FMath::DivideAndRoundUp(numSweeps, batchSize);
+		const double taskBudget = FIKTraceBudget::GetRemainingSeconds() / numTasks;
+		ikTicks.overBudget.SetNumZeroed(numSweeps);
+		ikTicks.taskSeconds.SetNumZeroed(numTasks);
+		FIKTickBatch& batch = ikTicks;
+		ParallelFor(numTasks, [&batch, numSweeps, batchSize, taskBudget](int32 taskIndex)
+		{
+			int32 first = taskIndex * batchSize;
+			int32 last = FMath::Min(first + batchSize, numSweeps);
+			double& seconds = batch.taskSeconds[taskIndex];
+			for (int32 j = first; j < last; j++)
+			{
+				if (seconds >= taskBudget)
+				{
+					batch.overBudget[j] = true;
+					continue;
+				}
+
+				int32 i = batch.sweepCharacters[j];
+				const AMainPlayer* character = batch.characters[i];
+				double startTime = FPlatformTime::Seconds();
+				if (batch.leftSweeps[i].needed) character->SweepIKFloor(batch.leftSweeps[i]);
+				if (batch.rightSweeps[i].needed) character->SweepIKFloor(batch.rightSweeps[i]);
+				seconds += FPlatformTime::Seconds() - startTime;
+			}
+		}, numTasks == 1);
+
+		// Merge the tasks back on the game thread, charging the budget and storing the ground caches.
+		double sweepSeconds = 0.0;
+		for (double seconds : ikTicks.taskSeconds) sweepSeconds += seconds;
+		FIKTraceBudget::Consume(sweepSeconds);
+		for (int32 j = 0; j < numSweeps; j++)
+		{
+			int32 i = ikTicks.sweepCharacters[j];
+			if (ikTicks.overBudget[j]) ikTicks.modes[i] = EIKUpdateMode::Interpolate;
+			else ikTicks.characters[i]->FinishIKFloors(ikTicks.leftSweeps[i], ikTicks.rightSweeps[i], ikTicks.leftFloors[i], ikTicks.rightFloors[i]);
+		}
+	}
+
+	// Solve every hip offset.
+	for (int32 i = 0; i < num; i++)
+	{
+		ikTicks.leftFloorZs[i] = ikTicks.leftFloors[i].Z;
+		ikTicks.rightFloorZs[i] = ikTicks.rightFloors[i].Z;
+	}
+	IKCore::SolveHipOffsets(num, ikTicks.leftFloorZs.GetData(), ikTicks.rightFloorZs.GetData(), ikTicks.capsuleBottoms.GetData(), ikTicks.hipOffsets.GetData());
+
+	// Apply the results in one pass on the game thread, as they resize the capsules and publish to the anim instances.
+	for (int32 i = 0; i < num; i++)
+	{
+		AMainPlayer* character = ikTicks.characters[i];
+		switch (ikTicks.modes[i])
+		{
+		case EIKUpdateMode::DefaultFeet:
+			character->ApplyDefaultFeet(IKCore::ToEngine(ikTicks.leftFeet[i]), IKCore::ToEngine(ikTicks.rightFeet[i]));
+			break;
+		case EIKUpdateMode::Update:
+			character->ApplyIKUpdate(ikTicks.leftFloors[i], ikTicks.rightFloors[i], ikTicks.hipOffsets[i]);
+			break;
+		case EIKUpdateMode::Interpolate:
+			character->InterpolateIK();
+			break;
+		default:
+			break;
+		}
+
+		// Share the IK now it has run, so the net state is this frames pose.
+		character->ShareIKNetState(ikTicks.deltaTimes[i]);
+	}
+	ikTicks.Reset();
+}
+
+void AIKManager::RequestFootTrace(AMainPlayer* owner, EGroundTraceType foot, const FVector& start, const FVector& end, float radius, bool dynamicOnly)
+{
+	footTraces.Add(owner, foot, start, end, radius, dynamicOnly);
+}
+
+bool AIKManager::QueryFloorHeightfield(const FVector& start, float maxDrop, float radius, FVector& outFloorLocation) const
+{
+	return floorHeightfield.IsValid() && floorHeightfield->Query(start, maxDrop, radius, outFloorLocation);
+}
+
+const IIKFloorQuery& AIKManager::GetFloorQuery() const
+{
+	if (bvhFloorQuery.IsValid() && UIKSettings::Get()->floorQueryBackend == EIKFloorQueryBackend::BVH) return *bvhFloorQuery;
+	return *physicsFloorQuery;
+}
+
+void AIKManager::CompareFloorQueries(int32 numQueries, float radius)
+{
+	// Load the exported floors if they are not already used.
+	if (!bvhFloorQuery.IsValid()) bvhFloorQuery = FIKBVHFloorQuery::Load(FIKBVHFloorQuery::GetPathForWorld(GetWorld()));
+	if (!bvhFloorQuery.IsValid() || bvhFloorQuery->GetBVH().NumTriangles() == 0 || numQueries <= 0)
+	{
+		UE_LOG(LogIKFloorQuery, Warning, TEXT("Nothing to compare, run -run=IKFloorExport to export the floors of this map."));
+		return;
+	}
+	const FCollisionQueryParams& traceParams = GetFloorTraceParams(false);
+
+	// Start the sweeps at random points over the exported floors, dropping like foot traces.
+	FRandomStream random(1234);
+	const FVector boundsMin = IKCore::ToEngine(bvhFloorQuery->GetBVH().GetBoundsMin());
+	const FVector boundsMax = IKCore::ToEngine(bvhFloorQuery->GetBVH().GetBoundsMax());
+	TArray<FVector> starts;
+	starts.SetNumUninitialized(numQueries);
+	for (FVector& start : starts) start = FVector(random.FRandRange(boundsMin.X, boundsMax.X), random.FRandRange(boundsMin.Y, boundsMax.Y), random.FRandRange(boundsMin.Z, boundsMax.Z + CompareQueryDistance));
+
+	// Run every sweep through each backend, timing them separately.
+	const IIKFloorQuery* backends[2] = { physicsFloorQuery.Get(), bvhFloorQuery.Get() };
+	TArray<FHitResult> hits[2];
+	double seconds[2];
+	int32 numHits[2] = { 0, 0 };
+	for (int32 backend = 0; backend < 2; backend++)
+	{
+		hits[backend].SetNum(numQueries);
+		double startTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < numQueries; i++)
+		{
+			if (backends[backend]->SweepFloor(starts[i], starts[i] - FVector(0.0f, 0.0f, CompareQueryDistance), radius, traceParams, hits[backend][i])) numHits[backend]++;
+		}
+		seconds[backend] = FPlatformTime::Seconds() - startTime;
+	}
+
+	// Count the sweeps that found a different floor. Movable floors are only in the physics scene.
+	int32 numDiffering = 0;
+	for (int32 i = 0; i < numQueries; i++)
+	{
+		const FHitResult& physicsHit = hits[0][i];
+		const FHitResult& bvhHit = hits[1][i];
+		if (physicsHit.bBlockingHit != bvhHit.bBlockingHit || (physicsHit.bBlockingHit && FMath::Abs(physicsHit.Location.Z - bvhHit.Location.Z) > 1.0f)) numDiffering++;
+	}
+
+	UE_LOG(LogIKFloorQuery, Display, TEXT("%d floor queries of radius %.1f over %d exported triangles:"), numQueries, radius, bvhFloorQuery->GetBVH().NumTriangles());
+	for (int32 backend = 0; backend < 2; backend++)
+	{
+		UE_LOG(LogIKFloorQuery, Display, TEXT("  %s: %.3f us per query, %d hits"), backends[backend]->GetName(), seconds[backend] * 1000000.0 / numQueries, numHits[backend]);
+	}
+	UE_LOG(LogIKFloorQuery, Display, TEXT("  %d queries found a different floor"), numDiffering);
+}
+
+void AIKManager::DispatchFootTraces()
+{
+	IK_PROFILE_SCOPE(BatchedTraces);
+
+	// Sort the traces spatially so neighbouring sweeps touch the same parts of the physics scene.
+	const int32 numTraces = footTraces.Num();
+	sortedTraces.SetNumUninitialized(numTraces, false);
+	for (int32 i = 0; i < numTraces; i++) sortedTraces[i] = i;
+	const TArray<uint32>& sortKeys = footTraces.sortKeys;
+	sortedTraces.Sort([&sortKeys](int32 a, int32 b) { return sortKeys[a] < sortKeys[b]; });
+
+	// Sweep every trace that fits in the trace budget and scatter the hits back to the characters.
+	UWorld* world = GetWorld();
+	const FCollisionObjectQueryParams dynamicObjectParams = GetDynamicFloorObjectParams();
+	const uint32 requestFrame = AMainPlayer::GetTraceFrame();
+	const IIKFloorQuery& floorQuery = GetFloorQuery();
+	FHitResult hit;
+	for (int32 traceIndex : sortedTraces)
+	{
+		AMainPlayer* owner = footTraces.owners[traceIndex].Get();
+		if (!owner) continue;
+		if (!FIKTraceBudget::HasBudget()) break;
+
+		const FVector& start = footTraces.starts[traceIndex];
+		const FVector& end = footTraces.ends[traceIndex];
+		{
+			FIKTraceBudgetScope budgetScope;
+			FIKProfileTimers::AddTraces(1);
+			const float radius = footTraces.radii[traceIndex];
+			const FCollisionQueryParams& traceParams = GetFloorTraceParams(owner->UsesComplexFloorTraces());
+			if (footTraces.dynamicOnly[traceIndex]) world->SweepSingleByObjectType(hit, start, end, FQuat::Identity, dynamicObjectParams, FCollisionShape::MakeSphere(radius), traceParams);
+			else floorQuery.SweepFloor(start, end, radius, traceParams, hit);
+		}
+		owner->ReceiveFootTrace((EGroundTraceType)footTraces.feet[traceIndex], requestFrame, start, end, hit.bBlockingHit ? &hit : nullptr);
+	}
+
+	footTraces.Reset();
+}
+
+void AIKManager::UpdateRagdolls(float DeltaTime)
+{
+	const UIKSettings* settings = UIKSettings::Get();
+
+	// Swap each ragdolls physics asset with its distance and freeze it once it has stayed settled long enough, freeing its slot.
+	for (int32 i = activeRagdolls.Num() - 1; i >= 0; i--)
+	{
+		AMainPlayer* character = activeRagdolls[i];
+		if (!character || character->IsPendingKill())
+		{
+			activeRagdolls.RemoveAtSwap(i);
+			ragdollSettledTimes.RemoveAtSwap(i);
+			DEC_DWORD_STAT(STAT_IK_ActiveRagdolls);
+			continue;
+		}
+
+		character->UpdateRagdollPhysicsLOD();
+		ragdollSettledTimes[i] = character->IsRagdollSettled(settings->ragdollSettleSpeed) ? ragdollSettledTimes[i] + DeltaTime : 0.0f;
+		if (settings->freezeSettledRagdolls && ragdollSettledTimes[i] >= settings->ragdollSettleTime)
+		{
+			character->FreezeRagdoll();
+			ReleaseRagdoll(character);
+		}
+	}
+}
+
+void AIKManager::ApplyAnimBudgetSettings()
+{
+	const UIKSettings* settings = UIKSettings::Get();
+	if (IAnimationBudgetAllocator* allocator = IAnimationBudgetAllocator::Get(GetWorld())) allocator->SetEnabled(settings->animBudgetEnabled);
+
+	// The budget is set through the allocators console variables, so the command line and console can still override it.
+	if (IConsoleVariable* budgetMs = IConsoleManager::Get().FindConsoleVariable(TEXT("a.Budget.BudgetMs"))) budgetMs->Set(settings->animBudgetMilliseconds, ECVF_SetByProjectSetting);
+	if (IConsoleVariable* maxTickRate = IConsoleManager::Get().FindConsoleVariable(TEXT("a.Budget.MaxTickRate"))) maxTickRate->Set(settings->animBudgetMaxTickRate, ECVF_SetByProjectSetting);
+}
+
+void AIKManager::UpdateAnimBudget()
+{
+	const UIKSettings* settings = UIKSettings::Get();
+	int32 numIKOff = 0;
+	for (AMainPlayer* character : characters)
+	{
+		UIKSkeletalMeshComponent* mesh = Cast<UIKSkeletalMeshComponent>(character->GetMesh());
+		if (!mesh) continue;
+
+		// Only the less significant characters may lose their IK, the rest get it back if they had lost it.
+		float significance = character->GetAnimSignificance();
+		bool allowIKOff = significance < settings->animBudgetIKSignificance;
+		mesh->SetComponentSignificance(significance, significance >= 1.0f, false, allowIKOff);
+		if (!allowIKOff) character->SetAnimBudgetIKOff(false);
+		numIKOff += character->IsAnimBudgetIKOff();
+	}
+	INC_DWORD_STAT_BY(STAT_IK_AnimBudgetIKOff, numIKOff);
+}
+
+void AIKManager::UpdateSleepingCharacters(float DeltaTime)
+{
+	sleepLODCheckTime += DeltaTime;
+	if (sleepLODCheckTime < UIKSettings::Get()->sleepLODCheckInterval) return;
+	sleepLODCheckTime = 0.0f;
+
+	// Go backwards as waking a character removes it from the array.
+	for (int32 i = sleepingCharacters.Num() - 1; i >= 0; i--)
+	{
+		AMainPlayer* character = sleepingCharacters[i];
+		if (!character || character->IsPendingKill()) sleepingCharacters.RemoveAtSwap(i);
+		else character->CheckSleepingLOD();
+	}
+}
+
+void AIKManager::RebuildTraceParams()
+{
+	// Every registered character is ignored by every foot trace, so feet never land on another character whichever trace mode is used.
+	traceParams = FCollisionQueryParams(SCENE_QUERY_STAT(IKFootTrace), false);
+	for (AMainPlayer* character : characters)
+	{
+		if (character) traceParams.AddIgnoredActor(character);
+	}
+	complexTraceParams = traceParams;
+	complexTraceParams.bTraceComplex = true;
+}
@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "MainPlayer.h"
+#include "IKFloorHeightfield.h"
+#include "IKFloorQuery.h"
+#include "IKDebugDraw.h"
+#include "IKCoreMath.h"
+#include "IKManager.generated.h"
+
+class AIKManager;
+
+/* The foot trace requests collected from every IK character in a frame, stored as a structure of arrays. */
+struct FIKFootTraceBatch
+{
+	TArray<FVector> starts; /* World start location of each trace. */
+	TArray<FVector> ends; /* World end location of each trace. */
+	TArray<float> radii; /* Sphere radius of each trace. */
+	TArray<uint32> sortKeys; /* Morton code of each trace start used to sort the batch spatially. */
+	TArray<uint8> feet; /* Which foot each trace is for. */
+	TArray<bool> dynamicOnly; /* Should each trace only hit dynamic objects? */
+	TArray<TWeakObjectPtr<AMainPlayer>> owners; /* The character each result is scattered back to. */
+
+	/* Returns the number of traces in the batch. */
+	int32 Num() const { return starts.Num(); }
+
+	/* Adds a trace to the batch. */
+	void Add(AMainPlayer* owner, EGroundTraceType foot, const FVector& start, const FVector& end, float radius, bool dynamicOnlyTrace);
+
+	/* Empties the batch keeping its memory for the next frame. */
+	void Reset();
+};
+
+/* The characters queued for the parallel IK tick this frame with their inputs and results, stored as a structure of arrays.
+ * NOTE: Only the queued arrays are filled by Add, the rest are sized by Prepare when the IK tick runs. */
+struct FIKTickBatch
+{
+	TArray<AMainPlayer*> characters; /* The characters queued this frame. */
+	TArray<bool> runIK; /* Should each character run its IK, rather than keep its default feet? */
+	TArray<float> deltaTimes; /* The frame time of each character. */
+	TArray<EIKUpdateMode> modes; /* What the IK of each character does this frame. */
+	TArray<IKCore::Quat> capsuleRotations; /* World rotation of each capsule. */
+	TArray<IKCore::Vector3> capsuleLocations; /* World location of each capsule. */
+	TArray<float> capsuleBottoms; /* World height of the bottom of each capsule. */
+	TArray<IKCore::Vector3> leftRelativeStarts, rightRelativeStarts; /* The foot trace starts relative to each capsule. */
+	TArray<IKCore::Vector3> leftRelativeFeet, rightRelativeFeet; /* The default feet relative to each capsule. */
+	TArray<IKCore::Vector3> leftStarts, rightStarts; /* World foot trace starts. */
+	TArray<IKCore::Vector3> leftFeet, rightFeet; /* World default feet. */
+	TArray<FIKFootSweep> leftSweeps, rightSweeps; /* The floor sweep under each foot. */
+	TArray<int32> sweepCharacters; /* The characters whose feet need sweeping. */
+	TArray<bool> overBudget; /* Did each character needing sweeps run out of its tasks share of the trace budget? */
+	TArray<double> taskSeconds; /* The time each sweep task spent sweeping, charged to the trace budget once they are done. */
+	TArray<FVector> leftFloors, rightFloors; /* The floor found under each foot, zero if there is none. */
+	TArray<float> leftFloorZs, rightFloorZs; /* The height of the floor under each foot, given to the hip offset solve. */
+	TArray<float> hipOffsets; /* The hip offset solved for each character. */
+
+	/* Returns the number of queued characters. */
+	int32 Num() const { return characters.Num(); }
+
+	/* Queues a character. */
+	void Add(AMainPlayer* character, bool runCharacterIK, float deltaTime);
+
+	/* Removes a queued character, such as one destroyed before the IK tick. */
+	void Remove(AMainPlayer* character);
+
+	/* Sizes the arrays filled in by the IK tick for the queued characters. */
+	void Prepare();
+
+	/* Empties the batch keeping its memory for the next frame. */
+	void Reset();
+};
+
+/* Runs the IK of every queued character in one pass, after their actor ticks and before their meshes animate. See AIKManager::RunIKTick. */
+USTRUCT()
+struct FIKTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	AIKManager* manager; /* The manager the tick function belongs to. */
+
+	/* FTickFunction. */
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FIKTickFunction> : public TStructOpsTypeTraitsBase2<FIKTickFunction>
+{
+	enum { WithCopy = false };
+};
+
+/* World level manager for the IK characters. Spawned on demand the first time a character asks for it.
+ * NOTE: The parallel IK tick runs in the pre physics tick group, ordered after the characters and before their meshes by tick prerequisites.
+ * Batched foot traces are collected during the characters pre physics ticks and dispatched post physics, so are used the next frame. */
+UCLASS(NotBlueprintable, NotPlaceable, Transient)
+class IKDEMO_API AIKManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Constructor. */
+	AIKManager();
+
+	/* Returns the IK manager for the given world, spawning one if there is not one already. */
+	static AIKManager* Get(UWorld* world);
+
+	/* Returns the object types a floor trace hits when static geometry comes from the floor heightfield. */
+	static FCollisionObjectQueryParams GetDynamicFloorObjectParams();
+
+	/* Returns the query params of every foot trace, ignoring every registered character.
+	 * NOTE: Only rebuilt when a character registers or unregisters on the game thread, so can be read by the parallel IK ticks sweeps. */
+	const FCollisionQueryParams& GetFloorTraceParams(bool traceComplex) const { return traceComplex ? complexTraceParams : traceParams; }
+
+	/* Frame. */
+	virtual void Tick(float DeltaTime) override;
+
+	/* Adds a character to the manager. */
+	void RegisterCharacter(AMainPlayer* character);
+
+	/* Removes a character from the manager. */
+	void UnregisterCharacter(AMainPlayer* character);
+
+	/* Queues a characters IK for the parallel IK tick this frame. Characters not running IK still have their default feet worked out. */
+	void QueueIKTick(AMainPlayer* character, bool runIK, float DeltaTime);
+
+	/* Runs the IK of every character queued this frame. Called by the IK tick function.
+	 * NOTE: The blocking foot sweeps are spread over the task graph workers, each task with its own share of the trace budget.
+	 * The ground caches, budget accounting, net state and component updates are done on the game thread once they are merged. */
+	void RunIKTick();
+
+	/* Queues a foot trace to be dispatched with the rest of this frames batch. */
+	void RequestFootTrace(AMainPlayer* owner, EGroundTraceType foot, const FVector& start, const FVector& end, float radius, bool dynamicOnly = false);
+
+	/* Finds the static floor under a foot from the worlds baked heightfield. Returns false if there is no heightfield at the location.
+	 * NOTE: The floor location is the centre of the sphere touching the floor like a sweep, or zero if there is no floor. */
+	bool QueryFloorHeightfield(const FVector& start, float maxDrop, float radius, FVector& outFloorLocation) const;
+
+	/* Returns the static floor query chosen by the settings, the physics scene if the chosen one could not be loaded. */
+	const IIKFloorQuery& GetFloorQuery() const;
+
+	/* Sweeps spheres down at random points over the exported floors through both floor query backends, logging their cost and how many results differ. */
+	void CompareFloorQueries(int32 numQueries, float radius);
+
+	/* Takes one of the worlds ragdoll slots for a character. Returns false if the ragdoll budget is used up. */
+	bool RequestRagdoll(AMainPlayer* character);
+
+	/* Gives a characters ragdoll slot back. */
+	void ReleaseRagdoll(AMainPlayer* character);
+
+	/* Adds a character that has gone to sleep, so it can be woken if its IK LOD tier changes. */
+	void AddSleepingCharacter(AMainPlayer* character);
+
+	/* Removes a character that has woken up. */
+	void RemoveSleepingCharacter(AMainPlayer* character);
+
+#if IK_DEBUG_DRAW
+	/* Returns the debug drawing shared by every character, drawn at the end of the managers tick. */
+	FIKDebugDraw& GetDebugDraw() { return debugDraw; }
+#endif
+
+protected:
+
+	/* Called when spawned, before any character can ask for the manager. */
+	virtual void PostInitializeComponents() override;
+
+	/* Registers the IK tick function alongside the actor tick. */
+	virtual void RegisterActorTickFunctions(bool bRegister) override;
+
+private:
+
+	/* Sorts this frames foot traces spatially, sweeps them and scatters the hits back to their characters. */
+	void DispatchFootTraces();
+
+	/* Rebuilds the shared query params to ignore every registered character. */
+	void RebuildTraceParams();
+
+	/* Turns the worlds animation budget allocator on or off and gives it the budget from the IK settings. */
+	void ApplyAnimBudgetSettings();
+
+	/* Gives the animation budget allocator every characters significance. Characters below animBudgetIKSignificance are allowed to have their IK
+	 * turned off when the allocator asks them to reduce work, the players own character, ragdolls and characters getting up are never skipped. */
+	void UpdateAnimBudget();
+
+	/* Freezes the active ragdolls that have settled. */
+	void UpdateRagdolls(float DeltaTime);
+
+	/* Wakes the sleeping characters whose IK LOD tier has changed, checked every sleepLODCheckInterval. */
+	void UpdateSleepingCharacters(float DeltaTime);
+
+private:
+
+	UPROPERTY()
+	TArray<AMainPlayer*> characters; /* Every registered IK character. */
+
+	UPROPERTY()
+	TArray<AMainPlayer*> activeRagdolls; /* The characters simulating a ragdoll, each using a slot of the ragdoll budget. */
+
+	UPROPERTY()
+	TArray<AMainPlayer*> sleepingCharacters; /* The characters with their ticks turned off while idle. */
+
+	TArray<float> ragdollSettledTimes; /* How long each active ragdoll has been settled for. */
+	float sleepLODCheckTime; /* The time since the sleeping characters IK LOD tiers were last checked. */
+	FIKTickFunction ikTickFunction; /* Runs the parallel IK tick once every queued character has ticked. */
+	FIKTickBatch ikTicks; /* The characters queued for the parallel IK tick this frame. */
+	FIKFootTraceBatch footTraces; /* The foot traces requested this frame. */
+	TArray<int32> sortedTraces; /* The foot trace indices in spatial order. */
+	FCollisionQueryParams traceParams; /* The query params shared by every simple foot trace. */
+	FCollisionQueryParams complexTraceParams; /* The query params shared by every complex foot trace. */
+	TUniquePtr<FIKFloorHeightfield> floorHeightfield; /* The baked static floors of the world, null if it has not been baked. */
+	TUniquePtr<FIKPhysicsFloorQuery> physicsFloorQuery; /* Sweeps the static floors against the physics scene. */
+	TUniquePtr<FIKBVHFloorQuery> bvhFloorQuery; /* Sweeps the exported static floors, null if they have not been exported or are not used. */
+#if IK_DEBUG_DRAW
+	FIKDebugDraw debugDraw; /* The debug shapes recorded by every character this frame. */
+#endif
+};
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKProfiling.h"
+
+DEFINE_STAT(STAT_IK_Tick);
+DEFINE_STAT(STAT_IK_UpdateIK);
+DEFINE_STAT(STAT_IK_GetFloorLocation);
+DEFINE_STAT(STAT_IK_UpdateCapsule);
+DEFINE_STAT(STAT_IK_RagdollToggle);
+DEFINE_STAT(STAT_IK_UpdateDefaultFeetPosition);
+DEFINE_STAT(STAT_IK_BatchedTraces);
+DEFINE_STAT(STAT_IK_IKTick);
+DEFINE_STAT(STAT_IK_TraceHits);
+DEFINE_STAT(STAT_IK_TraceMisses);
+DEFINE_STAT(STAT_IK_RagdollsEnabled);
+DEFINE_STAT(STAT_IK_RagdollsDisabled);
+DEFINE_STAT(STAT_IK_RagdollsOverBudget);
+DEFINE_STAT(STAT_IK_NetStatesSent);
+DEFINE_STAT(STAT_IK_NetStatesReceived);
+DEFINE_STAT(STAT_IK_AnimBudgetIKOff);
+DEFINE_STAT(STAT_IK_ActiveRagdolls);
+
+CSV_DEFINE_CATEGORY_MODULE(IKDEMO_API, IK, true);
+
+bool FIKProfileTimers::enabled = false;
+double FIKProfileTimers::seconds[(int32)EIKProfileSection::Count] = {};
+uint64 FIKProfileTimers::calls[(int32)EIKProfileSection::Count] = {};
+uint64 FIKProfileTimers::traces = 0;
+uint64 FIKProfileTimers::netStates = 0;
+
+void FIKProfileTimers::Reset()
+{
+	for (int32 i = 0; i < (int32)EIKProfileSection::Count; i++)
+	{
+		seconds[i] = 0.0;
+		calls[i] = 0;
+	}
+	traces = 0;
+	netStates = 0;
+}
+
+const TCHAR* FIKProfileTimers::GetSectionName(EIKProfileSection section)
+{
+	switch (section)
+	{
+	case EIKProfileSection::Tick: return TEXT("Tick");
+	case EIKProfileSection::UpdateIK: return TEXT("UpdateIK");
+	case EIKProfileSection::GetFloorLocation: return TEXT("GetFloorLocation");
+	case EIKProfileSection::UpdateCapsule: return TEXT("UpdateCapsule");
+	case EIKProfileSection::RagdollToggle: return TEXT("RagdollToggle");
+	case EIKProfileSection::UpdateDefaultFeetPosition: return TEXT("UpdateDefaultFeetPosition");
+	case EIKProfileSection::BatchedTraces: return TEXT("BatchedTraces");
+	case EIKProfileSection::IKTick: return TEXT("IKTick");
+	default: return TEXT("Unknown");
+	}
+}
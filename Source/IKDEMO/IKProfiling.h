@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/* Should the IK path be instrumented? Stats, CSV and trace scopes compile out on their own in shipping, this removes the benchmark timers too. */
+#define IK_PROFILING !UE_BUILD_SHIPPING
+
+/* Viewed in game with "stat IK". */
+DECLARE_STATS_GROUP(TEXT("IK"), STATGROUP_IK, STATCAT_Advanced);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tick"), STAT_IK_Tick, STATGROUP_IK, IKDEMO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("UpdateIK"), STAT_IK_UpdateIK, STATGROUP_IK, IKDEMO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GetFloorLocation"), STAT_IK_GetFloorLocation, STATGROUP_IK, IKDEMO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("UpdateCapsule"), STAT_IK_UpdateCapsule, STATGROUP_IK, IKDEMO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("RagdollToggle"), STAT_IK_RagdollToggle, STATGROUP_IK, IKDEMO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("UpdateDefaultFeetPosition"), STAT_IK_UpdateDefaultFeetPosition, STATGROUP_IK, IKDEMO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("BatchedTraces"), STAT_IK_BatchedTraces, STATGROUP_IK, IKDEMO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("IKTick"), STAT_IK_IKTick, STATGROUP_IK, IKDEMO_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Trace Hits"), STAT_IK_TraceHits, STATGROUP_IK, IKDEMO_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Trace Misses"), STAT_IK_TraceMisses, STATGROUP_IK, IKDEMO_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ragdolls Enabled"), STAT_IK_RagdollsEnabled, STATGROUP_IK, IKDEMO_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ragdolls Disabled"), STAT_IK_RagdollsDisabled, STATGROUP_IK, IKDEMO_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ragdolls Over Budget"), STAT_IK_RagdollsOverBudget, STATGROUP_IK, IKDEMO_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Net States Sent"), STAT_IK_NetStatesSent, STATGROUP_IK, IKDEMO_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Net States Received"), STAT_IK_NetStatesReceived, STATGROUP_IK, IKDEMO_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("IK Turned Off By Budget"), STAT_IK_AnimBudgetIKOff, STATGROUP_IK, IKDEMO_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Active Ragdolls"), STAT_IK_ActiveRagdolls, STATGROUP_IK, IKDEMO_API);
+
+/* Captured with "csvprofile start". */
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(IKDEMO_API, IK);
+
+/* The parts of the IK path timed by the profiling scopes. */
+enum class EIKProfileSection : uint8
+{
+	Tick,
+	UpdateIK,
+	GetFloorLocation,
+	UpdateCapsule,
+	RagdollToggle,
+	UpdateDefaultFeetPosition,
+	BatchedTraces,
+	IKTick,
+	Count
+};
+
+/* Time and call counts of each IK section while profiling is enabled, used by the IK benchmark.
+ * NOTE: Sections are inclusive, so Tick includes UpdateIK which includes GetFloorLocation and UpdateCapsule.
+ * With the parallel IK tick, the IK is in IKTick instead of each characters Tick. */
+struct IKDEMO_API FIKProfileTimers
+{
+	static bool enabled; /* Are the sections being timed? */
+	static double seconds[(int32)EIKProfileSection::Count]; /* Total time spent in each section. */
+	static uint64 calls[(int32)EIKProfileSection::Count]; /* Number of times each section was entered. */
+	static uint64 traces; /* Number of physics scene foot and floor queries issued. */
+	static uint64 netStates; /* Number of IK net states sent or received. */
+
+	/* Clears all times and counts. */
+	static void Reset();
+
+	/* Returns the display name of a section. */
+	static const TCHAR* GetSectionName(EIKProfileSection section);
+
+	/* Counts physics scene queries. Atomic as floor queries can run on the parallel IK ticks worker threads. */
+	static void AddTraces(uint32 count) { if (enabled) FPlatformAtomics::InterlockedAdd((volatile int64*)&traces, (int64)count); }
+
+	/* Counts IK net states sent or received. */
+	static void AddNetStates(uint32 count) { if (enabled) netStates += count; }
+};
+
+/* Adds the time spent in its scope to a section while profiling is enabled. */
+struct FIKProfileScope
+{
+	FIKProfileScope(EIKProfileSection inSection) : section(inSection), startTime(FIKProfileTimers::enabled ? FPlatformTime::Seconds() : 0.0) {}
+	~FIKProfileScope()
+	{
+		if (!FIKProfileTimers::enabled || startTime == 0.0) return;
+		FIKProfileTimers::seconds[(int32)section] += FPlatformTime::Seconds() - startTime;
+		FIKProfileTimers::calls[(int32)section]++;
+	}
+
+private:
+
+	EIKProfileSection section; /* The section being timed. */
+	double startTime; /* The time the scope was entered, 0 if profiling was disabled. */
+};
+
+#if IK_PROFILING
+/* Times the rest of the enclosing scope as the given EIKProfileSection, as a cycle stat, CSV stat, Insights event and benchmark timer. */
+#define IK_PROFILE_SCOPE(Section) \
+	SCOPE_CYCLE_COUNTER(STAT_IK_##Section); \
+	CSV_SCOPED_TIMING_STAT(IK, Section); \
+	TRACE_CPUPROFILER_EVENT_SCOPE(IK_##Section); \
+	FIKProfileScope ANONYMOUS_VARIABLE(IKProfileScope)(EIKProfileSection::Section)
+
+/* Counts a floor trace result in the hit or miss stat. */
+#define IK_COUNT_TRACE_RESULT(bHit) \
+	do { if (bHit) { INC_DWORD_STAT(STAT_IK_TraceHits); } else { INC_DWORD_STAT(STAT_IK_TraceMisses); } } while (0)
+#else
+#define IK_PROFILE_SCOPE(Section)
+#define IK_COUNT_TRACE_RESULT(bHit)
+#endif
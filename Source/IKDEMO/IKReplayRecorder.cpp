@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKReplayRecorder.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogIKReplay, Log, All);
+
+/* How many bytes are buffered before they are written to the file. */
+static const int32 ReplayFlushSize = 64 * 1024;
+
+static FAutoConsoleCommand IKRecordStartCommand(
+	TEXT("ik.Record.Start"),
+	TEXT("Starts recording the IK updates of every character for ik_replay. Optionally takes the file to record to."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& args) { FIKReplayRecorder::Start(args.Num() > 0 ? args[0] : FString()); }));
+
+static FAutoConsoleCommand IKRecordStopCommand(
+	TEXT("ik.Record.Stop"),
+	TEXT("Stops recording the IK updates."),
+	FConsoleCommandDelegate::CreateStatic(&FIKReplayRecorder::Stop));
+
+TUniquePtr<IKCore::ReplayWriter> FIKReplayRecorder::writer;
+TUniquePtr<IFileHandle> FIKReplayRecorder::file;
+TSet<uint32> FIKReplayRecorder::recordedCharacters;
+FString FIKReplayRecorder::path;
+uint64 FIKReplayRecorder::recordedFrames = 0;
+
+bool FIKReplayRecorder::Start(const FString& inPath)
+{
+	Stop();
+
+	// Open the file, making its directory if needed.
+	path = inPath.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("IKRecordings") / FString::Printf(TEXT("IKRecording_%s.ikrp"), *FDateTime::Now().ToString()) : inPath;
+	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+	platformFile.CreateDirectoryTree(*FPaths::GetPath(path));
+	file.Reset(platformFile.OpenWrite(*path));
+	if (!file.IsValid())
+	{
+		UE_LOG(LogIKReplay, Error, TEXT("Could not open %s to record IK to."), *path);
+		return false;
+	}
+
+	// Write out the rest of the recording if the game quits while recording.
+	static bool stopOnExitBound = false;
+	if (!stopOnExitBound)
+	{
+		FCoreDelegates::OnExit.AddStatic(&FIKReplayRecorder::Stop);
+		stopOnExitBound = true;
+	}
+
+	writer = MakeUnique<IKCore::ReplayWriter>();
+	recordedCharacters.Reset();
+	recordedFrames = 0;
+	UE_LOG(LogIKReplay, Display, TEXT("Recording IK to %s"), *path);
+	return true;
+}
+
+void FIKReplayRecorder::Stop()
+{
+	if (!IsRecording()) return;
+
+	Flush();
+	file.Reset();
+	writer.Reset();
+	UE_LOG(LogIKReplay, Display, TEXT("Recorded %llu IK updates of %d characters to %s"), recordedFrames, recordedCharacters.Num(), *path);
+}
+
+void FIKReplayRecorder::RecordFrame(const IKCore::ReplayCharacter& character, const IKCore::ReplayFrame& frame)
+{
+	if (!IsRecording()) return;
+
+	bool alreadyRecorded = false;
+	recordedCharacters.Add(character.id, &alreadyRecorded);
+	if (!alreadyRecorded) writer->WriteCharacter(character);
+	writer->WriteFrame(frame);
+	recordedFrames++;
+
+	if ((int32)writer->GetBuffer().size() >= ReplayFlushSize) Flush();
+}
+
+void FIKReplayRecorder::Flush()
+{
+	const std::vector<uint8_t>& buffer = writer->GetBuffer();
+	if (buffer.empty()) return;
+
+	// Stop rather than keep recording a stream with a hole in it.
+	if (!file->Write(buffer.data(), (int64)buffer.size()))
+	{
+		UE_LOG(LogIKReplay, Error, TEXT("Could not write to %s, stopping the IK recording."), *path);
+		file.Reset();
+		writer.Reset();
+		return;
+	}
+	writer->Clear();
+}
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "IKCoreReplay.h"
+
+class IFileHandle;
+
+/* Records the inputs and outputs of every IK characters IK updates to a replay stream on disk, to be replayed with ik_replay.
+ * Started and stopped with the ik.Record.Start [Path] and ik.Record.Stop console commands. Game thread only. */
+class IKDEMO_API FIKReplayRecorder
+{
+public:
+
+	/* Returns true while recording. */
+	static bool IsRecording() { return writer.IsValid(); }
+
+	/* Starts recording to the given file, or a new file in Saved/IKRecordings if empty. Returns false if the file cannot be opened. */
+	static bool Start(const FString& inPath = FString());
+
+	/* Writes anything left and closes the file. */
+	static void Stop();
+
+	/* Records a characters IK update, writing its settings first if it has not been recorded before. */
+	static void RecordFrame(const IKCore::ReplayCharacter& character, const IKCore::ReplayFrame& frame);
+
+private:
+
+	/* Writes the buffered records to the file. */
+	static void Flush();
+
+private:
+
+	static TUniquePtr<IKCore::ReplayWriter> writer; /* Buffers the records between flushes. */
+	static TUniquePtr<IFileHandle> file; /* The file being recorded to. */
+	static TSet<uint32> recordedCharacters; /* The characters that have had their settings written. */
+	static FString path; /* The path of the file being recorded to. */
+	static uint64 recordedFrames; /* The number of frames recorded. */
+};
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKSettings.h"
+
+UIKSettings::UIKSettings()
+{
+	// Setup default trace settings.
+	footTraceMode = EIKFootTraceMode::Blocking;
+	maxTraceResultAge = 2;
+	footTraceBudgetMicroseconds = 0.0f;
+	floorQueryBackend = EIKFloorQueryBackend::Physics;
+	useFloorHeightfield = true;
+	heightfieldDynamicSweeps = true;
+	groundCacheEnabled = true;
+	groundCacheTolerance = 0.5f;
+
+	// Setup default LOD settings.
+	reducedIKDistance = 1500.0f;
+	frozenIKDistance = 4000.0f;
+	freezeIKWhenNotRendered = true;
+
+	// Setup default network settings.
+	skipIKOnDedicatedServer = true;
+	replicateIK = true;
+	ikNetSendInterval = 0.1f;
+	ikNetInterpSpeed = 15.0f;
+
+	// Setup default sleep settings.
+	sleepIdleCharacters = true;
+	sleepDelay = 0.5f;
+	sleepTolerance = 0.1f;
+	sleepLODCheckInterval = 0.25f;
+
+	// Setup default ragdoll settings.
+	maxActiveRagdolls = 8;
+	freezeSettledRagdolls = true;
+	ragdollSettleSpeed = 5.0f;
+	ragdollSettleTime = 1.0f;
+	reducedRagdollDistance = 2000.0f;
+	ragdollLODHysteresis = 250.0f;
+
+	// Setup default threading settings.
+	parallelIKTick = true;
+	parallelIKBatchSize = 16;
+
+	// Setup default anim budget settings.
+	animBudgetEnabled = true;
+	animBudgetMilliseconds = 2.0f;
+	animBudgetMaxTickRate = 4;
+	animBudgetIKSignificance = 0.5f;
+}
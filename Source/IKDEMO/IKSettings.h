@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "IKSettings.generated.h"
+
+/* How the foot traces for the IK update are performed. */
+UENUM(BlueprintType)
+enum class EIKFootTraceMode : uint8
+{
+	Blocking,	/* Each character sweeps on the game thread during its own update. */
+	Async,		/* Each character queues its sweeps on the worlds async trace queue and uses them next frame. */
+	Batched		/* The IK manager collects the sweeps of every character and runs them in one pass, used next frame. */
+};
+
+/* What the static floor under each foot is found with. */
+UENUM(BlueprintType)
+enum class EIKFloorQueryBackend : uint8
+{
+	Physics,	/* Sweeps against the worlds physics scene. */
+	BVH			/* Sweeps against the levels static floors exported with -run=IKFloorExport, falling back to physics if it has not been exported. */
+};
+
+/* Project wide settings for the IK characters. Found under Project Settings > Game > IK. */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "IK"))
+class IKDEMO_API UIKSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Constructor. */
+	UIKSettings();
+
+	/* Returns the default settings object. */
+	static const UIKSettings* Get() { return GetDefault<UIKSettings>(); }
+
+public:
+
+	/* How the foot traces are performed.
+	 * NOTE: With async or batched traces, traces requested in frame N are used by the IK update in frame N+1. */
+	UPROPERTY(config, EditAnywhere, Category = "Traces")
+	EIKFootTraceMode footTraceMode;
+
+	/* The maximum age in frames an async or batched foot trace result can be before a blocking trace is used instead. */
+	UPROPERTY(config, EditAnywhere, Category = "Traces", meta = (ClampMin = "1"))
+	int32 maxTraceResultAge;
+
+	/* The time in microseconds every IK characters foot traces can take in a frame. Characters over budget hold their last IK pose. 0 is unlimited. */
+	UPROPERTY(config, EditAnywhere, Category = "Traces", meta = (ClampMin = "0"))
+	float footTraceBudgetMicroseconds;
+
+	/* What the static floor traces sweep against. Compare the two in game with ik.FloorQuery.Compare. */
+	UPROPERTY(config, EditAnywhere, Category = "Traces")
+	EIKFloorQueryBackend floorQueryBackend;
+
+	/* Should the feet use the levels baked floor heightfield, if it has one, instead of tracing against static geometry? */
+	UPROPERTY(config, EditAnywhere, Category = "Traces")
+	bool useFloorHeightfield;
+
+	/* Should the feet still be swept against dynamic objects where the floor heightfield is used? */
+	UPROPERTY(config, EditAnywhere, Category = "Traces", meta = (EditCondition = "useFloorHeightfield"))
+	bool heightfieldDynamicSweeps;
+
+	/* Should the floor under each foot be reused while neither the character or the floor have moved? */
+	UPROPERTY(config, EditAnywhere, Category = "Traces")
+	bool groundCacheEnabled;
+
+	/* How far a foot trace can move from where the cached floor was traced from before it is traced again. */
+	UPROPERTY(config, EditAnywhere, Category = "Traces", meta = (ClampMin = "0", EditCondition = "groundCacheEnabled"))
+	float groundCacheTolerance;
+
+	/* Characters further than this from the camera update IK at their reduced ikUpdateRate and interpolate between updates. */
+	UPROPERTY(config, EditAnywhere, Category = "LOD", meta = (ClampMin = "0"))
+	float reducedIKDistance;
+
+	/* Characters further than this from the camera stop tracing and keep their default feet positions. */
+	UPROPERTY(config, EditAnywhere, Category = "LOD", meta = (ClampMin = "0"))
+	float frozenIKDistance;
+
+	/* Should characters that have not been rendered recently keep their default feet positions? */
+	UPROPERTY(config, EditAnywhere, Category = "LOD")
+	bool freezeIKWhenNotRendered;
+
+	/* Should dedicated servers skip the IK traces, only sizing the capsule from the IK sent by the owning client? */
+	UPROPERTY(config, EditAnywhere, Category = "Network")
+	bool skipIKOnDedicatedServer;
+
+	/* Should simulated proxies use the quantised IK replicated from the machine controlling them instead of tracing their own feet? */
+	UPROPERTY(config, EditAnywhere, Category = "Network")
+	bool replicateIK;
+
+	/* The shortest time in seconds between an owning client sending its IK to the server. */
+	UPROPERTY(config, EditAnywhere, Category = "Network", meta = (ClampMin = "0"))
+	float ikNetSendInterval;
+
+	/* How fast simulated proxies interpolate towards the latest replicated IK. */
+	UPROPERTY(config, EditAnywhere, Category = "Network", meta = (ClampMin = "0", EditCondition = "replicateIK"))
+	float ikNetInterpSpeed;
+
+	/* Should characters that are idle with their IK settled turn off their actor and movement ticks until input, a movement event or something moving into them wakes them? */
+	UPROPERTY(config, EditAnywhere, Category = "Sleep")
+	bool sleepIdleCharacters;
+
+	/* How long in seconds a character has to stay idle and settled before it goes to sleep. Keep above the reduced IK update rate. */
+	UPROPERTY(config, EditAnywhere, Category = "Sleep", meta = (ClampMin = "0", EditCondition = "sleepIdleCharacters"))
+	float sleepDelay;
+
+	/* How far the IK pose or capsule height can change in a frame and still count as settled. */
+	UPROPERTY(config, EditAnywhere, Category = "Sleep", meta = (ClampMin = "0", EditCondition = "sleepIdleCharacters"))
+	float sleepTolerance;
+
+	/* How often in seconds the IK manager checks if a sleeping characters IK LOD tier has changed, waking it if so. */
+	UPROPERTY(config, EditAnywhere, Category = "Sleep", meta = (ClampMin = "0", EditCondition = "sleepIdleCharacters"))
+	float sleepLODCheckInterval;
+
+	/* The most ragdolls that can simulate at once in a world. Characters over budget play their fall montage instead. 0 is unlimited. */
+	UPROPERTY(config, EditAnywhere, Category = "Ragdoll", meta = (ClampMin = "0"))
+	int32 maxActiveRagdolls;
+
+	/* Should ragdolls that have settled be frozen in their pose, stopping their simulation and freeing their slot in the budget? */
+	UPROPERTY(config, EditAnywhere, Category = "Ragdoll")
+	bool freezeSettledRagdolls;
+
+	/* The speed a ragdolls root body has to stay under to be settled. */
+	UPROPERTY(config, EditAnywhere, Category = "Ragdoll", meta = (ClampMin = "0", EditCondition = "freezeSettledRagdolls"))
+	float ragdollSettleSpeed;
+
+	/* How long in seconds a ragdoll has to stay settled before it is frozen. */
+	UPROPERTY(config, EditAnywhere, Category = "Ragdoll", meta = (ClampMin = "0", EditCondition = "freezeSettledRagdolls"))
+	float ragdollSettleTime;
+
+	/* Ragdolls further than this from the camera, or not rendered recently, simulate their characters reducedPhysicsAsset. */
+	UPROPERTY(config, EditAnywhere, Category = "Ragdoll", meta = (ClampMin = "0"))
+	float reducedRagdollDistance;
+
+	/* How much closer than reducedRagdollDistance a reduced ragdoll has to come before it switches back to its full physics asset. */
+	UPROPERTY(config, EditAnywhere, Category = "Ragdoll", meta = (ClampMin = "0"))
+	float ragdollLODHysteresis;
+
+	/* Should the IK of every character run together in the IK managers tick function, with the foot sweeps spread over the task graph workers?
+	 * NOTE: The ground caches, deferred traces and component updates stay on the game thread, only the blocking foot sweeps run in parallel. */
+	UPROPERTY(config, EditAnywhere, Category = "Threading")
+	bool parallelIKTick;
+
+	/* How many characters' foot sweeps each task graph worker takes at a time in the parallel IK tick. */
+	UPROPERTY(config, EditAnywhere, Category = "Threading", meta = (ClampMin = "1", EditCondition = "parallelIKTick"))
+	int32 parallelIKBatchSize;
+
+	/* Should the animation budget allocator tick the IK characters meshes at reduced rates, least significant first, to keep their animation within animBudgetMilliseconds? */
+	UPROPERTY(config, EditAnywhere, Category = "Anim Budget")
+	bool animBudgetEnabled;
+
+	/* The time in milliseconds the animation of every budgeted mesh can take in a frame, given to the allocator as a.Budget.BudgetMs. */
+	UPROPERTY(config, EditAnywhere, Category = "Anim Budget", meta = (ClampMin = "0", EditCondition = "animBudgetEnabled"))
+	float animBudgetMilliseconds;
+
+	/* The most frames one animation update can cover for a mesh the budget has slowed down, given to the allocator as a.Budget.MaxTickRate. */
+	UPROPERTY(config, EditAnywhere, Category = "Anim Budget", meta = (ClampMin = "2", EditCondition = "animBudgetEnabled"))
+	int32 animBudgetMaxTickRate;
+
+	/* Characters with a significance below this have their IK turned off when the allocator asks them to reduce work. Significance is 0.5 at reducedIKDistance and 0 when not rendered. */
+	UPROPERTY(config, EditAnywhere, Category = "Anim Budget", meta = (ClampMin = "0", ClampMax = "1", EditCondition = "animBudgetEnabled"))
+	float animBudgetIKSignificance;
+};
@@ -0,0 +1,9 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKSkeletalMeshComponent.h"
+
+UIKSkeletalMeshComponent::UIKSkeletalMeshComponent()
+{
+	// Registered with the budget allocator when the mesh is registered, the IK manager gives it its significance.
+	SetAutoRegisterWithBudgetAllocator(true);
+}
@@ -0,0 +1,19 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "SkeletalMeshComponentBudgeted.h"
+#include "IKSkeletalMeshComponent.generated.h"
+
+/* Skeletal mesh of the IK characters, ticked by the worlds animation budget allocator at the rate it gives each mesh for its significance.
+ * NOTE: The IK manager sets the significance every frame, the owning character turns its IK off when the allocator asks it to reduce work. */
+UCLASS(ClassGroup = (IK), meta = (BlueprintSpawnableComponent))
+class IKDEMO_API UIKSkeletalMeshComponent : public USkeletalMeshComponentBudgeted
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Constructor. */
+	UIKSkeletalMeshComponent();
+};
@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKTraceBudget.h"
+#include "IKSettings.h"
+
+uint64 FIKTraceBudget::budgetFrame = 0;
+double FIKTraceBudget::secondsUsed = 0.0;
+
+bool FIKTraceBudget::HasBudget()
+{
+	// A budget of 0 is unlimited.
+	float budgetMicroseconds = UIKSettings::Get()->footTraceBudgetMicroseconds;
+	if (budgetMicroseconds <= 0.0f) return true;
+
+	RefreshFrame();
+	return secondsUsed * 1000000.0 < budgetMicroseconds;
+}
+
+double FIKTraceBudget::GetRemainingSeconds()
+{
+	float budgetMicroseconds = UIKSettings::Get()->footTraceBudgetMicroseconds;
+	if (budgetMicroseconds <= 0.0f) return TNumericLimits<double>::Max();
+
+	RefreshFrame();
+	return FMath::Max(budgetMicroseconds / 1000000.0 - secondsUsed, 0.0);
+}
+
+void FIKTraceBudget::Consume(double seconds)
+{
+	RefreshFrame();
+	secondsUsed += seconds;
+}
+
+void FIKTraceBudget::RefreshFrame()
+{
+	if (budgetFrame != GFrameCounter)
+	{
+		budgetFrame = GFrameCounter;
+		secondsUsed = 0.0;
+	}
+}
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+
+/* Global per frame time budget shared by the foot traces of every IK character. The budget size is set in UIKSettings. */
+struct IKDEMO_API FIKTraceBudget
+{
+	/* Returns true if there is time left in this frames foot trace budget. */
+	static bool HasBudget();
+
+	/* Returns the time left in this frames foot trace budget, the largest double when it is unlimited. */
+	static double GetRemainingSeconds();
+
+	/* Adds time spent tracing to this frames budget. */
+	static void Consume(double seconds);
+
+private:
+
+	/* Starts a new frame of budget if the frame has changed since it was last used. */
+	static void RefreshFrame();
+
+	static uint64 budgetFrame; /* The frame the time used was counted in. */
+	static double secondsUsed; /* The time used by foot traces so far this frame. */
+};
+
+/* Charges the time spent in its scope to the foot trace budget. */
+struct FIKTraceBudgetScope
+{
+	FIKTraceBudgetScope() : startTime(FPlatformTime::Seconds()) {}
+	~FIKTraceBudgetScope() { FIKTraceBudget::Consume(FPlatformTime::Seconds() - startTime); }
+
+private:
+
+	double startTime; /* The time the scope was entered. */
+};
@@ -5,16 +5,29 @@
 #include "Components/InputComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Engine/World.h"
 #include "Engine/GameEngine.h"
 #include "TimerManager.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "PhysicsEngine/BodySetup.h"
 #include "Runtime/Core/Public/Containers/Array.h"
-#include "DrawDebugHelpers.h"
 #include "IKAnimInstance.h"
+#include "IKSettings.h"
+#include "IKManager.h"
+#include "IKTraceBudget.h"
+#include "IKProfiling.h"
+#include "IKCoreConversions.h"
+#include "IKCharacterMovementComponent.h"
+#include "IKSkeletalMeshComponent.h"
+#include "Net/UnrealNetwork.h"
+#include "IKReplayRecorder.h"
 
-AMainPlayer::AMainPlayer()
+AMainPlayer::AMainPlayer(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UIKCharacterMovementComponent>(ACharacter::CharacterMovementComponentName)
+		.SetDefaultSubobjectClass<UIKSkeletalMeshComponent>(ACharacter::MeshComponentName))
 {
 	PrimaryActorTick.bCanEverTick = true;
 
@@ -57,16 +70,42 @@ AMainPlayer::AMainPlayer()
 	rightFootSocketName = "Base-HumanRFootSocket";
 	mouseSpeed = 45.f;
 	ragdollEnabled = false;
+	ragdollFrozen = false;
+	overBudgetFall = false;
+	fallMontage = nullptr;
+	reducedPhysicsAsset = nullptr;
+	fullPhysicsAsset = nullptr;
+	getUpMontage = nullptr;
+	getUpBlendTime = 0.6f;
+	gettingUp = false;
+	getUpTime = 0.0f;
+	meshDefaultParent = nullptr;
 	jumpRotationSpeed = 0.1f;
-	debugEnabled = true;
+	debugEnabled = false;
 	movementReleased = false;
+	sleeping = false;
+	idleTime = 0.0f;
+	sleepCheckCapsuleHeight = 0.0f;
+	ikNetStateValid = false;
+	ikNetSendTime = 0.0f;
+	ikNetOffsets = FVector::ZeroVector;
 	groundCheckDistance = 40.0f;
 	defaultFloorDistance = 0.0f;
 	hipOffset = 20.0f;
-	ikUpdateRate = 0.01f;
+	ikUpdateRate = 0.1f;
+	ikLODTier = EIKLODTier::Full;
+	ikTimeSinceUpdate = 0.0f;
+	animBudgetIKOff = false;
+	scriptedForward = 0.0f;
+	scriptedRight = 0.0f;
 	isIKEnabled = false;
 	capsuleInterpSpeed = 7.0f;
+	capsuleAdjustMode = ECapsuleAdjustMode::Threshold;
+	capsuleResizeThreshold = 1.0f;
+	capsuleInterpHeight = 0.0f;
+	playerHolderOriginalZ = 0.0f;
 	footTraceRadius = 5.0f;
+	complexFloorTraces = false;
 }
 
 void AMainPlayer::BeginPlay()
@@ -75,6 +114,15 @@ void AMainPlayer::BeginPlay()
 
 	// Setup IK update timer to be enabled by default.
 	isIKEnabled = true;
+	footTraceDelegate.BindUObject(this, &AMainPlayer::OnFootTraceDone);
+
+	// Geometry moving into the capsule may have changed the floor.
+	GetCapsuleComponent()->OnComponentHit.AddDynamic(this, &AMainPlayer::OnCapsuleHit);
+	GetCapsuleComponent()->OnComponentBeginOverlap.AddDynamic(this, &AMainPlayer::OnCapsuleBeginOverlap);
+
+	// Register with the worlds IK manager.
+	ikManager = AIKManager::Get(GetWorld());
+	if (ikManager.IsValid()) ikManager->RegisterCharacter(this);
 
 	// Get default floor distance also.
 	float hipsWorldZ = GetCapsuleComponent()->GetComponentLocation().Z;
@@ -87,57 +135,257 @@ void AMainPlayer::BeginPlay()
 	leftRelativeFoot = capTrans.InverseTransformPositionNoScale(leftFloorHit);
 	rightRelativeFoot = capTrans.InverseTransformPositionNoScale(rightFloorHit);
 
-	// Save default capsule half height.
+	// The animation budget allocator asks the least significant meshes to reduce their work, which turns their IK off.
+	if (UIKSkeletalMeshComponent* budgetedMesh = Cast<UIKSkeletalMeshComponent>(GetMesh())) budgetedMesh->OnReduceWork().BindUObject(this, &AMainPlayer::OnAnimBudgetReduceWork);
+
+	// Save the full physics asset to return to from the reduced one.
+	fullPhysicsAsset = GetMesh()->GetPhysicsAsset();
+
+	// Save where the mesh and camera go back to after ragdoll.
+	meshDefaultParent = GetMesh()->GetAttachParent();
+	meshDefaultTransform = GetMesh()->GetRelativeTransform();
+	camBoomDefaultLocation = camBoom->RelativeLocation;
+
+	// Save default capsule half height and mesh holder height.
 	capsuleOriginalHeight = GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
+	capsuleInterpHeight = capsuleOriginalHeight;
+	playerHolderOriginalZ = playerHolder->RelativeLocation.Z;
 
 	// Setup default feet positioning.
 	UpdateDefaultFeetPosition();
 }
 
+void AMainPlayer::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Stop receiving batched foot traces.
+	if (ikManager.IsValid()) ikManager->UnregisterCharacter(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void AMainPlayer::Tick(float DeltaTime)
 {
+	IK_PROFILE_SCOPE(Tick);
 	Super::Tick(DeltaTime);
 
 	// If ragdoll is enabled update the camera boom location around the ragdoll.
 	if (ragdollEnabled)
 	{
 		// Move the camera to its location based off the base human pelvis.
-		FVector newCamLocation = GetMesh()->GetBoneLocation(rootName, EBoneSpaces::WorldSpace);
+		FVector newCamLocation = GetRootBoneLocation();
 		newCamLocation -= originalOffset;
 		camBoom->SetWorldLocation(newCamLocation);
 	}
 
-	// When the character is in air do not allow rotation towards movement.
-	if (GetCharacterMovement()->IsFalling())
+	// While getting up the capsule, mesh and camera are moved back into place instead of moving or running IK.
+	if (gettingUp)
 	{
-		GetCharacterMovement()->RotationRate = FRotator(0.0f, 0.0f, 0.0f);
+		TickGetUp(DeltaTime);
+		return;
 	}
-	// Dont run code if the vector is not 0.
-	else if (GetCharacterMovement()->RotationRate.IsZero())
+
+	// Characters without player input are driven by their scripted input.
+	if (!InputComponent)
 	{
-		GetCharacterMovement()->RotationRate = FRotator(0.0f, 400.0f, 0.0f);
+		MoveForward(scriptedForward);
+		MoveRight(scriptedRight);
 	}
 
 	// Get is moving.
-	bool isMoving = InputComponent->GetAxisValue(FName("MoveForward")) != 0.0f || InputComponent->GetAxisValue(FName("MoveRight")) != 0.0f;
+	bool isMoving = InputComponent ? InputComponent->GetAxisValue(FName("MoveForward")) != 0.0f || InputComponent->GetAxisValue(FName("MoveRight")) != 0.0f
+								   : scriptedForward != 0.0f || scriptedRight != 0.0f;
 
-	// If all movement has stopped including release delay...
-	if (movementReleased && !isMoving)
-	{
-		// Keep moving forward and ease out of movement. (Workaround)
-		AddMovementInput(lastDirectionMovement, lastDirectionScale);
-		GetCharacterMovement()->MaxWalkSpeed -= 1000 * DeltaTime;
+	// The movement component brakes once the input is released, the release ends when it has stopped.
+	if (movementReleased && !isMoving && GetCharacterMovement()->Velocity.IsNearlyZero(1.0f)) movementReleased = false;
 
-		// End release delay when max walk speed becomes less than 0.
-		if (GetCharacterMovement()->MaxWalkSpeed <= 0) movementReleased = false;
+	// Dedicated servers only size the capsule from the owning clients IK.
+	bool ikTickQueued = false;
+	if (SkipsIKTraces())
+	{
+		if (ikNetStateValid && isIKEnabled) UpdateCapsule(ikNetState.GetOffsets().Z);
+	}
+	else
+	{
+		// With the parallel IK tick the IK runs in the IK managers tick function together with every other character.
+		bool runIK = isIKEnabled && !GetCharacterMovement()->IsFalling() && !isMoving;
+		ikTickQueued = ikManager.IsValid() && UIKSettings::Get()->parallelIKTick;
+		if (ikTickQueued) ikManager->QueueIKTick(this, runIK, DeltaTime);
+		// If IK is enabled update it.
+		else if (runIK) TickIK(DeltaTime);
+		// Otherwise update default values.
+		else UpdateDefaultFeetPosition();
 	}
-	// Set movement back to normal.
-	else GetCharacterMovement()->MaxWalkSpeed = 500.0f;
 
-	// If IK is enabled update it.
-	if (isIKEnabled && !GetCharacterMovement()->IsFalling() && !isMoving) UpdateIK();
-	// Otherwise update default values.
-	else UpdateDefaultFeetPosition();
+	// Share the IK with the other machines in a networked game, once the parallel IK tick has run it if it was queued.
+	if (!ikTickQueued) ShareIKNetState(DeltaTime);
+
+	// Stop ticking once idle with nothing left to settle.
+	if (UIKSettings::Get()->sleepIdleCharacters) UpdateSleep(DeltaTime, isMoving);
+}
+
+void AMainPlayer::AddMovementInput(FVector WorldDirection, float ScaleValue, bool bForce)
+{
+	if (ScaleValue != 0.0f && !WorldDirection.IsZero()) WakeUp();
+	Super::AddMovementInput(WorldDirection, ScaleValue, bForce);
+}
+
+void AMainPlayer::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// The owner already has its own IK.
+	DOREPLIFETIME_CONDITION(AMainPlayer, ikNetState, COND_SkipOwner);
+}
+
+bool AMainPlayer::ServerSetIKNetState_Validate(FIKNetState state)
+{
+	return true;
+}
+
+void AMainPlayer::ServerSetIKNetState_Implementation(FIKNetState state)
+{
+	ikNetState = state;
+	ikNetStateValid = true;
+	FIKProfileTimers::AddNetStates(1);
+	INC_DWORD_STAT(STAT_IK_NetStatesReceived);
+
+	// A sleeping character has to tick to size its capsule from the new state.
+	WakeUp();
+}
+
+void AMainPlayer::OnRep_IKNetState()
+{
+	ikNetStateValid = true;
+	FIKProfileTimers::AddNetStates(1);
+	INC_DWORD_STAT(STAT_IK_NetStatesReceived);
+	WakeUp();
+}
+
+bool AMainPlayer::UsesReplicatedIK() const
+{
+	return UIKSettings::Get()->replicateIK && Role == ROLE_SimulatedProxy && ikNetStateValid;
+}
+
+bool AMainPlayer::SkipsIKTraces() const
+{
+	return UIKSettings::Get()->skipIKOnDedicatedServer && GetNetMode() == NM_DedicatedServer;
+}
+
+void AMainPlayer::TickReplicatedIK(float DeltaTime)
+{
+	// Smooth out the steps between net updates.
+	ikNetOffsets = FMath::VInterpTo(ikNetOffsets, ikNetState.GetOffsets(), DeltaTime, UIKSettings::Get()->ikNetInterpSpeed);
+	FIKFeetPose pose = DecodeIKNetState(ikNetOffsets);
+	WriteIKPose(pose);
+	ikToPose = pose;
+	UpdateCapsule(pose.hipOffset);
+}
+
+void AMainPlayer::ShareIKNetState(float DeltaTime)
+{
+	ENetMode netMode = GetNetMode();
+	if (netMode != NM_Standalone && netMode != NM_DedicatedServer && IsLocallyControlled()) SendIKNetState(DeltaTime);
+}
+
+void AMainPlayer::SendIKNetState(float DeltaTime)
+{
+	ikNetSendTime += DeltaTime;
+	FIKNetState state = EncodeIKNetState(ikCurrentPose);
+	if (state == ikNetState) return;
+
+	// Owning clients send at most every ikNetSendInterval, the owner never receives the replicated state so it holds the last one sent.
+	bool authority = HasAuthority();
+	if (!authority && ikNetSendTime < UIKSettings::Get()->ikNetSendInterval) return;
+	ikNetSendTime = 0.0f;
+	ikNetState = state;
+	ikNetStateValid = true;
+	FIKProfileTimers::AddNetStates(1);
+	INC_DWORD_STAT(STAT_IK_NetStatesSent);
+
+	// The server sets the replicated state itself, letting property replication send it.
+	if (!authority) ServerSetIKNetState(state);
+}
+
+FIKNetState AMainPlayer::EncodeIKNetState(const FIKFeetPose& pose) const
+{
+	float bottomOfCapsuleZ = GetCapsuleComponent()->GetComponentLocation().Z - GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	return FIKNetState(pose.leftFoot.Z - bottomOfCapsuleZ, pose.rightFoot.Z - bottomOfCapsuleZ, pose.hipOffset);
+}
+
+FIKFeetPose AMainPlayer::DecodeIKNetState(const FVector& offsets) const
+{
+	// Put the default feet at the given heights above the bottom of the capsule.
+	FTransform capTrans = GetCapsuleComponent()->GetComponentTransform();
+	float bottomOfCapsuleZ = capTrans.GetLocation().Z - GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	FVector leftFoot = capTrans.TransformPositionNoScale(leftRelativeFoot);
+	FVector rightFoot = capTrans.TransformPositionNoScale(rightRelativeFoot);
+	leftFoot.Z = bottomOfCapsuleZ + offsets.X;
+	rightFoot.Z = bottomOfCapsuleZ + offsets.Y;
+	return FIKFeetPose(leftFoot, rightFoot, offsets.Z);
+}
+
+void AMainPlayer::OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PrevMovementMode, PreviousCustomMode);
+	WakeUp();
+}
+
+void AMainPlayer::Landed(const FHitResult& Hit)
+{
+	Super::Landed(Hit);
+	WakeUp();
+}
+
+bool AMainPlayer::IsIdle(bool isMoving) const
+{
+	if (isMoving || movementReleased || ragdollEnabled || gettingUp || bPressedJump) return false;
+
+	// Stood still on the floor with nothing queued for the movement component.
+	UCharacterMovementComponent* movement = GetCharacterMovement();
+	if (!movement->IsMovingOnGround() || !movement->Velocity.IsNearlyZero(1.0f) || !movement->GetPendingInputVector().IsZero()) return false;
+
+	// Moving floors carry the character through the movement component, so it has to keep ticking.
+	UPrimitiveComponent* movementBase = GetMovementBase();
+	return !movementBase || movementBase->Mobility != EComponentMobility::Movable;
+}
+
+void AMainPlayer::UpdateSleep(float DeltaTime, bool isMoving)
+{
+	// The IK has settled once the pose and capsule have stopped changing between frames.
+	const UIKSettings* settings = UIKSettings::Get();
+	const float tolerance = settings->sleepTolerance;
+	bool settled = FVector::DistSquared(ikCurrentPose.leftFoot, sleepCheckPose.leftFoot) <= FMath::Square(tolerance)
+		&& FVector::DistSquared(ikCurrentPose.rightFoot, sleepCheckPose.rightFoot) <= FMath::Square(tolerance)
+		&& FMath::Abs(ikCurrentPose.hipOffset - sleepCheckPose.hipOffset) <= tolerance
+		&& FMath::Abs(capsuleInterpHeight - sleepCheckCapsuleHeight) <= tolerance;
+	sleepCheckPose = ikCurrentPose;
+	sleepCheckCapsuleHeight = capsuleInterpHeight;
+
+	idleTime = settled && IsIdle(isMoving) ? idleTime + DeltaTime : 0.0f;
+	if (idleTime < settings->sleepDelay) return;
+
+	// Take the character and its movement component off the tick list until something wakes it.
+	sleeping = true;
+	SetActorTickEnabled(false);
+	GetCharacterMovement()->SetComponentTickEnabled(false);
+	if (ikManager.IsValid()) ikManager->AddSleepingCharacter(this);
+}
+
+void AMainPlayer::WakeUp()
+{
+	idleTime = 0.0f;
+	if (!sleeping) return;
+
+	sleeping = false;
+	SetActorTickEnabled(true);
+	GetCharacterMovement()->SetComponentTickEnabled(true);
+	if (ikManager.IsValid()) ikManager->RemoveSleepingCharacter(this);
+}
+
+void AMainPlayer::CheckSleepingLOD()
+{
+	// Characters that came into view or range have to tick again to trace their feet.
+	if (isIKEnabled && GetIKLODTier() != ikLODTier) WakeUp();
 }
 
 void AMainPlayer::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -180,11 +428,10 @@ void AMainPlayer::MoveForward(float value)
 		const FRotator YawRotation(0, Rotation.Yaw, 0);
 
 		// Get forward vector
-		lastDirectionMovement = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X);
-		lastDirectionScale = value;
+		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X);
 
 		// Add movement in that direction
-		AddMovementInput(lastDirectionMovement, value);
+		AddMovementInput(Direction, value);
 
 		// Initiate slow down as soon as the value becomes 0...
 		movementReleased = true;
@@ -201,11 +448,10 @@ void AMainPlayer::MoveRight(float value)
 		const FRotator YawRotation(0, Rotation.Yaw, 0);
 
 		// Get right vector 
-		lastDirectionMovement = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y);
-		lastDirectionScale = value;
+		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y);
 
 		// Add movement in that direction
-		AddMovementInput(lastDirectionMovement, value);
+		AddMovementInput(Direction, value);
 
 		// Initiate slow down as soon as the value becomes 0...
 		movementReleased = true;
@@ -214,29 +460,55 @@ void AMainPlayer::MoveRight(float value)
 
 void AMainPlayer::RagdollToggle()
 {
+	IK_PROFILE_SCOPE(RagdollToggle);
+	WakeUp();
 	if (ragdollEnabled)
 	{
+		INC_DWORD_STAT(STAT_IK_RagdollsDisabled);
+
+		// Give back the ragdoll budget slot and let the skeleton update again if it was frozen.
+		if (ikManager.IsValid()) ikManager->ReleaseRagdoll(this);
+		GetMesh()->bNoSkeletonUpdate = false;
+		ragdollFrozen = false;
+
+		// Snapshot the ragdoll pose for the IK get-up blend anim node to blend from.
+		if (UAnimInstance* animInstance = GetMesh()->GetAnimInstance()) animInstance->SavePoseSnapshot(UIKAnimInstance::GetUpSnapshotName);
+
 		// Get the new location for the capsule in relation to where the physics body currently is.
 		FVector newCapsuleLocation = GetFloorLocation();
 
-		// Reset mesh back to normal as static player character.
+		// Reset mesh back to normal as static player character, with the physics asset it had before the ragdoll.
 		GetMesh()->SetSimulatePhysics(false);
 		GetMesh()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-		GetCharacterMovement()->SetMovementMode(EMovementMode::MOVE_Walking);
-		GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+		if (fullPhysicsAsset && GetMesh()->GetPhysicsAsset() != fullPhysicsAsset) GetMesh()->SetPhysicsAsset(fullPhysicsAsset);
 
-		// Set the new location for the capsule and re-attach and position components.
-		GetCapsuleComponent()->SetWorldLocation(newCapsuleLocation + FVector(0.0f, 0.0f, GetCapsuleComponent()->GetScaledCapsuleHalfHeight()));
-		camBoom->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::KeepRelativeTransform, NAME_None);
-		camBoom->SetRelativeLocation(FVector(0.0f, 0.0f, 0.0f));
-		GetMesh()->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::KeepRelativeTransform, NAME_None);
-		GetMesh()->SetRelativeLocation(FVector(0.0f, 0.0f, -80.0f));
-		GetMesh()->SetRelativeRotation(FRotator(0.0f, -90.0f, 0.0f));
+		// Re-attach the mesh and camera where they are, they are moved back into place over the get-up.
+		GetMesh()->AttachToComponent(meshDefaultParent ? meshDefaultParent : GetCapsuleComponent(), FAttachmentTransformRules::KeepWorldTransform, NAME_None);
+		camBoom->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::KeepWorldTransform, NAME_None);
+		StartGetUp(newCapsuleLocation + FVector(0.0f, 0.0f, GetCapsuleComponent()->GetScaledCapsuleHalfHeight()));
 	}
 	else
 	{
+		// Over the ragdoll budget play the canned fall instead, or let the capsule fall without one. Latched until the feet find the floor again.
+		if (ikManager.IsValid() && !ikManager->RequestRagdoll(this))
+		{
+			overBudgetFall = true;
+			if (fallMontage) PlayAnimMontage(fallMontage);
+			else GetCharacterMovement()->SetMovementMode(EMovementMode::MOVE_Falling);
+			return;
+		}
+		overBudgetFall = false;
+		INC_DWORD_STAT(STAT_IK_RagdollsEnabled);
+
+		// Falling again part way through getting up leaves the rest of the get-up.
+		gettingUp = false;
+		WriteGetUpAlpha(1.0f);
+
 		// Calculate camera offset to retain.
-		originalOffset = GetMesh()->GetBoneTransform(GetMesh()->GetBoneIndex(rootName)).InverseTransformPositionNoScale(camBoom->GetComponentLocation());
+		originalOffset = GetBoneCache().GetRootTransform(GetMesh()).InverseTransformPositionNoScale(camBoom->GetComponentLocation());
+
+		// Pick the physics asset for the distance from the camera before simulating.
+		UpdateRagdollPhysicsLOD();
 
 		// Enable ragdoll by simulating physics on the mesh and setting the new focus point for the spring arm as the root bone for the character mesh.
 		GetMesh()->SetSimulatePhysics(true);
@@ -249,8 +521,155 @@ void AMainPlayer::RagdollToggle()
 		camBoom->AttachToComponent(GetMesh(), FAttachmentTransformRules::KeepRelativeTransform, NAME_None);
 	}
 
-	// Toggle ragdoll value.
+	// Toggle ragdoll value, the floor has to be found again afterwards.
 	ragdollEnabled = !ragdollEnabled;
+	InvalidateGroundCache();
+}
+
+void AMainPlayer::StartGetUp(const FVector& capsuleLocation)
+{
+	getUpTime = 0.0f;
+	getUpStartLocation = GetCapsuleComponent()->GetComponentLocation();
+	getUpTargetLocation = capsuleLocation;
+	getUpMeshStart = GetMesh()->GetRelativeTransform();
+	getUpCamBoomStart = camBoom->RelativeLocation;
+	if (getUpMontage) PlayAnimMontage(getUpMontage);
+
+	// The capsule stays without collision or movement until it is back under the mesh.
+	gettingUp = true;
+	if (getUpBlendTime <= 0.0f) FinishGetUp();
+	else WriteGetUpAlpha(0.0f);
+}
+
+void AMainPlayer::TickGetUp(float DeltaTime)
+{
+	getUpTime += DeltaTime;
+	float alpha = FMath::Clamp(getUpTime / getUpBlendTime, 0.0f, 1.0f);
+	if (alpha >= 1.0f)
+	{
+		FinishGetUp();
+		return;
+	}
+
+	// Move the capsule a step towards the floor under the ragdoll, carrying the mesh and camera back to their places on it.
+	float blend = FMath::InterpEaseInOut(0.0f, 1.0f, alpha, 2.0f);
+	{
+		FScopedMovementUpdate capsuleUpdate(GetCapsuleComponent(), EScopedUpdate::DeferredUpdates);
+		GetCapsuleComponent()->SetWorldLocation(FMath::Lerp(getUpStartLocation, getUpTargetLocation, blend));
+		FTransform meshTransform;
+		meshTransform.Blend(getUpMeshStart, meshDefaultTransform, blend);
+		GetMesh()->SetRelativeTransform(meshTransform);
+		camBoom->SetRelativeLocation(FMath::Lerp(getUpCamBoomStart, camBoomDefaultLocation, blend));
+	}
+
+	// The anim graph blends the pose from the snapshot on the worker thread.
+	WriteGetUpAlpha(blend);
+}
+
+void AMainPlayer::FinishGetUp()
+{
+	{
+		FScopedMovementUpdate capsuleUpdate(GetCapsuleComponent(), EScopedUpdate::DeferredUpdates);
+		GetCapsuleComponent()->SetWorldLocation(getUpTargetLocation);
+		GetMesh()->SetRelativeTransform(meshDefaultTransform);
+		camBoom->SetRelativeLocation(camBoomDefaultLocation);
+	}
+
+	// Hand back to the character movement.
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	GetCharacterMovement()->SetMovementMode(EMovementMode::MOVE_Walking);
+	WriteGetUpAlpha(1.0f);
+	gettingUp = false;
+	InvalidateGroundCache();
+}
+
+void AMainPlayer::WriteGetUpAlpha(float alpha)
+{
+	ikAnimOutput.getUpAlpha = alpha;
+	PublishIKAnimOutput();
+}
+
+UIKAnimInstance* AMainPlayer::GetIKAnimInstance()
+{
+	// Only cast again when the mesh has a different anim instance.
+	UAnimInstance* animInstance = GetMesh()->GetAnimInstance();
+	if (animInstance != ikAnimInstanceSource.Get())
+	{
+		ikAnimInstanceSource = animInstance;
+		ikAnimInstance = Cast<UIKAnimInstance>(animInstance);
+	}
+	return ikAnimInstance.Get();
+}
+
+void AMainPlayer::PublishIKAnimOutput()
+{
+	if (UIKAnimInstance* IKAnim = GetIKAnimInstance()) IKAnim->PublishIKOutput(ikAnimOutput);
+}
+
+void AMainPlayer::FreezeRagdoll()
+{
+	if (!ragdollEnabled || ragdollFrozen) return;
+
+	// Stop updating the skeleton so turning off simulation keeps the last simulated pose.
+	GetMesh()->PutAllRigidBodiesToSleep();
+	GetMesh()->bNoSkeletonUpdate = true;
+	GetMesh()->SetSimulatePhysics(false);
+	ragdollFrozen = true;
+}
+
+bool AMainPlayer::IsRagdollSettled(float maxSpeed) const
+{
+	if (!GetMesh()->RigidBodyIsAwake()) return true;
+	FBodyInstance* rootBody = GetBoneCache().GetRootBody(GetMesh());
+	return !rootBody || rootBody->GetUnrealWorldVelocity().SizeSquared() <= FMath::Square(maxSpeed);
+}
+
+const FIKBoneCache& AMainPlayer::GetBoneCache() const
+{
+	// Only pointer compares unless the mesh has changed.
+	boneCache.SetRootName(rootName);
+	boneCache.Update(GetMesh());
+	return boneCache;
+}
+
+void AMainPlayer::UpdateRagdollPhysicsLOD()
+{
+	UPhysicsAsset* physicsAsset = GetRagdollPhysicsAsset();
+	if (!physicsAsset || physicsAsset == GetMesh()->GetPhysicsAsset()) return;
+
+	// Before simulating only the asset changes.
+	USkeletalMeshComponent* mesh = GetMesh();
+	if (!mesh->IsSimulatingPhysics())
+	{
+		mesh->SetPhysicsAsset(physicsAsset, true);
+		return;
+	}
+
+	// The new bodies are created at rest from the current pose, so carry over each bones velocities to keep the fall going.
+	TMap<FName, TPair<FVector, FVector>> boneVelocities;
+	for (FBodyInstance* body : mesh->Bodies)
+	{
+		if (body && body->BodySetup.IsValid()) boneVelocities.Add(body->BodySetup->BoneName, TPair<FVector, FVector>(body->GetUnrealWorldVelocity(), body->GetUnrealWorldAngularVelocityInRadians()));
+	}
+
+	mesh->SetPhysicsAsset(physicsAsset, true);
+	mesh->SetSimulatePhysics(true);
+	for (FBodyInstance* body : mesh->Bodies)
+	{
+		if (!body || !body->BodySetup.IsValid()) continue;
+
+		// Bones only in the new asset move with the closest parent that was simulated.
+		FName boneName = body->BodySetup->BoneName;
+		const TPair<FVector, FVector>* velocities = boneVelocities.Find(boneName);
+		while (!velocities && boneName != NAME_None)
+		{
+			boneName = mesh->GetParentBone(boneName);
+			velocities = boneVelocities.Find(boneName);
+		}
+		if (!velocities) continue;
+		body->SetLinearVelocity(velocities->Key, false);
+		body->SetAngularVelocityInRadians(velocities->Value, false);
+	}
 }
 
 void AMainPlayer::ToggleIK(bool bEnable)
@@ -258,74 +677,313 @@ void AMainPlayer::ToggleIK(bool bEnable)
 	isIKEnabled = bEnable;
 }
 
+void AMainPlayer::SetScriptedInput(float forward, float right)
+{
+	if (forward != 0.0f || right != 0.0f) WakeUp();
+	scriptedForward = forward;
+	scriptedRight = right;
+}
+
 void AMainPlayer::UpdateDefaultFeetPosition()
 {
+	IK_PROFILE_SCOPE(UpdateDefaultFeetPosition);
+
 	// Get default positions for the left and right foot without any line traces in the world space.
 	FTransform capTrans = GetCapsuleComponent()->GetComponentTransform();
-	FVector currentLeftFoot = capTrans.TransformPositionNoScale(leftRelativeFoot);
-	FVector currentRightFoot = capTrans.TransformPositionNoScale(rightRelativeFoot);
+	IKCore::Quat capRotation = IKCore::ToIKCore(capTrans.GetRotation());
+	IKCore::Vector3 capLocation = IKCore::ToIKCore(capTrans.GetLocation());
+	FVector currentLeftFoot = IKCore::ToEngine(IKCore::TransformPositionNoScale(capRotation, capLocation, IKCore::ToIKCore(leftRelativeFoot)));
+	FVector currentRightFoot = IKCore::ToEngine(IKCore::TransformPositionNoScale(capRotation, capLocation, IKCore::ToIKCore(rightRelativeFoot)));
 
 	// Update IKAnim.
-	if (UIKAnimInstance* IKAnim = Cast<UIKAnimInstance>(GetMesh()->GetAnimInstance()))
+	ApplyDefaultFeet(currentLeftFoot, currentRightFoot);
+}
+
+void AMainPlayer::ApplyDefaultFeet(const FVector& leftFoot, const FVector& rightFoot)
+{
+	ApplyIKPose(FIKFeetPose(leftFoot, rightFoot, 0.0f));
+}
+
+void AMainPlayer::TickIK(float DeltaTime)
+{
+	switch (PrepareIKUpdate(DeltaTime))
 	{
-		IKAnim->currentHipOffset = 0.0f;
-		IKAnim->currentLeftFootLocation = currentLeftFoot;
-		IKAnim->currentRightFootLocation = currentRightFoot;
+	case EIKUpdateMode::DefaultFeet:
+		UpdateDefaultFeetPosition();
+		break;
+	case EIKUpdateMode::Update:
+		UpdateIK();
+		break;
+	case EIKUpdateMode::Interpolate:
+		InterpolateIK();
+		break;
+	default:
+		break;
 	}
 }
 
+EIKUpdateMode AMainPlayer::PrepareIKUpdate(float DeltaTime)
+{
+	// Simulated proxies use the IK of the machine controlling them.
+	if (UsesReplicatedIK())
+	{
+		TickReplicatedIK(DeltaTime);
+		return EIKUpdateMode::None;
+	}
+
+	// Distant characters keep their default feet positions.
+	ikLODTier = GetIKLODTier();
+	if (ikLODTier == EIKLODTier::Frozen) return EIKUpdateMode::DefaultFeet;
+
+	// Update IK when it is due, the trace budget is checked once the traces are reached.
+	ikTimeSinceUpdate += DeltaTime;
+	bool updateDue = ikLODTier == EIKLODTier::Full || ikTimeSinceUpdate >= ikUpdateRate;
+	return updateDue ? EIKUpdateMode::Update : EIKUpdateMode::Interpolate;
+}
+
+void AMainPlayer::GatherIKTick(FIKTickBatch& batch, int32 index) const
+{
+	UCapsuleComponent* cap = GetCapsuleComponent();
+	const FTransform& capTrans = cap->GetComponentTransform();
+	batch.capsuleRotations[index] = IKCore::ToIKCore(capTrans.GetRotation());
+	batch.capsuleLocations[index] = IKCore::ToIKCore(capTrans.GetLocation());
+	batch.capsuleBottoms[index] = capTrans.GetLocation().Z - cap->GetScaledCapsuleHalfHeight();
+	batch.leftRelativeStarts[index] = IKCore::ToIKCore(leftFootRelativeStart);
+	batch.rightRelativeStarts[index] = IKCore::ToIKCore(rightFootRelativeStart);
+	batch.leftRelativeFeet[index] = IKCore::ToIKCore(leftRelativeFoot);
+	batch.rightRelativeFeet[index] = IKCore::ToIKCore(rightRelativeFoot);
+}
+
+void AMainPlayer::InterpolateIK()
+{
+	// Interpolate towards the last result, or hold it when running at full rate.
+	float alpha = ikLODTier == EIKLODTier::Reduced && ikUpdateRate > 0.0f ? FMath::Clamp(ikTimeSinceUpdate / ikUpdateRate, 0.0f, 1.0f) : 1.0f;
+	FIKFeetPose pose;
+	pose.leftFoot = FMath::Lerp(ikFromPose.leftFoot, ikToPose.leftFoot, alpha);
+	pose.rightFoot = FMath::Lerp(ikFromPose.rightFoot, ikToPose.rightFoot, alpha);
+	pose.hipOffset = FMath::Lerp(ikFromPose.hipOffset, ikToPose.hipOffset, alpha);
+	WriteIKPose(pose);
+	UpdateCapsule(ikToPose.hipOffset);
+}
+
+EIKLODTier AMainPlayer::GetIKLODTier() const
+{
+	// The players own character always runs full IK.
+	if (IsLocallyControlled() && IsPlayerControlled()) return EIKLODTier::Full;
+
+	// The anim budget turns off the IK of the least significant characters.
+	if (animBudgetIKOff) return EIKLODTier::Frozen;
+
+	// Characters that cannot be seen do not need IK.
+	const UIKSettings* settings = UIKSettings::Get();
+	if (settings->freezeIKWhenNotRendered && !WasRecentlyRendered(0.2f)) return EIKLODTier::Frozen;
+
+	// Otherwise use the distance to the closest local players camera.
+	float closestDistanceSquared = GetClosestCameraDistanceSquared();
+	if (closestDistanceSquared >= FMath::Square(settings->frozenIKDistance)) return EIKLODTier::Frozen;
+	if (closestDistanceSquared >= FMath::Square(settings->reducedIKDistance)) return EIKLODTier::Reduced;
+	return EIKLODTier::Full;
+}
+
+float AMainPlayer::GetAnimSignificance() const
+{
+	// The players own character, ragdolls and characters getting up are always animated every frame.
+	if ((IsLocallyControlled() && IsPlayerControlled()) || ragdollEnabled || gettingUp) return 1.0f;
+
+	// Characters that cannot be seen matter least.
+	if (!WasRecentlyRendered(0.2f)) return 0.0f;
+
+	// Otherwise falls off with the distance to the closest local players camera, halving at the reduced IK distance.
+	float reducedIKDistance = FMath::Max(UIKSettings::Get()->reducedIKDistance, 1.0f);
+	return reducedIKDistance / (reducedIKDistance + FMath::Sqrt(GetClosestCameraDistanceSquared()));
+}
+
+void AMainPlayer::SetAnimBudgetIKOff(bool ikOff)
+{
+	if (animBudgetIKOff == ikOff) return;
+
+	// The IK LOD tier picks it up next IK update, the anim instance stops solving the feet straight away.
+	animBudgetIKOff = ikOff;
+	ikAnimOutput.ikEnabled = !ikOff;
+	PublishIKAnimOutput();
+}
+
+void AMainPlayer::OnAnimBudgetReduceWork(USkeletalMeshComponentBudgeted* component, bool reduceWork)
+{
+	SetAnimBudgetIKOff(reduceWork);
+}
+
+float AMainPlayer::GetClosestCameraDistanceSquared() const
+{
+	float closestDistanceSquared = MAX_FLT;
+	for (FConstPlayerControllerIterator it = GetWorld()->GetPlayerControllerIterator(); it; ++it)
+	{
+		APlayerController* playerController = it->Get();
+		if (playerController && playerController->IsLocalController() && playerController->PlayerCameraManager)
+		{
+			closestDistanceSquared = FMath::Min(closestDistanceSquared, FVector::DistSquared(playerController->PlayerCameraManager->GetCameraLocation(), GetActorLocation()));
+		}
+	}
+	return closestDistanceSquared;
+}
+
+UPhysicsAsset* AMainPlayer::GetRagdollPhysicsAsset() const
+{
+	if (!reducedPhysicsAsset || !fullPhysicsAsset) return GetMesh()->GetPhysicsAsset();
+
+	// A reduced ragdoll has to come closer than it went out and a full one has to stay unseen longer, so it does not flip at the thresholds.
+	const UIKSettings* settings = UIKSettings::Get();
+	bool usingReduced = GetMesh()->GetPhysicsAsset() == reducedPhysicsAsset;
+
+	// Unseen ragdolls never need the full asset.
+	if (!WasRecentlyRendered(usingReduced ? 0.2f : 1.0f)) return reducedPhysicsAsset;
+	float distance = FMath::Max(settings->reducedRagdollDistance - (usingReduced ? settings->ragdollLODHysteresis : 0.0f), 0.0f);
+	return GetClosestCameraDistanceSquared() >= FMath::Square(distance) ? reducedPhysicsAsset : fullPhysicsAsset;
+}
+
+void AMainPlayer::ApplyIKPose(const FIKFeetPose& pose, bool interpolate)
+{
+	// Interpolate from whatever the anim instance is currently showing.
+	ikFromPose = interpolate ? ikCurrentPose : pose;
+	ikToPose = pose;
+	WriteIKPose(ikFromPose);
+}
+
+void AMainPlayer::WriteIKPose(const FIKFeetPose& pose)
+{
+	ikCurrentPose = pose;
+	ikAnimOutput.leftFootLocation = pose.leftFoot;
+	ikAnimOutput.rightFootLocation = pose.rightFoot;
+	ikAnimOutput.hipOffset = pose.hipOffset;
+	PublishIKAnimOutput();
+}
+
 void AMainPlayer::UpdateIK()
 {
-	// Obtain the current foot offset in the Z direction for the left foot.
-	FVector leftFloorHit = GetFloorLocation(LEFT);
-	FVector rightFloorHit = GetFloorLocation(RIGHT);
-	if ((leftFloorHit == FVector::ZeroVector || rightFloorHit == FVector::ZeroVector) && !ragdollEnabled)
+	IK_PROFILE_SCOPE(UpdateIK);
+
+	// Obtain the current floor under each foot, holding the last result when over the trace budget.
+	FVector leftFloorHit, rightFloorHit;
+	if (!TraceIKFloors(GetTraceStart(LEFT), GetTraceStart(RIGHT), leftFloorHit, rightFloorHit))
 	{
-		// Toggle ragdoll and reset IK.
-		RagdollToggle();
-		UpdateDefaultFeetPosition();
+		InterpolateIK();
 		return;
 	}
-	
+
 	// Get the IK offset values.
-	FVector currLeftOffset = leftFloorHit;
-	FVector currRightOffset = rightFloorHit;
 	float bottomOfCapsuleZ = GetCapsuleComponent()->GetComponentLocation().Z - GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
-	float currHipOffset = currLeftOffset.Z < currRightOffset.Z ? FMath::Abs((FMath::Abs(currLeftOffset.Z) - FMath::Abs(bottomOfCapsuleZ))) * -1
-															   : FMath::Abs((FMath::Abs(currRightOffset.Z) - FMath::Abs(bottomOfCapsuleZ))) * -1;
+	ApplyIKUpdate(leftFloorHit, rightFloorHit, IKCore::HipOffset(leftFloorHit.Z, rightFloorHit.Z, bottomOfCapsuleZ));
+}
+
+bool AMainPlayer::TraceIKFloors(const FVector& leftStart, const FVector& rightStart, FVector& outLeftFloor, FVector& outRightFloor)
+{
+	if (!FIKTraceBudget::HasBudget()) return false;
+
+	ikTimeSinceUpdate = 0.0f;
+	outLeftFloor = GetFootFloorLocation(LEFT, leftStart);
+	outRightFloor = GetFootFloorLocation(RIGHT, rightStart);
+	return true;
+}
+
+void AMainPlayer::ApplyIKUpdate(const FVector& leftFloorHit, const FVector& rightFloorHit, float currHipOffset)
+{
+	if ((leftFloorHit == FVector::ZeroVector || rightFloorHit == FVector::ZeroVector) && !ragdollEnabled)
+	{
+		// Toggle ragdoll and reset IK, asking the ragdoll budget only once per fall.
+		if (!overBudgetFall) RagdollToggle();
+		UpdateDefaultFeetPosition();
+		return;
+	}
+	overBudgetFall = false;
+
+	// Take the inputs of the update before the capsule changes when recording it.
+	const bool recording = FIKReplayRecorder::IsRecording();
+	IKCore::ReplayFrame replayFrame;
+	if (recording)
+	{
+		UCapsuleComponent* cap = GetCapsuleComponent();
+		replayFrame.frame = (uint32)GFrameCounter;
+		replayFrame.id = GetUniqueID();
+		replayFrame.deltaTime = GetWorld()->GetDeltaSeconds();
+		replayFrame.forwardAxis = InputComponent ? InputComponent->GetAxisValue(FName("MoveForward")) : scriptedForward;
+		replayFrame.rightAxis = InputComponent ? InputComponent->GetAxisValue(FName("MoveRight")) : scriptedRight;
+		replayFrame.capsuleRotation = IKCore::ToIKCore(cap->GetComponentQuat());
+		replayFrame.capsuleLocation = IKCore::ToIKCore(cap->GetComponentLocation());
+		replayFrame.capsuleHalfHeight = cap->GetScaledCapsuleHalfHeight();
+		replayFrame.interpHalfHeight = capsuleAdjustMode == ECapsuleAdjustMode::Interpolate ? cap->GetUnscaledCapsuleHalfHeight() : capsuleInterpHeight;
+		replayFrame.leftFloor = IKCore::ToIKCore(leftFloorHit);
+		replayFrame.rightFloor = IKCore::ToIKCore(rightFloorHit);
+	}
 
 	// Update Capsule.
 	UpdateCapsule(currHipOffset);
 
-	// Create the correct offsets in the anim instance.
-	if (UIKAnimInstance* IKAnim = Cast<UIKAnimInstance>(GetMesh()->GetAnimInstance()))
+	// Create the correct offsets in the anim instance, interpolating to them over the next update when running at a reduced rate.
+	ApplyIKPose(FIKFeetPose(leftFloorHit, rightFloorHit, currHipOffset), ikLODTier == EIKLODTier::Reduced);
+
+	// Record what the update produced to check the replay against.
+	if (recording)
 	{
-		IKAnim->currentHipOffset = currHipOffset;
-		IKAnim->currentLeftFootLocation = currLeftOffset;
-		IKAnim->currentRightFootLocation = currRightOffset;
+		IKCore::ReplayCharacter replayCharacter;
+		replayCharacter.id = replayFrame.id;
+		replayCharacter.originalHalfHeight = capsuleOriginalHeight;
+		replayCharacter.interpSpeed = capsuleInterpSpeed;
+		replayFrame.outLeftFoot = IKCore::ToIKCore(ikToPose.leftFoot);
+		replayFrame.outRightFoot = IKCore::ToIKCore(ikToPose.rightFoot);
+		replayFrame.outHipOffset = ikToPose.hipOffset;
+		replayFrame.outInterpHalfHeight = capsuleInterpHeight;
+		FIKReplayRecorder::RecordFrame(replayCharacter, replayFrame);
 	}
 }
 
 void AMainPlayer::UpdateCapsule(float offset, bool reset)
 {
+	IK_PROFILE_SCOPE(UpdateCapsule);
+
 	// Get new half height.
 	float newHeight = 0.0f;
 	if (reset) newHeight = capsuleOriginalHeight;
-	else newHeight = capsuleOriginalHeight - (FMath::Abs(offset) / 2);
+	else newHeight = IKCore::CapsuleTargetHalfHeight(capsuleOriginalHeight, offset);
 
 	// Interpolate the value as long as this function is being ran.
-	float currentCapsuleHeight = GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
-	float interpingValue = FMath::FInterpTo(currentCapsuleHeight, newHeight, GetWorld()->GetDeltaSeconds(), capsuleInterpSpeed);
-
-	// Setup new capsule height.
 	UCapsuleComponent* cap = GetCapsuleComponent();
-	cap->SetCapsuleHalfHeight(interpingValue, true);
+	float currentCapsuleHeight = cap->GetUnscaledCapsuleHalfHeight();
+	if (capsuleAdjustMode == ECapsuleAdjustMode::Interpolate) capsuleInterpHeight = currentCapsuleHeight;
+	capsuleInterpHeight = IKCore::InterpTo(capsuleInterpHeight, newHeight, GetWorld()->GetDeltaSeconds(), capsuleInterpSpeed);
 
+	if (capsuleAdjustMode == ECapsuleAdjustMode::MeshOffset)
+	{
+		// Keep the capsule and lower the mesh by as much as the capsule would have shrunk.
+		FVector holderLocation = playerHolder->RelativeLocation;
+		float holderZ = playerHolderOriginalZ - (capsuleOriginalHeight - capsuleInterpHeight);
+		if (holderLocation.Z != holderZ)
+		{
+			FScopedMovementUpdate holderUpdate(playerHolder, EScopedUpdate::DeferredUpdates);
+			holderLocation.Z = holderZ;
+			playerHolder->SetRelativeLocation(holderLocation);
+		}
+	}
+	else if (capsuleInterpHeight != currentCapsuleHeight)
+	{
+		// In threshold mode only resize once the height has moved far enough, or to settle on the target.
+		bool resize = capsuleAdjustMode == ECapsuleAdjustMode::Interpolate || capsuleInterpHeight == newHeight
+			|| FMath::Abs(capsuleInterpHeight - currentCapsuleHeight) >= capsuleResizeThreshold;
+
+		// Setup new capsule height, the overlap and attached component updates are applied together at the end of the scope.
+		if (resize)
+		{
+			FScopedMovementUpdate capsuleUpdate(cap, EScopedUpdate::DeferredUpdates);
+			cap->SetCapsuleHalfHeight(capsuleInterpHeight, true);
+		}
+	}
+
+#if IK_DEBUG_DRAW
 	// If debug is enabled draw the capsule.
-	if (debugEnabled)
+	if (FIKDebugDraw* debugDraw = GetDebugDraw())
 	{
-		DrawDebugCapsule(GetWorld(), cap->GetComponentLocation(), cap->GetScaledCapsuleHalfHeight(), cap->GetScaledCapsuleRadius(), FQuat::Identity, FColor::Blue, false, 0.02f, 0.0f, 1.0f);
+		debugDraw->AddCapsule(cap->GetComponentLocation(), cap->GetScaledCapsuleHalfHeight(), cap->GetScaledCapsuleRadius(), FColor::Blue, 0.0f, 1.0f);
 	}
+#endif
 }
 
 void AMainPlayer::JumpAction(bool pressed)
@@ -337,71 +995,293 @@ void AMainPlayer::JumpAction(bool pressed)
 
 void AMainPlayer::Jump()
 {
+	// The forward jump when running is applied by the movement component.
+	WakeUp();
 	Super::Jump();
+}
 
-	// If the character is running jump forward.
-	if (!GetCharacterMovement()->IsFalling() && GetCharacterMovement()->Velocity.Size() > 0.0f)
+FVector AMainPlayer::GetFloorLocation(EGroundTraceType traceType, FHitResult* outHit, bool dynamicOnly)
+{
+	IK_PROFILE_SCOPE(GetFloorLocation);
+
+	// Line trace variable initialization.
+	FHitResult hit;
+	FVector floorLoc = FVector::ZeroVector;
+
+	// Set the start of the trace depending on trace type and the end to be the ground check distance down in the world.
+	FVector startLoc = GetTraceStart(traceType);
+	FVector endLoc = startLoc;
+	endLoc.Z -= groundCheckDistance;
+
+	// Perform a single line trace.
 	{
-		// Create jump direction from where the camera is positioned in relation to the player.
-		FVector directionToJump = GetCapsuleComponent()->GetForwardVector();
-		directionToJump.Normalize();
-		directionToJump.Z = 0.0f;
+		FIKTraceBudgetScope budgetScope;
+		FIKProfileTimers::AddTraces(1);
+		SweepFloorHit(startLoc, endLoc, dynamicOnly, hit);
+	}
+	IK_COUNT_TRACE_RESULT(hit.bBlockingHit);
+	if (hit.bBlockingHit) floorLoc = hit.Location;
+	if (outHit) *outHit = hit;
+
+	// Show debug lines for line trace.
+	DrawFloorTraceDebug(hit.TraceStart, hit.TraceEnd, hit.bBlockingHit, hit.Location);
+
+	// Return the found floor location.
+	return floorLoc;
+}
+
+void AMainPlayer::SweepFloorHit(const FVector& startLoc, const FVector& endLoc, bool dynamicOnly, FHitResult& outHit) const
+{
+	if (dynamicOnly) GetWorld()->SweepSingleByObjectType(outHit, startLoc, endLoc, FQuat::Identity, AIKManager::GetDynamicFloorObjectParams(), FCollisionShape::MakeSphere(footTraceRadius), GetFloorTraceParams());
+	else if (ikManager.IsValid()) ikManager->GetFloorQuery().SweepFloor(startLoc, endLoc, footTraceRadius, GetFloorTraceParams(), outHit);
+	else FIKPhysicsFloorQuery(GetWorld()).SweepFloor(startLoc, endLoc, footTraceRadius, GetFloorTraceParams(), outHit);
+}
 
-		// Apply jump direction through force.
-		GetCharacterMovement()->AddImpulse(directionToJump * 50000.0f);
+/* Returns the higher of two floor locations, where zero is no floor. */
+static FVector GetHigherFloor(const FVector& a, const FVector& b)
+{
+	if (a.IsZero()) return b;
+	if (b.IsZero()) return a;
+	return a.Z >= b.Z ? a : b;
+}
+
+FVector AMainPlayer::GetFootFloorLocation(EGroundTraceType traceType)
+{
+	if (traceType == CAPSULE) return GetFloorLocation(traceType);
+	return GetFootFloorLocation(traceType, GetTraceStart(traceType));
+}
+
+FVector AMainPlayer::GetFootFloorLocation(EGroundTraceType traceType, const FVector& startLoc)
+{
+	FIKFootSweep sweep;
+	if (!PrepareFootFloor(traceType, startLoc, sweep)) return sweep.floorLocation;
+
+	// Otherwise block for a result.
+	{
+		IK_PROFILE_SCOPE(GetFloorLocation);
+		FIKTraceBudgetScope budgetScope;
+		SweepIKFloor(sweep);
 	}
+	return FinishFootFloor(traceType, sweep);
 }
 
-FVector AMainPlayer::GetFloorLocation(EGroundTraceType traceType)
+bool AMainPlayer::PrepareFootFloor(EGroundTraceType traceType, const FVector& startLoc, FIKFootSweep& outSweep)
 {
-	// Camera offset.
-	float startDistance = 5.0f;
+	outSweep = FIKFootSweep();
+	outSweep.traceStart = startLoc;
 
-	// Line trace variable initialization.
-	FHitResult hit;
-	FVector startLoc = FVector::ZeroVector;
-	FVector endLoc = FVector::ZeroVector;
-	FVector floorLoc = FVector::ZeroVector;
-	FCollisionQueryParams traceParams;
-	traceParams.bTraceComplex = true;
+	// Reuse the cached floor while neither the foot or the floor under it have moved.
+	const UIKSettings* settings = UIKSettings::Get();
+	const FFootGroundCache& groundCache = groundCaches[traceType - LEFT];
+	if (settings->groundCacheEnabled && IsGroundCacheValid(groundCache, startLoc))
+	{
+		outSweep.floorLocation = groundCache.floorLocation;
+		return false;
+	}
 
-	// Ignore this actor.
-	traceParams.AddIgnoredActor(this);
+	// Static floors baked into the heightfield need no trace, only dynamic objects are traced for on top of them.
+	outSweep.hasBakedFloor = settings->useFloorHeightfield && ikManager.IsValid() && ikManager->QueryFloorHeightfield(startLoc, groundCheckDistance, footTraceRadius, outSweep.bakedFloor);
+	if (outSweep.hasBakedFloor && !settings->heightfieldDynamicSweeps)
+	{
+		StoreGroundCache(traceType, startLoc, outSweep.bakedFloor, nullptr, true);
+		outSweep.floorLocation = outSweep.bakedFloor;
+		return false;
+	}
+
+	// Queue the trace for this frame when using deferred traces.
+	FVector endLoc = startLoc;
+	endLoc.Z -= groundCheckDistance;
+	if (settings->footTraceMode != EIKFootTraceMode::Blocking)
+	{
+		// Floor queries off the physics scene cannot use its async queue, so are batched instead.
+		bool batched = ikManager.IsValid() && (settings->footTraceMode == EIKFootTraceMode::Batched || !ikManager->GetFloorQuery().IsPhysicsScene());
+		if (batched) ikManager->RequestFootTrace(this, traceType, startLoc, endLoc, footTraceRadius, outSweep.hasBakedFloor);
+		else RequestAsyncFloorLocation(traceType, startLoc, endLoc, outSweep.hasBakedFloor);
+
+		// Use the result from the last one if it is recent enough.
+		const FDeferredFootTrace& lastTrace = deferredFootTraces[traceType - LEFT];
+		if (lastTrace.valid && GetTraceFrameAge(lastTrace.frame) <= (uint32)settings->maxTraceResultAge)
+		{
+			outSweep.floorLocation = GetHigherFloor(outSweep.bakedFloor, lastTrace.floorLocation);
+			StoreGroundCache(traceType, lastTrace.traceStart, outSweep.floorLocation, lastTrace.floorComponent.Get(), outSweep.hasBakedFloor && outSweep.floorLocation == outSweep.bakedFloor);
+			return false;
+		}
+	}
+
+	// Otherwise a sweep is needed.
+	outSweep.needed = true;
+	return true;
+}
+
+void AMainPlayer::SweepIKFloor(FIKFootSweep& sweep) const
+{
+	// Only reads the character and queries the world, so can run on any thread while the game thread waits.
+	FVector endLoc = sweep.traceStart;
+	endLoc.Z -= groundCheckDistance;
+	SweepFloorHit(sweep.traceStart, endLoc, sweep.hasBakedFloor, sweep.hit);
+}
+
+FVector AMainPlayer::FinishFootFloor(EGroundTraceType traceType, const FIKFootSweep& sweep)
+{
+	const FHitResult& hit = sweep.hit;
+	FIKProfileTimers::AddTraces(1);
+	IK_COUNT_TRACE_RESULT(hit.bBlockingHit);
+
+	// Show debug lines for the sweep.
+	DrawFloorTraceDebug(hit.TraceStart, hit.TraceEnd, hit.bBlockingHit, hit.Location);
+
+	FVector floorLoc = GetHigherFloor(sweep.bakedFloor, hit.bBlockingHit ? hit.Location : FVector::ZeroVector);
+	StoreGroundCache(traceType, sweep.traceStart, floorLoc, hit.GetComponent(), sweep.hasBakedFloor && floorLoc == sweep.bakedFloor);
+	return floorLoc;
+}
+
+bool AMainPlayer::PrepareIKFloors(const FVector& leftStart, const FVector& rightStart, FIKFootSweep& outLeftSweep, FIKFootSweep& outRightSweep)
+{
+	bool leftNeeded = PrepareFootFloor(LEFT, leftStart, outLeftSweep);
+	bool rightNeeded = PrepareFootFloor(RIGHT, rightStart, outRightSweep);
+	return leftNeeded || rightNeeded;
+}
+
+void AMainPlayer::FinishIKFloors(const FIKFootSweep& leftSweep, const FIKFootSweep& rightSweep, FVector& outLeftFloor, FVector& outRightFloor)
+{
+	ikTimeSinceUpdate = 0.0f;
+	outLeftFloor = leftSweep.needed ? FinishFootFloor(LEFT, leftSweep) : leftSweep.floorLocation;
+	outRightFloor = rightSweep.needed ? FinishFootFloor(RIGHT, rightSweep) : rightSweep.floorLocation;
+}
+
+void AMainPlayer::ReceiveFootTrace(EGroundTraceType traceType, uint32 requestFrame, const FVector& start, const FVector& end, const FHitResult* hit)
+{
+	// Ignore results older than the one already stored.
+	FDeferredFootTrace& footTrace = deferredFootTraces[traceType - LEFT];
+	if (footTrace.valid && GetTraceFrameAge(requestFrame) > GetTraceFrameAge(footTrace.frame)) return;
+	IK_COUNT_TRACE_RESULT(hit != nullptr);
+
+	// Store the floor location found, zero if nothing was hit.
+	footTrace.floorLocation = hit ? hit->Location : FVector::ZeroVector;
+	footTrace.traceStart = start;
+	footTrace.floorComponent = hit ? hit->GetComponent() : nullptr;
+	footTrace.frame = requestFrame;
+	footTrace.valid = true;
+
+	// Show debug lines for the trace.
+	DrawFloorTraceDebug(start, end, hit != nullptr, hit ? hit->Location : FVector::ZeroVector);
+}
+
+void AMainPlayer::InvalidateGroundCache()
+{
+	groundCaches[0].valid = false;
+	groundCaches[1].valid = false;
+}
+
+bool AMainPlayer::IsGroundCacheValid(const FFootGroundCache& groundCache, const FVector& traceStart) const
+{
+	// The capsule has moved or turned too far.
+	if (!groundCache.valid || FVector::DistSquared(groundCache.traceStart, traceStart) > FMath::Square(UIKSettings::Get()->groundCacheTolerance)) return false;
 
+	// The floor has been destroyed or moved since it was traced.
+	if (groundCache.bakedFloor) return true;
+	UPrimitiveComponent* floorComponent = groundCache.floorComponent.Get();
+	if (!floorComponent) return false;
+	return floorComponent->Mobility != EComponentMobility::Movable || floorComponent->GetComponentTransform().Equals(groundCache.floorTransform, KINDA_SMALL_NUMBER);
+}
+
+void AMainPlayer::StoreGroundCache(EGroundTraceType traceType, const FVector& traceStart, const FVector& floorLocation, UPrimitiveComponent* floorComponent, bool bakedFloor)
+{
+	// Misses are never cached so they are always traced again.
+	FFootGroundCache& groundCache = groundCaches[traceType - LEFT];
+	groundCache.valid = (bakedFloor || floorComponent != nullptr) && floorLocation != FVector::ZeroVector;
+	if (!groundCache.valid) return;
+
+	groundCache.floorLocation = floorLocation;
+	groundCache.traceStart = traceStart;
+	groundCache.bakedFloor = bakedFloor;
+	groundCache.floorComponent = bakedFloor ? nullptr : floorComponent;
+	groundCache.floorTransform = bakedFloor ? FTransform::Identity : floorComponent->GetComponentTransform();
+}
+
+void AMainPlayer::OnCapsuleHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
+{
+	if (OtherComp && OtherComp->Mobility == EComponentMobility::Movable)
+	{
+		InvalidateGroundCache();
+		WakeUp();
+	}
+}
+
+void AMainPlayer::OnCapsuleBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	if (OtherComp && OtherComp->Mobility == EComponentMobility::Movable) WakeUp();
+}
+
+FVector AMainPlayer::GetTraceStart(EGroundTraceType traceType) const
+{
 	// Set the start of the trace depending on trace type.
 	FTransform hipsTransform = GetCapsuleComponent()->GetComponentTransform();
 	switch (traceType)
 	{
-	case CAPSULE:
-		startLoc = GetMesh()->GetBoneLocation(rootName, EBoneSpaces::WorldSpace);
-	break;
 	case LEFT:
-		startLoc = hipsTransform.TransformPositionNoScale(leftFootRelativeStart);
-	break;
+		return hipsTransform.TransformPositionNoScale(leftFootRelativeStart);
 	case RIGHT:
-		startLoc = hipsTransform.TransformPositionNoScale(rightFootRelativeStart);
-	break;
+		return hipsTransform.TransformPositionNoScale(rightFootRelativeStart);
+	default:
+		return GetRootBoneLocation();
 	}
-	
-	// Set the end of the trace to be the ground check distance down in the world.
-	endLoc = startLoc;
-	endLoc.Z -= groundCheckDistance;
+}
 
-	// Perform a single line trace.
-	GetWorld()->SweepSingleByChannel(hit, startLoc, endLoc, FQuat::Identity, ECC_WorldStatic, FCollisionShape::MakeSphere(footTraceRadius), traceParams);
-	if (hit.bBlockingHit) floorLoc = hit.Location;
+FCollisionQueryParams AMainPlayer::GetFloorTraceParams() const
+{
+	// Use the params every foot trace shares, ignoring every IK character the same as the batched traces.
+	if (ikManager.IsValid()) return ikManager->GetFloorTraceParams(complexFloorTraces);
 
-	// Show debug lines for line trace.
-	if (debugEnabled)
+	// Otherwise trace against simple collision unless asked for complex, and ignore this actor.
+	FCollisionQueryParams traceParams(SCENE_QUERY_STAT(IKFootTrace), complexFloorTraces);
+	traceParams.AddIgnoredActor(this);
+	return traceParams;
+}
+
+#if IK_DEBUG_DRAW
+FIKDebugDraw* AMainPlayer::GetDebugDraw() const
+{
+	return ikManager.IsValid() && FIKDebugDraw::IsEnabledFor(debugEnabled) ? &ikManager->GetDebugDraw() : nullptr;
+}
+#endif
+
+void AMainPlayer::DrawFloorTraceDebug(const FVector& start, const FVector& end, bool blockingHit, const FVector& hitLocation) const
+{
+#if IK_DEBUG_DRAW
+	FIKDebugDraw* debugDraw = GetDebugDraw();
+	if (!debugDraw) return;
+
+	if (blockingHit)
 	{
-		if (hit.bBlockingHit)
-		{
-			DrawDebugLine(GetWorld(), hit.TraceStart, hit.TraceEnd, FColor::Green, false, 0.2f, 0.0f, 0.5f);
-			DrawDebugPoint(GetWorld(), hit.Location, 5.0f, FColor::Red, false, 0.2f, 0.0f);
-		}
-		else DrawDebugLine(GetWorld(), hit.TraceStart, hit.TraceEnd, FColor::Red, false, 0.2f, 0.0f, 0.5f);
+		debugDraw->AddLine(start, end, FColor::Green, 0.2f, 0.5f);
+		debugDraw->AddPoint(hitLocation, 5.0f, FColor::Red, 0.2f);
 	}
+	else debugDraw->AddLine(start, end, FColor::Red, 0.2f, 0.5f);
+#endif
+}
 
-	// Return the found floor location.
-	return floorLoc;
-}
\ No newline at end of file
+void AMainPlayer::RequestAsyncFloorLocation(EGroundTraceType traceType, const FVector& start, const FVector& end, bool dynamicOnly)
+{
+	// Pack the request frame and which foot into the user data so the result can be aged when it comes back.
+	uint32 userData = (GetTraceFrame() << 1) | (uint32)(traceType - LEFT);
+	FIKProfileTimers::AddTraces(1);
+	if (dynamicOnly)
+	{
+		GetWorld()->AsyncSweepByObjectType(EAsyncTraceType::Single, start, end, FQuat::Identity, AIKManager::GetDynamicFloorObjectParams(), FCollisionShape::MakeSphere(footTraceRadius),
+			GetFloorTraceParams(), &footTraceDelegate, userData);
+	}
+	else
+	{
+		GetWorld()->AsyncSweepByChannel(EAsyncTraceType::Single, start, end, FQuat::Identity, COLLISION_IKFLOOR, FCollisionShape::MakeSphere(footTraceRadius),
+			GetFloorTraceParams(), FCollisionResponseParams::DefaultResponseParam, &footTraceDelegate, userData);
+	}
+}
+
+void AMainPlayer::OnFootTraceDone(const FTraceHandle& handle, FTraceDatum& data)
+{
+	// Surfaces tagged for complex collision are swept again straight away, as the async queue only runs one sweep per request.
+	FHitResult* hit = data.OutHits.Num() > 0 && data.OutHits[0].bBlockingHit ? &data.OutHits[0] : nullptr;
+	if (hit && data.TraceChannel == COLLISION_IKFLOOR && !FIKPhysicsFloorQuery::RefineComplexFloor(GetWorld(), data.Start, data.End, footTraceRadius, data.CollisionParams.CollisionQueryParam, *hit)) hit = nullptr;
+	ReceiveFootTrace((EGroundTraceType)(LEFT + (data.UserData & 1)), data.UserData >> 1, data.Start, data.End, hit);
+}
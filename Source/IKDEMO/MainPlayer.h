@@ -3,12 +3,21 @@
 #pragma once
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "WorldCollision.h"
+#include "IKDebugDraw.h"
+#include "IKBoneCache.h"
+#include "IKAnimInstance.h"
 #include "MainPlayer.generated.h"
 
 /* Declare classes used. */
 class USpringArmComponent;
 class UCameraComponent;
 class UInputComponent;
+class AIKManager;
+class UAnimMontage;
+class UPhysicsAsset;
+class USkeletalMeshComponentBudgeted;
+struct FIKTickBatch;
 
 /* Enum to change what the GetFloorLocation() function does. */
 UENUM(BlueprintType)
@@ -19,6 +28,130 @@ enum EGroundTraceType
 	RIGHT
 };
 
+/* The IK level of detail a character is running at. */
+UENUM(BlueprintType)
+enum class EIKLODTier : uint8
+{
+	Full,		/* Foot traces and IK every frame. */
+	Reduced,	/* Foot traces and IK every ikUpdateRate seconds, interpolating in between. */
+	Frozen		/* No foot traces, the feet are kept in their default positions. */
+};
+
+/* What a characters IK does this frame, decided before its foot traces. */
+enum class EIKUpdateMode : uint8
+{
+	None,			/* Nothing left to do, such as a simulated proxy already moved to its replicated IK. */
+	DefaultFeet,	/* Keep the feet in their default positions. */
+	Update,			/* Trace the feet and solve the hip offset, if there is trace budget left. */
+	Interpolate		/* Interpolate towards the last update, or hold it when running at full rate. */
+};
+
+/* How the capsule follows the IK hip offset. */
+UENUM(BlueprintType)
+enum class ECapsuleAdjustMode : uint8
+{
+	Interpolate,	/* Resize the capsule towards its target height every IK update. */
+	Threshold,		/* Interpolate the height separately and only resize the capsule once it is capsuleResizeThreshold away from it. */
+	MeshOffset		/* Keep the capsule at its original height and move the playerHolder down by as much as the capsule would have shrunk. */
+};
+
+/* The foot and hip values the IK anim instance is driven by. */
+struct FIKFeetPose
+{
+	FVector leftFoot; /* The world location of the left foot. */
+	FVector rightFoot; /* The world location of the right foot. */
+	float hipOffset; /* The amount to offset the hips. */
+
+	FIKFeetPose() : leftFoot(FVector::ZeroVector), rightFoot(FVector::ZeroVector), hipOffset(0.0f) {}
+	FIKFeetPose(const FVector& inLeftFoot, const FVector& inRightFoot, float inHipOffset) : leftFoot(inLeftFoot), rightFoot(inRightFoot), hipOffset(inHipOffset) {}
+};
+
+/* The result of an async or batched foot trace waiting to be used by the next IK update. */
+struct FDeferredFootTrace
+{
+	FVector floorLocation; /* The floor location found, zero if the trace missed. */
+	FVector traceStart; /* The world location the trace started from. */
+	TWeakObjectPtr<UPrimitiveComponent> floorComponent; /* The component that was hit. */
+	uint32 frame; /* The frame the trace was requested in. */
+	bool valid; /* Has a result been received yet? */
+
+	FDeferredFootTrace() : floorLocation(FVector::ZeroVector), traceStart(FVector::ZeroVector), frame(0), valid(false) {}
+};
+
+/* A floor location sampled under a foot, reused while neither the foot trace start or the floor have moved. */
+struct FFootGroundCache
+{
+	FVector floorLocation; /* The floor location found. */
+	FVector traceStart; /* The world location the trace started from, moves with the capsule. */
+	TWeakObjectPtr<UPrimitiveComponent> floorComponent; /* The component that was hit. */
+	FTransform floorTransform; /* The transform of the hit component when it was hit. */
+	bool bakedFloor; /* Did the floor come from the baked heightfield rather than a component? */
+	bool valid; /* Is there a sample stored? */
+
+	FFootGroundCache() : floorLocation(FVector::ZeroVector), traceStart(FVector::ZeroVector), bakedFloor(false), valid(false) {}
+};
+
+/* A foot floor sweep split into a game thread prepare, a sweep that can run on any thread and a game thread finish. */
+struct FIKFootSweep
+{
+	FVector traceStart; /* The world location the sweep starts from. */
+	FVector floorLocation; /* The floor location found without a sweep, zero if there is none. */
+	FVector bakedFloor; /* The floor location from the baked heightfield, zero if there is none. */
+	FHitResult hit; /* The sweep hit. */
+	bool hasBakedFloor; /* Is there a baked floor, so only dynamic objects are swept for? */
+	bool needed; /* Does the foot need the sweep? */
+
+	FIKFootSweep() : traceStart(FVector::ZeroVector), floorLocation(FVector::ZeroVector), bakedFloor(FVector::ZeroVector), hasBakedFloor(false), needed(false) {}
+};
+
+/* The IK offsets simulated proxies need, quantised to a byte each. Sent by the owning client and replicated to everyone else.
+ * NOTE: Foot offsets are the foot heights above the bottom of the capsule, the foot X and Y come from the default feet positions. */
+USTRUCT()
+struct FIKNetState
+{
+	GENERATED_BODY()
+
+	int8 leftFoot; /* Quantised left foot offset. */
+	int8 rightFoot; /* Quantised right foot offset. */
+	int8 hipOffset; /* Quantised hip offset. */
+
+	/* The size of a quantisation step in cm, giving a range of +-63.5cm. */
+	static constexpr float Step = 0.5f;
+
+	/* The number of bytes the state is serialized to. */
+	static constexpr int32 NumBytes = 3;
+
+	FIKNetState() : leftFoot(0), rightFoot(0), hipOffset(0) {}
+	FIKNetState(float inLeftFoot, float inRightFoot, float inHipOffset) : leftFoot(Quantise(inLeftFoot)), rightFoot(Quantise(inRightFoot)), hipOffset(Quantise(inHipOffset)) {}
+
+	/* Returns the offset quantised to the nearest step, clamped to the range of a byte. */
+	static int8 Quantise(float value) { return (int8)FMath::Clamp(FMath::RoundToInt(value / Step), -127, 127); }
+
+	/* Returns the offsets as a vector of the left foot, right foot and hip offset. */
+	FVector GetOffsets() const { return FVector(leftFoot, rightFoot, hipOffset) * Step; }
+
+	bool operator==(const FIKNetState& other) const { return leftFoot == other.leftFoot && rightFoot == other.rightFoot && hipOffset == other.hipOffset; }
+	bool operator!=(const FIKNetState& other) const { return !(*this == other); }
+
+	/* Writes the state as three bytes. */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+	{
+		Ar << leftFoot << rightFoot << hipOffset;
+		bOutSuccess = true;
+		return true;
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FIKNetState> : public TStructOpsTypeTraitsBase2<FIKNetState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
+
 /* The IK player to demo IK tech for use in a game within Unreal Engine. */
 UCLASS()
 class IKDEMO_API AMainPlayer : public ACharacter
@@ -55,10 +188,6 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Camera")
 	float mouseSpeed;
 
-	/* Last inputted direction for the character movement. */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
-	FVector lastDirectionMovement;
-
 	/* The distance to check for the ground from the hips. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement|IK")
 	float groundCheckDistance;
@@ -67,18 +196,34 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement|IK")
 	float footTraceRadius;
 
+	/* Should the foot traces sweep complex collision on every surface? Otherwise simple collision is swept, and complex only on surfaces tagged IKComplexFloor. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement|IK")
+	bool complexFloorTraces;
+
 	/* Offset to check from the hips for either leg. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement|IK")
 	float hipOffset;
 
-	/* Offset to check from the hips for either leg. */
+	/* The time between IK updates while in the reduced IK LOD tier. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement|IK")
 	float ikUpdateRate;
 
+	/* The IK LOD tier the character is currently running at. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement|IK")
+	EIKLODTier ikLODTier;
+
 	/* Speed to interp capsule IK offset in height. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement|IK")
 	float capsuleInterpSpeed;
 
+	/* How the capsule follows the IK hip offset. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement|IK")
+	ECapsuleAdjustMode capsuleAdjustMode;
+
+	/* How far the interpolated capsule height has to move from the capsules height before it is resized, in the threshold adjust mode. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement|IK", meta = (ClampMin = "0"))
+	float capsuleResizeThreshold;
+
 	/* The left relative offset to trace from for the feet relative to the hips. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement|IK")
 	FVector leftFootRelativeStart;
@@ -91,11 +236,39 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
 	bool ragdollEnabled;
 
+	/* Has the ragdoll settled and been frozen in its pose? */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+	bool ragdollFrozen;
+
+	/* Was the ragdoll refused by the worlds ragdoll budget, so the character is falling without one until both feet find the floor again? */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+	bool overBudgetFall;
+
+	/* Simulated instead of the meshes physics asset by distant ragdolls, with fewer bodies and simpler constraints. None always uses the full asset. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	UPhysicsAsset* reducedPhysicsAsset;
+
+	/* Played instead of the ragdoll when the worlds ragdoll budget is used up. None drops the capsule with the character movement instead. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	UAnimMontage* fallMontage;
+
+	/* Played when getting up from ragdoll, blended to from the ragdoll pose by the IK get-up blend anim node. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	UAnimMontage* getUpMontage;
+
+	/* The time in seconds to blend from the ragdoll pose and move the capsule back under the mesh when getting up. 0 snaps straight back. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement", meta = (ClampMin = "0"))
+	float getUpBlendTime;
+
+	/* Is the character getting up from ragdoll? */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+	bool gettingUp;
+
 	/* Rotation acceleration. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
 	float jumpRotationSpeed;
 
-	/* Debug properties within the class to the log? */
+	/* Draw this characters IK traces and capsule while the ik.DebugDraw console variable is 1? */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
 	bool debugEnabled;
 
@@ -103,32 +276,129 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Movement")
 	bool movementReleased;
 
+	/* The IK offsets of this character from its owning client, or the server for characters it controls. Not sent back to the owner. */
+	UPROPERTY(ReplicatedUsing = OnRep_IKNetState)
+	FIKNetState ikNetState;
+
+	/* Is the character idle with its actor and movement ticks turned off until something wakes it? */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+	bool sleeping;
+
 private:
 
-	float lastDirectionScale; /* The last direction along the movement axis from player input. */
 	float defaultFloorDistance; /* The expected distance from the hips world Z to the ground on a flat surface. */
 	float capsuleOriginalHeight; /* The original capsule half height. */
+	float capsuleInterpHeight; /* The interpolated capsule half height, applied to the capsule or playerHolder depending on capsuleAdjustMode. */
+	float playerHolderOriginalZ; /* The original relative height of the playerHolder. */
+
+	UPROPERTY()
+	UPhysicsAsset* fullPhysicsAsset; /* The meshes original physics asset. */
+
+	UPROPERTY()
+	USceneComponent* meshDefaultParent; /* The component the mesh is attached to outside of ragdoll. */
+
+	FTransform meshDefaultTransform; /* The meshes relative transform outside of ragdoll. */
+	FVector camBoomDefaultLocation; /* The camera booms relative location outside of ragdoll. */
+	float getUpTime; /* The time since getting up started. */
+	FVector getUpStartLocation, getUpTargetLocation; /* The capsule world locations moved between while getting up. */
+	FTransform getUpMeshStart; /* The meshes relative transform when getting up started. */
+	FVector getUpCamBoomStart; /* The camera booms relative location when getting up started. */
 	FVector originalOffset; /* Camera offset when rag dolling to avoid snapping movement of the camera... */
-	FTimerHandle ikTimer; /* The timer handle for the UpdateIK function to stop the timer at runtime. */
+	float ikTimeSinceUpdate; /* The time since IK was last updated, used by the reduced IK LOD tier. */
+	bool animBudgetIKOff; /* Has the anim budget turned off the IK of this character? */
+	FIKFeetPose ikFromPose, ikToPose; /* The poses interpolated between while in the reduced IK LOD tier. */
+	FIKFeetPose ikCurrentPose; /* The pose last given to the IK anim instance. */
 	bool isIKEnabled; /* Is IK currently active? */
 	FVector leftRelativeFoot, rightRelativeFoot; /* The default relative foot offset in the world to use while IK is not being updated... */
+	FTraceDelegate footTraceDelegate; /* Delegate bound to receive async foot trace results. */
+	FDeferredFootTrace deferredFootTraces[2]; /* The latest async or batched foot trace results for the left and right foot. */
+	TWeakObjectPtr<AIKManager> ikManager; /* The IK manager of the world this character is registered with. */
+	FFootGroundCache groundCaches[2]; /* The cached floor under the left and right foot. */
+	float scriptedForward, scriptedRight; /* Movement input used when the character has no player input component. */
+	float idleTime; /* How long the character has been idle with its IK settled for. */
+	bool ikNetStateValid; /* Has an IK net state been received from the owning client or server? */
+	float ikNetSendTime; /* The time since the IK net state was last sent to the server. */
+	FVector ikNetOffsets; /* The replicated IK offsets smoothed towards the latest net state, as left foot, right foot and hip offset. */
+	FIKAnimOutput ikAnimOutput; /* The IK values last published to the IK anim instance. */
+	TWeakObjectPtr<UIKAnimInstance> ikAnimInstance; /* The meshes anim instance as an IK anim instance, null if it is not one. */
+	TWeakObjectPtr<UAnimInstance> ikAnimInstanceSource; /* The anim instance ikAnimInstance was cast from. */
+	mutable FIKBoneCache boneCache; /* The root bone and root body indices, re-resolved by GetBoneCache when the mesh changes. */
+	FIKFeetPose sleepCheckPose; /* The IK pose last frame, compared against to tell when the IK has settled. */
+	float sleepCheckCapsuleHeight; /* The interpolated capsule height last frame, compared against to tell when the capsule has settled. */
 
 public:
 
-	/* Constructor. */
-	AMainPlayer();
+	/* Constructor, uses the UIKCharacterMovementComponent. */
+	AMainPlayer(const FObjectInitializer& ObjectInitializer);
 
 	/* Frame. */
 	virtual void Tick(float DeltaTime) override;
 
-	/* Gets the floor location and returns it in the world-axis. */
-	FVector GetFloorLocation(EGroundTraceType type = CAPSULE);
+	/* Gets the floor location and returns it in the world-axis. The trace hit is also returned if outHit is given.
+	 * NOTE: A dynamic only trace skips static geometry, for when the static floor comes from the floor heightfield. */
+	FVector GetFloorLocation(EGroundTraceType type = CAPSULE, FHitResult* outHit = nullptr, bool dynamicOnly = false);
+
+	/* Gets the floor location under the given foot, using last frames trace result when async or batched foot traces are enabled. */
+	FVector GetFootFloorLocation(EGroundTraceType type);
+
+	/* Gets the floor location under the given foot from a trace start already worked out, such as by the parallel IK tick. */
+	FVector GetFootFloorLocation(EGroundTraceType type, const FVector& startLoc);
+
+	/* Stores an async or batched foot trace result to be used by the next IK update. The hit is null if nothing was hit. */
+	void ReceiveFootTrace(EGroundTraceType type, uint32 requestFrame, const FVector& start, const FVector& end, const FHitResult* hit);
+
+	/* Returns true if the foot traces sweep complex collision on every surface. */
+	bool UsesComplexFloorTraces() const { return complexFloorTraces; }
+
+	/* Returns the frame number deferred foot traces are tagged with, wrapped to 31 bits so it can be packed with the foot into trace user data. */
+	static uint32 GetTraceFrame() { return (uint32)GFrameCounter & 0x7FFFFFFF; }
+
+	/* Returns how many frames ago the given trace frame was. */
+	static uint32 GetTraceFrameAge(uint32 frame) { return (GetTraceFrame() - frame) & 0x7FFFFFFF; }
 
 	/* Toggles the ragdoll on and off.
 	 * NOTE: When ragdoll is toggled off, the character is reset and repositioned as it is static... */
 	UFUNCTION(BlueprintCallable)
 	void RagdollToggle();
 
+	/* Holds the ragdoll in its current pose and stops simulating it, keeping its bodies as kinematic collision. */
+	void FreezeRagdoll();
+
+	/* Returns true if the ragdolls root body is asleep or moving slower than the given speed. */
+	bool IsRagdollSettled(float maxSpeed) const;
+
+	/* Swaps the mesh between its full and reduced physics asset for the characters distance from the camera.
+	 * NOTE: A simulating ragdoll keeps each bones velocities across the swap. */
+	void UpdateRagdollPhysicsLOD();
+
+	/* Returns the world location of the root bone. */
+	FVector GetRootBoneLocation() const { return GetBoneCache().GetRootLocation(GetMesh()); }
+
+	/* Returns how much the character matters to the anim budget, from 1 for the players own character down to 0 when not rendered. */
+	float GetAnimSignificance() const;
+
+	/* Turns the IK off or back on for the anim budget. While off the feet keep their default positions and the foot placement is not solved. */
+	void SetAnimBudgetIKOff(bool ikOff);
+
+	/* Has the anim budget turned off the IK of this character? */
+	bool IsAnimBudgetIKOff() const { return animBudgetIKOff; }
+
+	/* Turns the actor and movement ticks back on if the character is sleeping and restarts its idle time. */
+	UFUNCTION(BlueprintCallable, Category = "Movement")
+	void WakeUp();
+
+	/* Wakes a sleeping character if it has moved to a different IK LOD tier since it went to sleep. Called by the IK manager. */
+	void CheckSleepingLOD();
+
+	/* Sets the movement input of a character without player input, such as the IK benchmark characters. */
+	UFUNCTION(BlueprintCallable, Category = "Movement")
+	void SetScriptedInput(float forward, float right);
+
+	/* Clears the cached floor under both feet so they are traced again next IK update.
+	 * NOTE: Moving floors are detected automatically, this is only needed for geometry that appears under a foot. */
+	UFUNCTION(BlueprintCallable, Category = "IK")
+	void InvalidateGroundCache();
+
 	/* Toggles the IK on or off depending on given bEnable value. */
 	UFUNCTION(BlueprintCallable)
 	void ToggleIK(bool bEnable);
@@ -141,6 +411,37 @@ public:
 	UFUNCTION(Category = "IK")
 	void UpdateIK();
 
+	/* Decides what the IK does this frame from the IK LOD tier and update rate. Simulated proxies are moved to their replicated IK here and return None. */
+	EIKUpdateMode PrepareIKUpdate(float DeltaTime);
+
+	/* Fills in the capsule transform and relative foot offsets of this character at the given index of the parallel IK tick. */
+	void GatherIKTick(FIKTickBatch& batch, int32 index) const;
+
+	/* Finds the floor under both feet from the given trace starts. Returns false without tracing if the trace budget is used up. */
+	bool TraceIKFloors(const FVector& leftStart, const FVector& rightStart, FVector& outLeftFloor, FVector& outRightFloor);
+
+	/* Finds what it can of the floor under both feet without sweeping, such as from the ground cache. Returns whether either foot still needs its sweep. */
+	bool PrepareIKFloors(const FVector& leftStart, const FVector& rightStart, FIKFootSweep& outLeftSweep, FIKFootSweep& outRightSweep);
+
+	/* Sweeps for the floor under a foot prepared by PrepareIKFloors.
+	 * NOTE: Does no stat, budget or cache accounting so it can run off the game thread, that is left to FinishIKFloors. */
+	void SweepIKFloor(FIKFootSweep& sweep) const;
+
+	/* Gets the floor under both feet once their sweeps have run, storing them in the ground cache. */
+	void FinishIKFloors(const FIKFootSweep& leftSweep, const FIKFootSweep& rightSweep, FVector& outLeftFloor, FVector& outRightFloor);
+
+	/* Shares the IK with the other machines in a networked game. */
+	void ShareIKNetState(float DeltaTime);
+
+	/* Applies an IK update from the floor under each foot and the hip offset solved from them, toggling ragdoll if either foot has no floor. */
+	void ApplyIKUpdate(const FVector& leftFloorHit, const FVector& rightFloorHit, float currHipOffset);
+
+	/* Interpolates towards the last IK update, or holds it when running at full rate. */
+	void InterpolateIK();
+
+	/* Gives the feet default positions already worked out, such as by the parallel IK tick. */
+	void ApplyDefaultFeet(const FVector& leftFoot, const FVector& rightFoot);
+
 	/* Updates the capsule size depending on IK offset value and can also reset the capsule back to normal. */
 	UFUNCTION(BlueprintCallable, Category = "IK")
 	void UpdateCapsule(float offset = 0.0f, bool reset = false);
@@ -150,6 +451,21 @@ protected:
 	/* Level start. */
 	virtual void BeginPlay() override;
 
+	/* Wakes the character when movement input is added from anywhere, including AI controllers. */
+	virtual void AddMovementInput(FVector WorldDirection, float ScaleValue = 1.0f, bool bForce = false) override;
+
+	/* Adds the replicated IK net state. */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/* Wakes the character when its movement mode changes. */
+	virtual void OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode = 0) override;
+
+	/* Wakes the character when it lands. */
+	virtual void Landed(const FHitResult& Hit) override;
+
+	/* Level end or destroyed. */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	/* Input constructor. */
 	virtual void SetupPlayerInputComponent(UInputComponent* PlayerInputComponent) override;
 
@@ -174,6 +490,125 @@ protected:
 	UFUNCTION(Category = "Movement")
 	void JumpAction(bool pressed);
 
-	/* Jump function. */
+	/* Jump function, wakes the character before jumping. */
 	void Jump() override;
+
+private:
+
+	/* Runs IK for this frame depending on the IK LOD tier, when it is not run by the parallel IK tick. */
+	void TickIK(float DeltaTime);
+
+	/* Returns the IK LOD tier the character should be in from its distance to the camera. */
+	EIKLODTier GetIKLODTier() const;
+
+	/* Starts moving the capsule, mesh and camera back into place from the ragdoll over getUpBlendTime. */
+	void StartGetUp(const FVector& capsuleLocation);
+
+	/* Moves the capsule, mesh and camera a step further through the get-up. */
+	void TickGetUp(float DeltaTime);
+
+	/* Puts the capsule, mesh and camera in their final places and gives control back to the character movement. */
+	void FinishGetUp();
+
+	/* Gives the get-up blend alpha to the IK anim instance. */
+	void WriteGetUpAlpha(float alpha);
+
+	/* Returns the meshes anim instance as an IK anim instance, only casting again when the anim instance changes. */
+	UIKAnimInstance* GetIKAnimInstance();
+
+	/* Publishes the IK values to the IK anim instance for its next update. */
+	void PublishIKAnimOutput();
+
+	/* Returns the squared distance to the closest local players camera, or MAX_FLT if there is none. */
+	float GetClosestCameraDistanceSquared() const;
+
+	/* Returns the physics asset the ragdoll should simulate at its distance from the camera. */
+	UPhysicsAsset* GetRagdollPhysicsAsset() const;
+
+	/* Sets the pose to drive the IK anim instance with, either straight away or interpolated over the next ikUpdateRate seconds. */
+	void ApplyIKPose(const FIKFeetPose& pose, bool interpolate = false);
+
+	/* Gives the pose to the IK anim instance. */
+	void WriteIKPose(const FIKFeetPose& pose);
+
+	/* Called by the animation budget allocator to turn the IK off while the mesh has to reduce its work, and back on after. */
+	void OnAnimBudgetReduceWork(USkeletalMeshComponentBudgeted* component, bool reduceWork);
+
+	/* Sweeps the foot trace sphere from the start to the end for the floor. See GetFloorLocation. */
+	void SweepFloorHit(const FVector& startLoc, const FVector& endLoc, bool dynamicOnly, FHitResult& outHit) const;
+
+	/* Prepares the floor sweep under a foot, returning false with the floor location set when none is needed. */
+	bool PrepareFootFloor(EGroundTraceType type, const FVector& startLoc, FIKFootSweep& outSweep);
+
+	/* Gets the floor location under a foot from its finished sweep and stores it in the ground cache. */
+	FVector FinishFootFloor(EGroundTraceType type, const FIKFootSweep& sweep);
+
+	/* Returns the world location to start a floor trace from for the given trace type. */
+	FVector GetTraceStart(EGroundTraceType type) const;
+
+	/* Returns the query params used for all floor traces. */
+	FCollisionQueryParams GetFloorTraceParams() const;
+
+#if IK_DEBUG_DRAW
+	/* Returns the debug drawing to record into, null if this character should not draw. */
+	FIKDebugDraw* GetDebugDraw() const;
+#endif
+
+	/* Records the debug lines for a floor trace. */
+	void DrawFloorTraceDebug(const FVector& start, const FVector& end, bool blockingHit, const FVector& hitLocation) const;
+
+	/* Returns true if the cached floor can be used for a trace starting from the given location. */
+	bool IsGroundCacheValid(const FFootGroundCache& groundCache, const FVector& traceStart) const;
+
+	/* Stores a foot trace hit in the ground cache of the given foot. A null component is only cached for a baked floor. */
+	void StoreGroundCache(EGroundTraceType type, const FVector& traceStart, const FVector& floorLocation, UPrimitiveComponent* floorComponent, bool bakedFloor = false);
+
+	/* Called when the capsule is hit, invalidates the ground cache when hit by something that moves. */
+	UFUNCTION()
+	void OnCapsuleHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
+
+	/* Called when the capsule starts overlapping something, wakes the character when it is something that moves. */
+	UFUNCTION()
+	void OnCapsuleBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	/* Sends the IK offsets from the owning client to the server, which replicates them on to everyone else. */
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerSetIKNetState(FIKNetState state);
+
+	/* Called when the IK net state is received. */
+	UFUNCTION()
+	void OnRep_IKNetState();
+
+	/* Returns the bone cache, resolving it again first if the mesh, anim instance or physics asset has changed. */
+	const FIKBoneCache& GetBoneCache() const;
+
+	/* Returns true if this is a simulated proxy driven by the replicated IK net state instead of its own traces. */
+	bool UsesReplicatedIK() const;
+
+	/* Returns true if this is a dedicated server skipping the IK traces. */
+	bool SkipsIKTraces() const;
+
+	/* Moves the feet and hips towards the replicated IK net state and sizes the capsule from it. */
+	void TickReplicatedIK(float DeltaTime);
+
+	/* Sends the current IK pose to the server when it has changed, or sets the replicated state directly when this is the server. */
+	void SendIKNetState(float DeltaTime);
+
+	/* Returns the IK pose quantised relative to the capsule. */
+	FIKNetState EncodeIKNetState(const FIKFeetPose& pose) const;
+
+	/* Returns the IK pose for the given offsets relative to the capsule and default feet positions. */
+	FIKFeetPose DecodeIKNetState(const FVector& offsets) const;
+
+	/* Returns true if the character has no input, is stood still on a floor that does not move and is not ragdolling or getting up. */
+	bool IsIdle(bool isMoving) const;
+
+	/* Counts up the idle time while idle with the IK settled, and puts the character to sleep once it reaches the settings sleep delay. */
+	void UpdateSleep(float DeltaTime, bool isMoving);
+
+	/* Queues an async floor trace for the given foot so the result can be used next frame. */
+	void RequestAsyncFloorLocation(EGroundTraceType type, const FVector& start, const FVector& end, bool dynamicOnly = false);
+
+	/* Called when an async foot trace has completed. */
+	void OnFootTraceDone(const FTraceHandle& handle, FTraceDatum& data);
 };
@@ -9,5 +9,6 @@ public class IKDEMOEditorTarget : TargetRules
 	{
 		Type = TargetType.Editor;
 		ExtraModuleNames.Add("IKDEMO");
+		ExtraModuleNames.Add("IKDEMOEditor");
 	}
 }
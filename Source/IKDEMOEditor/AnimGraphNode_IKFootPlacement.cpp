@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AnimGraphNode_IKFootPlacement.h"
+
+#define LOCTEXT_NAMESPACE "IKDEMOEditor"
+
+FText UAnimGraphNode_IKFootPlacement::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	return GetControllerDescription();
+}
+
+FText UAnimGraphNode_IKFootPlacement::GetTooltipText() const
+{
+	return LOCTEXT("IKFootPlacementTooltip", "Offsets the pelvis and places both feet on the floor locations from the IK anim instance. Runs on the animation worker thread.");
+}
+
+FText UAnimGraphNode_IKFootPlacement::GetControllerDescription() const
+{
+	return LOCTEXT("IKFootPlacement", "IK Foot Placement");
+}
+
+#undef LOCTEXT_NAMESPACE
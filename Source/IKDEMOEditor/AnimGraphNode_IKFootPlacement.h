@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "AnimGraphNode_SkeletalControlBase.h"
+#include "AnimNode_IKFootPlacement.h"
+#include "AnimGraphNode_IKFootPlacement.generated.h"
+
+/* Anim graph node for the native IK foot placement. */
+UCLASS()
+class UAnimGraphNode_IKFootPlacement : public UAnimGraphNode_SkeletalControlBase
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "Settings")
+	FAnimNode_IKFootPlacement Node;
+
+public:
+
+	/* UEdGraphNode interface. */
+	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+	virtual FText GetTooltipText() const override;
+
+protected:
+
+	/* UAnimGraphNode_SkeletalControlBase interface. */
+	virtual FText GetControllerDescription() const override;
+	virtual const FAnimNode_SkeletalControlBase* GetNode() const override { return &Node; }
+};
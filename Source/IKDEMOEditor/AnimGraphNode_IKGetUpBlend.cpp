@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AnimGraphNode_IKGetUpBlend.h"
+
+#define LOCTEXT_NAMESPACE "IKDEMOEditor"
+
+FText UAnimGraphNode_IKGetUpBlend::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	return LOCTEXT("IKGetUpBlend", "IK Get-Up Blend");
+}
+
+FText UAnimGraphNode_IKGetUpBlend::GetTooltipText() const
+{
+	return LOCTEXT("IKGetUpBlendTooltip", "Blends from the ragdoll pose snapshot to the source pose while the character gets up. Runs on the animation worker thread.");
+}
+
+FString UAnimGraphNode_IKGetUpBlend::GetNodeCategory() const
+{
+	return TEXT("IK");
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "AnimGraphNode_Base.h"
+#include "AnimNode_IKGetUpBlend.h"
+#include "AnimGraphNode_IKGetUpBlend.generated.h"
+
+/* Anim graph node for the native get-up blend from the ragdoll pose snapshot. */
+UCLASS()
+class UAnimGraphNode_IKGetUpBlend : public UAnimGraphNode_Base
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "Settings")
+	FAnimNode_IKGetUpBlend Node;
+
+public:
+
+	/* UEdGraphNode interface. */
+	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+	virtual FText GetTooltipText() const override;
+
+	/* UAnimGraphNode_Base interface. */
+	virtual FString GetNodeCategory() const override;
+};
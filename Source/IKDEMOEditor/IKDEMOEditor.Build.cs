@@ -0,0 +1,15 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class IKDEMOEditor : ModuleRules
+{
+	public IKDEMOEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "IKDEMO" });
+		PrivateIncludePaths.Add(System.IO.Path.Combine(ModuleDirectory, "../IKDEMO"));
+		PrivateDependencyModuleNames.AddRange(new string[] { "AnimGraph", "AnimGraphRuntime", "BlueprintGraph", "IKCore", "UnrealEd" });
+	}
+}
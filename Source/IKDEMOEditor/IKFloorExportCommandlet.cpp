@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKFloorExportCommandlet.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Interfaces/Interface_CollisionDataProvider.h"
+#include "Misc/FileHelper.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "IKCoreConversions.h"
+#include "IKFloorProxyComponent.h"
+#include "IKFloorQuery.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogIKFloorExport, Log, All);
+
+/* Returns true if the component is static geometry the foot traces would hit. */
+static bool IsStaticFloor(const UPrimitiveComponent* component)
+{
+	return component && component->Mobility == EComponentMobility::Static && component->IsCollisionEnabled() && component->GetCollisionResponseToChannel(COLLISION_IKFLOOR) == ECR_Block
+		&& !UIKFloorProxyComponent::IsReplacedByProxy(component);
+}
+
+/* Adds every instance of a set of local space triangles to the soup. */
+static void AddTriangles(const TArray<FVector>& vertices, const TArray<int32>& indices, const TArray<FTransform>& transforms, IKCore::TriangleSoup& soup)
+{
+	for (const FTransform& transform : transforms)
+	{
+		const uint32 firstVertex = (uint32)soup.vertices.size();
+		for (const FVector& vertex : vertices) soup.vertices.push_back(IKCore::ToIKCore(transform.TransformPosition(vertex)));
+		for (int32 index : indices) soup.indices.push_back(firstVertex + index);
+	}
+}
+
+/* Adds the complex collision a trace against the component hits. Returns false if it has none. */
+static bool AddComplexCollision(UPrimitiveComponent* component, const TArray<FTransform>& transforms, IKCore::TriangleSoup& soup)
+{
+	// Static meshes keep their collision data on the mesh, others such as BSP provide it themselves.
+	UStaticMeshComponent* meshComponent = Cast<UStaticMeshComponent>(component);
+	IInterface_CollisionDataProvider* provider = meshComponent ? Cast<IInterface_CollisionDataProvider>(meshComponent->GetStaticMesh()) : Cast<IInterface_CollisionDataProvider>(component);
+	FTriMeshCollisionData collisionData;
+	if (!provider || !provider->ContainsPhysicsTriMeshData(true) || !provider->GetPhysicsTriMeshData(&collisionData, true)) return false;
+
+	TArray<int32> indices;
+	indices.Reserve(collisionData.Indices.Num() * 3);
+	for (const FTriIndices& triangle : collisionData.Indices)
+	{
+		indices.Add(triangle.v0);
+		indices.Add(triangle.v1);
+		indices.Add(triangle.v2);
+	}
+	AddTriangles(collisionData.Vertices, indices, transforms, soup);
+	return true;
+}
+
+/* Adds the boxes and convex hulls of the simple collision. Returns false if it has none of them. */
+static bool AddSimpleCollision(const UBodySetup* bodySetup, const TArray<FTransform>& transforms, IKCore::TriangleSoup& soup)
+{
+	bool added = false;
+	for (const FKBoxElem& box : bodySetup->AggGeom.BoxElems)
+	{
+		// Two triangles for each face of the box.
+		const FVector extent(box.X * 0.5f, box.Y * 0.5f, box.Z * 0.5f);
+		TArray<FVector> corners;
+		for (int32 corner = 0; corner < 8; corner++)
+		{
+			corners.Add(box.GetTransform().TransformPosition(FVector(corner & 1 ? extent.X : -extent.X, corner & 2 ? extent.Y : -extent.Y, corner & 4 ? extent.Z : -extent.Z)));
+		}
+		static const TArray<int32> boxIndices = { 0, 2, 3, 0, 3, 1, 4, 5, 7, 4, 7, 6, 0, 1, 5, 0, 5, 4, 2, 6, 7, 2, 7, 3, 0, 4, 6, 0, 6, 2, 1, 3, 7, 1, 7, 5 };
+		AddTriangles(corners, boxIndices, transforms, soup);
+		added = true;
+	}
+	for (const FKConvexElem& convex : bodySetup->AggGeom.ConvexElems)
+	{
+		if (convex.IndexData.Num() < 3) continue;
+		TArray<FVector> vertices;
+		for (const FVector& vertex : convex.VertexData) vertices.Add(convex.GetTransform().TransformPosition(vertex));
+		AddTriangles(vertices, convex.IndexData, transforms, soup);
+		added = true;
+	}
+	return added;
+}
+
+UIKFloorExportCommandlet::UIKFloorExportCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UIKFloorExportCommandlet::Main(const FString& Params)
+{
+	TArray<FString> tokens, switches;
+	TMap<FString, FString> params;
+	ParseCommandLine(*Params, tokens, switches, params);
+
+	FString mapName = params.FindRef(TEXT("Map"));
+	if (mapName.IsEmpty())
+	{
+		UE_LOG(LogIKFloorExport, Error, TEXT("Usage: -run=IKFloorExport -Map=/Game/Maps/MapName"));
+		return 1;
+	}
+
+	// Load the map with its components registered, no physics scene is needed to read collision data.
+	UPackage* package = LoadPackage(nullptr, *mapName, LOAD_None);
+	UWorld* world = package ? UWorld::FindWorldInPackage(package) : nullptr;
+	if (!world)
+	{
+		UE_LOG(LogIKFloorExport, Error, TEXT("Could not load map %s"), *mapName);
+		return 1;
+	}
+	world->AddToRoot();
+	world->WorldType = EWorldType::Editor;
+	if (!world->bIsWorldInitialized)
+	{
+		world->InitWorld(UWorld::InitializationValues().CreatePhysicsScene(false).ShouldSimulatePhysics(false).CreateNavigation(false).CreateAISystem(false).AllowAudioPlayback(false));
+	}
+	world->UpdateWorldComponents(true, false);
+
+	// Add the collision a foot trace would hit for every static floor, once per instance.
+	IKCore::TriangleSoup soup;
+	int32 numExported = 0, numSkipped = 0;
+	for (TActorIterator<AActor> it(world); it; ++it)
+	{
+		TInlineComponentArray<UPrimitiveComponent*> components(*it);
+		for (UPrimitiveComponent* component : components)
+		{
+			if (!IsStaticFloor(component)) continue;
+
+			TArray<FTransform> transforms;
+			UInstancedStaticMeshComponent* instancedComponent = Cast<UInstancedStaticMeshComponent>(component);
+			if (instancedComponent)
+			{
+				transforms.SetNum(instancedComponent->GetInstanceCount());
+				for (int32 i = 0; i < transforms.Num(); i++) instancedComponent->GetInstanceTransform(i, transforms[i], true);
+			}
+			else transforms.Add(component->GetComponentTransform());
+
+			// Foot traces hit simple collision, except on surfaces tagged for complex collision and bodies using complex as simple.
+			const UBodySetup* bodySetup = component->GetBodySetup();
+			bool useComplex = component->ComponentHasTag(FIKPhysicsFloorQuery::ComplexFloorTag) || (bodySetup && bodySetup->GetCollisionTraceFlag() == CTF_UseComplexAsSimple);
+			if (useComplex ? AddComplexCollision(component, transforms, soup) : (bodySetup && AddSimpleCollision(bodySetup, transforms, soup))) numExported++;
+			else
+			{
+				UE_LOG(LogIKFloorExport, Warning, TEXT("Skipped %s, it has no %s collision to export"), *component->GetPathName(), useComplex ? TEXT("complex") : TEXT("box or convex"));
+				numSkipped++;
+			}
+		}
+	}
+
+	// Save next to the content so it is staged with the game.
+	std::vector<uint8_t> data;
+	IKCore::WriteTriangleSoup(soup, data);
+	FString path = FIKBVHFloorQuery::GetPathForWorld(world);
+	bool saved = FFileHelper::SaveArrayToFile(TArrayView<const uint8>(data.data(), (int32)data.size()), *path);
+	world->RemoveFromRoot();
+	if (!saved)
+	{
+		UE_LOG(LogIKFloorExport, Error, TEXT("Could not write %s"), *path);
+		return 1;
+	}
+
+	UE_LOG(LogIKFloorExport, Display, TEXT("Exported %s: %d components, %d skipped, %d triangles, %d bytes"), *path, numExported, numSkipped, soup.NumTriangles(), (int32)data.size());
+	return 0;
+}
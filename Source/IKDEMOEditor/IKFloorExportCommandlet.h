@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "IKFloorExportCommandlet.generated.h"
+
+/* Exports the collision of a levels static floors as a triangle soup for the BVH floor query and ik_floorquery.
+ * Usage: UE4Editor-Cmd IKDEMO -run=IKFloorExport -Map=/Game/Maps/LVL_Demo */
+UCLASS()
+class UIKFloorExportCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Constructor. */
+	UIKFloorExportCommandlet();
+
+	/* Commandlet entry point. */
+	virtual int32 Main(const FString& Params) override;
+};
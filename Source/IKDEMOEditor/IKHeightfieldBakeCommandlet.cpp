@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "IKHeightfieldBakeCommandlet.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "IKFloorHeightfield.h"
+#include "IKFloorProxyComponent.h"
+#include "IKFloorQuery.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogIKHeightfieldBake, Log, All);
+
+/* The largest number of cells a heightfield can be baked with. */
+static const int64 MaxHeightfieldCells = 16 * 1024 * 1024;
+
+/* The gap left under a floor before tracing again for the next layer down. */
+static const float LayerGap = 1.0f;
+
+/* Returns true if the component is static geometry the foot traces would hit. */
+static bool IsStaticFloor(const UPrimitiveComponent* component)
+{
+	return component && component->Mobility == EComponentMobility::Static && component->IsCollisionEnabled() && component->GetCollisionResponseToChannel(COLLISION_IKFLOOR) == ECR_Block
+		&& !UIKFloorProxyComponent::IsReplacedByProxy(component);
+}
+
+UIKHeightfieldBakeCommandlet::UIKHeightfieldBakeCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UIKHeightfieldBakeCommandlet::Main(const FString& Params)
+{
+	TArray<FString> tokens, switches;
+	TMap<FString, FString> params;
+	ParseCommandLine(*Params, tokens, switches, params);
+
+	// Get the bake settings.
+	FString mapName = params.FindRef(TEXT("Map"));
+	float cellSize = params.Contains(TEXT("CellSize")) ? FCString::Atof(*params[TEXT("CellSize")]) : 5.0f;
+	float heightStep = params.Contains(TEXT("HeightStep")) ? FCString::Atof(*params[TEXT("HeightStep")]) : 0.5f;
+	int32 maxLayers = params.Contains(TEXT("MaxLayers")) ? FCString::Atoi(*params[TEXT("MaxLayers")]) : 4;
+	if (mapName.IsEmpty() || cellSize <= 0.0f || heightStep <= 0.0f || maxLayers <= 0)
+	{
+		UE_LOG(LogIKHeightfieldBake, Error, TEXT("Usage: -run=IKHeightfieldBake -Map=/Game/Maps/MapName [-CellSize=5] [-HeightStep=0.5] [-MaxLayers=4]"));
+		return 1;
+	}
+
+	// Load the map with a physics scene to trace against.
+	UPackage* package = LoadPackage(nullptr, *mapName, LOAD_None);
+	UWorld* world = package ? UWorld::FindWorldInPackage(package) : nullptr;
+	if (!world)
+	{
+		UE_LOG(LogIKHeightfieldBake, Error, TEXT("Could not load map %s"), *mapName);
+		return 1;
+	}
+	world->AddToRoot();
+	world->WorldType = EWorldType::Editor;
+	if (!world->bIsWorldInitialized)
+	{
+		world->InitWorld(UWorld::InitializationValues().CreatePhysicsScene(true).EnableTraceCollision(true).ShouldSimulatePhysics(false).CreateNavigation(false).CreateAISystem(false).AllowAudioPlayback(false));
+	}
+	world->UpdateWorldComponents(true, false);
+
+	// Find the area covered by static floors.
+	FBox bounds(ForceInit);
+	for (TActorIterator<AActor> it(world); it; ++it)
+	{
+		TInlineComponentArray<UPrimitiveComponent*> components(*it);
+		for (UPrimitiveComponent* component : components)
+		{
+			if (IsStaticFloor(component)) bounds += component->Bounds.GetBox();
+		}
+	}
+
+	// Setup the grid over the area.
+	FIKHeightfieldHeader header;
+	header.magic = FIKFloorHeightfield::Magic;
+	header.version = FIKFloorHeightfield::Version;
+	header.originX = bounds.Min.X;
+	header.originY = bounds.Min.Y;
+	header.originZ = bounds.Min.Z;
+	header.cellSize = cellSize;
+	header.heightStep = heightStep;
+	header.sizeX = FMath::Max(FMath::CeilToInt(bounds.GetSize().X / cellSize), 1);
+	header.sizeY = FMath::Max(FMath::CeilToInt(bounds.GetSize().Y / cellSize), 1);
+	header.numLayers = 1;
+	if (!bounds.IsValid || (int64)header.sizeX * header.sizeY > MaxHeightfieldCells)
+	{
+		UE_LOG(LogIKHeightfieldBake, Error, TEXT("%s has no static floors or is too big to bake with a cell size of %f"), *mapName, cellSize);
+		world->RemoveFromRoot();
+		return 1;
+	}
+	if (bounds.GetSize().Z / heightStep > MAX_int16)
+	{
+		UE_LOG(LogIKHeightfieldBake, Warning, TEXT("%s is too tall for a height step of %f, floors will be clamped"), *mapName, heightStep);
+	}
+
+	// Trace down through every cell centre the same way as the foot traces, recording each static floor hit as a layer.
+	FIKPhysicsFloorQuery floorQuery(world);
+	FCollisionQueryParams traceParams(SCENE_QUERY_STAT(IKHeightfieldBake), false);
+	traceParams.bReturnPhysicalMaterial = false;
+	TArray<TArray<FIKHeightfieldSample, TInlineAllocator<4>>> cells;
+	cells.SetNum(header.sizeX * header.sizeY);
+	for (int32 y = 0; y < header.sizeY; y++)
+	{
+		for (int32 x = 0; x < header.sizeX; x++)
+		{
+			TArray<FIKHeightfieldSample, TInlineAllocator<4>>& layers = cells[y * header.sizeX + x];
+			FVector start(header.originX + (x + 0.5f) * cellSize, header.originY + (y + 0.5f) * cellSize, bounds.Max.Z + LayerGap);
+			FVector end(start.X, start.Y, bounds.Min.Z - LayerGap);
+			FHitResult hit;
+			while (layers.Num() < maxLayers && floorQuery.SweepFloor(start, end, 0.0f, traceParams, hit))
+			{
+				if (IsStaticFloor(hit.GetComponent())) layers.Add(FIKFloorHeightfield::PackSample(header, hit.ImpactPoint.Z, hit.ImpactNormal));
+				start.Z = hit.ImpactPoint.Z - LayerGap;
+			}
+			header.numLayers = FMath::Max(header.numLayers, layers.Num());
+		}
+	}
+
+	// Flatten the cells with every cell padded out to the same number of layers.
+	FIKHeightfieldSample emptySample;
+	emptySample.height = FIKFloorHeightfield::EmptyHeight;
+	emptySample.normalX = 0;
+	emptySample.normalY = 0;
+	TArray<FIKHeightfieldSample> samples;
+	samples.Reserve(cells.Num() * header.numLayers);
+	for (const TArray<FIKHeightfieldSample, TInlineAllocator<4>>& layers : cells)
+	{
+		samples.Append(layers);
+		for (int32 i = layers.Num(); i < header.numLayers; i++) samples.Add(emptySample);
+	}
+
+	// Save next to the content so it is staged with the game.
+	FString path = FIKFloorHeightfield::GetPathForWorld(world);
+	bool saved = FIKFloorHeightfield::Save(path, header, samples);
+	world->RemoveFromRoot();
+	if (!saved)
+	{
+		UE_LOG(LogIKHeightfieldBake, Error, TEXT("Could not write %s"), *path);
+		return 1;
+	}
+
+	UE_LOG(LogIKHeightfieldBake, Display, TEXT("Baked %s: %dx%d cells, %d layers, %d bytes"), *path, header.sizeX, header.sizeY, header.numLayers, (int32)(sizeof(FIKHeightfieldHeader) + samples.Num() * sizeof(FIKHeightfieldSample)));
+	return 0;
+}
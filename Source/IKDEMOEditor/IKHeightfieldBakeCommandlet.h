@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "IKHeightfieldBakeCommandlet.generated.h"
+
+/* Bakes a levels static floors into a heightfield file for the IK foot traces.
+ * Usage: UE4Editor-Cmd IKDEMO -run=IKHeightfieldBake -Map=/Game/Maps/LVL_Demo [-CellSize=5] [-HeightStep=0.5] [-MaxLayers=4] */
+UCLASS()
+class UIKHeightfieldBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Constructor. */
+	UIKHeightfieldBakeCommandlet();
+
+	/* Commandlet entry point. */
+	virtual int32 Main(const FString& Params) override;
+};